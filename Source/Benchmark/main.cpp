@@ -0,0 +1,516 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <Windows.h>
+#else
+#include <x86intrin.h>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "NGCrypto.h"
+
+using namespace Cryptography;
+
+/**
+ * Benchmarks for every primitive of the library.
+ *
+ * Each case is calibrated to a batch of operations lasting at least SAMPLE_TIME, warmed up,
+ * then sampled batch by batch until the measuring time is over. Latency percentiles come from
+ * the per-operation time of each batch; cycles are read from the time stamp counter, which
+ * runs at the nominal frequency, so pin the process and disable turbo for comparable numbers.
+ *
+ * Usage: Benchmark [--filter text] [--cpu index] [--warmup ms] [--time ms] [--json file|-]
+ */
+namespace
+{
+    const double    SAMPLE_TIME     = 20e-6;
+    const uint64_t  MIN_SAMPLES     = 10;
+    const uint64_t  MAX_SAMPLES     = 100000;
+
+    using Clock = std::chrono::steady_clock;
+
+    struct Options
+    {
+        std::string filter;
+        std::string jsonPath;
+        int         cpu         = -1;
+        double      warmupTime  = 0.05;
+        double      measureTime = 0.3;
+    };
+
+    struct Result
+    {
+        std::string name;
+        uint64_t    bytes;
+        uint64_t    operations;
+        double      seconds;
+        double      cycles;
+        // Nanoseconds per operation, one entry per batch, sorted
+        std::vector<double> samples;
+
+        double OpsPerSecond() const     { return operations / seconds; }
+        double CyclesPerOp() const      { return cycles / operations; }
+        double Percentile(double p_fraction) const
+        {
+            return samples[std::min<size_t>(samples.size() - 1, static_cast<size_t>(p_fraction * samples.size()))];
+        }
+    };
+
+    // Results are folded in here so the optimizer cannot drop the measured work
+    volatile uint64_t g_sink = 0;
+
+    uint64_t ReadCycles()
+    {
+        return __rdtsc();
+    }
+
+    double Seconds(Clock::time_point p_begin, Clock::time_point p_end)
+    {
+        return std::chrono::duration<double>(p_end - p_begin).count();
+    }
+
+    bool PinToCpu(int p_cpu)
+    {
+#if defined(_MSC_VER)
+        return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << p_cpu) != 0;
+#else
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(p_cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+    }
+
+    class Suite
+    {
+    private:
+        Options             m_options;
+        std::vector<Result> m_results;
+        // Table output, stderr when the JSON report goes to stdout
+        FILE*               m_table;
+
+    public:
+        explicit Suite(const Options& p_options) :
+            m_options(p_options), m_table(p_options.jsonPath == "-" ? stderr : stdout) {}
+
+        bool IsSelected(const std::string& p_name) const
+        {
+            return m_options.filter.empty() || p_name.find(m_options.filter) != std::string::npos;
+        }
+
+        // p_bytes is the data processed by one call of p_operation, 0 for fixed size operations
+        template<typename Operation>
+        void Run(const std::string& p_name, uint64_t p_bytes, Operation p_operation)
+        {
+            if (!IsSelected(p_name))
+                return;
+
+            // Smallest power of two batch lasting a full sample
+            uint64_t batch = 1;
+            while (true)
+            {
+                const Clock::time_point begin = Clock::now();
+                for (uint64_t i = 0; i < batch; ++i)
+                    p_operation();
+                if (Seconds(begin, Clock::now()) >= SAMPLE_TIME || batch >= (uint64_t(1) << 30))
+                    break;
+                batch *= 2;
+            }
+
+            const Clock::time_point warmupBegin = Clock::now();
+            while (Seconds(warmupBegin, Clock::now()) < m_options.warmupTime)
+            {
+                for (uint64_t i = 0; i < batch; ++i)
+                    p_operation();
+            }
+
+            Result result {p_name, p_bytes, 0, 0.0, 0.0, {}};
+            while (result.samples.size() < MAX_SAMPLES &&
+                   (result.seconds < m_options.measureTime || result.samples.size() < MIN_SAMPLES))
+            {
+                const uint64_t cyclesBegin = ReadCycles();
+                const Clock::time_point begin = Clock::now();
+                for (uint64_t i = 0; i < batch; ++i)
+                    p_operation();
+                const Clock::time_point end = Clock::now();
+                const uint64_t cyclesEnd = ReadCycles();
+
+                const double seconds = Seconds(begin, end);
+                result.seconds += seconds;
+                result.cycles += static_cast<double>(cyclesEnd - cyclesBegin);
+                result.operations += batch;
+                result.samples.push_back(seconds * 1e9 / batch);
+            }
+            std::sort(result.samples.begin(), result.samples.end());
+
+            Print(result);
+            m_results.push_back(std::move(result));
+        }
+
+        void PrintHeader() const
+        {
+            fprintf(m_table, "%-36s %12s %12s %12s %12s %12s %10s %10s\n",
+                    "case", "ops/s", "p50 ns", "p90 ns", "p99 ns", "cycles/op", "cyc/byte", "MB/s");
+        }
+
+        void Print(const Result& p_result) const
+        {
+            fprintf(m_table, "%-36s %12.0f %12.1f %12.1f %12.1f %12.0f",
+                    p_result.name.c_str(), p_result.OpsPerSecond(), p_result.Percentile(0.5),
+                    p_result.Percentile(0.9), p_result.Percentile(0.99), p_result.CyclesPerOp());
+            if (p_result.bytes)
+                fprintf(m_table, " %10.2f %10.1f", p_result.CyclesPerOp() / p_result.bytes, p_result.OpsPerSecond() * p_result.bytes / 1e6);
+            fprintf(m_table, "\n");
+            fflush(m_table);
+        }
+
+        bool WriteJson() const
+        {
+            FILE* file = m_options.jsonPath == "-" ? stdout : fopen(m_options.jsonPath.c_str(), "w");
+            if (!file)
+                return false;
+
+            fprintf(file, "{\n  \"cpu\": %d,\n  \"results\": [\n", m_options.cpu);
+            for (size_t i = 0; i < m_results.size(); ++i)
+            {
+                const Result& result = m_results[i];
+                fprintf(file, "    {\"name\": \"%s\", \"bytes\": %llu, \"operations\": %llu, \"seconds\": %.6f, "
+                              "\"opsPerSecond\": %.3f, \"cyclesPerOp\": %.1f, \"cyclesPerByte\": %.4f, "
+                              "\"nsPerOp\": {\"min\": %.2f, \"p50\": %.2f, \"p90\": %.2f, \"p99\": %.2f, \"max\": %.2f}}%s\n",
+                        result.name.c_str(), static_cast<unsigned long long>(result.bytes),
+                        static_cast<unsigned long long>(result.operations), result.seconds,
+                        result.OpsPerSecond(), result.CyclesPerOp(), result.bytes ? result.CyclesPerOp() / result.bytes : 0.0,
+                        result.samples.front(), result.Percentile(0.5), result.Percentile(0.9), result.Percentile(0.99),
+                        result.samples.back(), i + 1 < m_results.size() ? "," : "");
+            }
+            fprintf(file, "  ]\n}\n");
+
+            if (file != stdout)
+                fclose(file);
+            return true;
+        }
+    };
+
+    std::string SizeName(uint64_t p_bytes)
+    {
+        if (p_bytes >= (1 << 20))
+            return std::to_string(p_bytes >> 20) + "MB";
+        if (p_bytes >= (1 << 10))
+            return std::to_string(p_bytes >> 10) + "KB";
+        return std::to_string(p_bytes) + "B";
+    }
+
+    std::vector<uint8_t> RandomBytes(uint64_t p_size)
+    {
+        std::vector<uint8_t> bytes(p_size);
+        Random::CtrDrbg::Fill(bytes.data(), p_size);
+        return bytes;
+    }
+
+    void BenchmarkAES(Suite& p_suite)
+    {
+        const std::vector<uint8_t> key = RandomBytes(32);
+        Encryption::AES aes(key.data());
+
+        // CBC is not covered, EncryptCBC and DecryptCBC are still empty
+        for (uint64_t size = 16; size <= (16 << 20); size *= 16)
+        {
+            std::vector<uint8_t> data = RandomBytes(size);
+            p_suite.Run("aes256/ecb/encrypt/" + SizeName(size), size, [&]
+            {
+                aes.EncryptECB(data.data(), data.data(), size);
+            });
+            p_suite.Run("aes256/ecb/decrypt/" + SizeName(size), size, [&]
+            {
+                aes.DecryptECB(data.data(), data.data(), size);
+            });
+            g_sink += data[0];
+        }
+
+        const std::vector<uint8_t> macKey = RandomBytes(32);
+        Encryption::EncryptThenMAC channel(key.data(), macKey.data());
+        for (uint64_t size : {64, 1024, 16384})
+        {
+            const std::vector<uint8_t> plaintext = RandomBytes(size);
+            std::vector<uint8_t> frame(Encryption::EncryptThenMAC::GetFrameSize(size));
+            std::vector<uint8_t> out(size);
+            const uint64_t frameLength = channel.Seal(frame.data(), plaintext.data(), size);
+
+            p_suite.Run("etm/seal/" + SizeName(size), size, [&]
+            {
+                g_sink += channel.Seal(frame.data(), plaintext.data(), size);
+            });
+            // Seal above left a valid frame behind
+            p_suite.Run("etm/open/" + SizeName(size), size, [&]
+            {
+                g_sink += channel.Open(out.data(), frame.data(), frameLength);
+            });
+        }
+    }
+
+    void BenchmarkHash(Suite& p_suite)
+    {
+        const std::vector<uint8_t> key = RandomBytes(32);
+        for (uint64_t size : {16, 64, 1024, 8192, 65536, 1 << 20})
+        {
+            const std::vector<uint8_t> data = RandomBytes(size);
+            p_suite.Run("sha256/" + SizeName(size), size, [&]
+            {
+                g_sink += Hash::SHA256().Hash(data.data(), size)[0];
+            });
+            p_suite.Run("hmac-sha256/" + SizeName(size), size, [&]
+            {
+                g_sink += Hash::HMAC::HMAC_SHA256(key.data(), key.size(), data.data(), size)[0];
+            });
+        }
+
+        // Sixteen independent messages per call, compare per byte with the single message cases
+        const uint32_t BATCH = 16;
+        for (uint64_t size : {16, 64, 1024})
+        {
+            const std::vector<uint8_t> data = RandomBytes(size * BATCH);
+            std::vector<uint8_t> digests(BATCH * Hash::SHA256::OUTPUT_SIZE);
+            std::vector<Hash::SHA256::HashRequest> hashRequests(BATCH);
+            std::vector<Hash::HMAC::Request> macRequests(BATCH);
+            for (uint32_t i = 0; i < BATCH; ++i)
+            {
+                hashRequests[i] = Hash::SHA256::HashRequest{&data[i * size], size, &digests[i * Hash::SHA256::OUTPUT_SIZE]};
+                macRequests[i] = Hash::HMAC::Request{key.data(), key.size(), &data[i * size], size, &digests[i * Hash::SHA256::OUTPUT_SIZE]};
+            }
+
+            p_suite.Run("sha256/batch16/" + SizeName(size), size * BATCH, [&]
+            {
+                Hash::SHA256::HashBatch(hashRequests.data(), BATCH);
+                g_sink += digests[0];
+            });
+            p_suite.Run("hmac-sha256/batch16/" + SizeName(size), size * BATCH, [&]
+            {
+                Hash::HMAC::HMAC_SHA256Batch(macRequests.data(), BATCH);
+                g_sink += digests[0];
+            });
+        }
+    }
+
+    // One operation submits JOB_COUNT jobs and waits for all of their completions
+    void BenchmarkAsync(Suite& p_suite)
+    {
+        static const uint32_t JOB_COUNT = 256;
+        const std::vector<uint8_t> key = RandomBytes(32);
+        Async::JobScheduler scheduler;
+
+        for (uint64_t size : {16, 64, 1024})
+        {
+            const std::vector<uint8_t> data = RandomBytes(size * JOB_COUNT);
+            std::vector<uint8_t> digests(JOB_COUNT * Hash::SHA256::OUTPUT_SIZE);
+            struct Completion
+            {
+                uint32_t                done = 0;
+                std::mutex              mutex;
+                std::condition_variable condition;
+            } completion;
+
+            // Completions run on the worker, the last one wakes the benchmark thread.
+            // A single captured pointer fits the small buffer of std::function, so submitting does not allocate
+            auto complete = [&completion]
+            {
+                std::lock_guard<std::mutex> lock(completion.mutex);
+                if (++completion.done == JOB_COUNT)
+                    completion.condition.notify_one();
+            };
+
+            auto run = [&](bool p_hmac)
+            {
+                completion.done = 0;
+                for (uint32_t i = 0; i < JOB_COUNT; ++i)
+                {
+                    uint8_t* digest = &digests[i * Hash::SHA256::OUTPUT_SIZE];
+                    const Async::Job job = p_hmac ? Async::Job::HMACSHA256(key.data(), key.size(), &data[i * size], size, digest)
+                                                  : Async::Job::SHA256(&data[i * size], size, digest);
+                    scheduler.Submit(job, complete);
+                }
+
+                std::unique_lock<std::mutex> lock(completion.mutex);
+                completion.condition.wait(lock, [&completion] { return completion.done == JOB_COUNT; });
+                g_sink += digests[0];
+            };
+
+            p_suite.Run("async/sha256/256x" + SizeName(size), size * JOB_COUNT, [&] { run(false); });
+            p_suite.Run("async/hmac-sha256/256x" + SizeName(size), size * JOB_COUNT, [&] { run(true); });
+        }
+    }
+
+    void BenchmarkNGMP(Suite& p_suite)
+    {
+        Random::CtrDrbg& drbg = Random::CtrDrbg::GetThreadInstance();
+        using Wide = NGMP<4096>;
+
+        for (unsigned int bits : {1024u, 2048u})
+        {
+            const std::string size = std::to_string(bits);
+            const std::vector<uint8_t> aBytes = RandomBytes(bits / 8);
+            const std::vector<uint8_t> bBytes = RandomBytes(bits / 8);
+            const Wide a = Wide::FromBigEndian(aBytes.data(), aBytes.size());
+            const Wide b = Wide::FromBigEndian(bBytes.data(), bBytes.size());
+            const Wide product = Wide(a * b);
+            Wide out;
+
+            p_suite.Run("ngmp/mul/" + size, 0, [&]
+            {
+                Wide::Mul(out, a, b);
+                g_sink += out.Get64BitArray()[0];
+            });
+            p_suite.Run("ngmp/div/" + std::to_string(bits * 2) + "by" + size, 0, [&]
+            {
+                g_sink += (product % b).Get64BitArray()[0];
+            });
+
+            // Odd modulus so both reductions apply
+            Wide modulus = b;
+            modulus.Get64BitArray()[0] |= 1;
+            const BarrettContext<4096> barrett(modulus);
+            const MontgomeryContext<4096> montgomery(modulus);
+            const Wide base = a % modulus;
+            const Wide exponent = Wide::Random(drbg) % modulus;
+
+            p_suite.Run("ngmp/powmod/barrett/" + size, 0, [&]
+            {
+                g_sink += Wide::PowMod(base, exponent, barrett).Get64BitArray()[0];
+            });
+            p_suite.Run("ngmp/powmod/montgomery/" + size, 0, [&]
+            {
+                g_sink += Wide::PowMod(base, exponent, montgomery).Get64BitArray()[0];
+            });
+        }
+    }
+
+    void BenchmarkKeyExchange(Suite& p_suite)
+    {
+        using namespace KeyExchange;
+
+        for (GroupId id : {GroupId::Modp2048, GroupId::Modp3072})
+        {
+            const DiffieHellmanGroup& group = DiffieHellmanGroup::Get(id);
+            const std::string size = std::to_string(group.GetBitCount());
+
+            PrivateKey privateKey;
+            PublicKey publicKey;
+            PrivateKey peerPrivate;
+            PublicKey peerPublic;
+            DiffieHellman::GenerateKeyPair(peerPrivate, peerPublic, group);
+
+            p_suite.Run("dh/keypair/" + size, 0, [&]
+            {
+                DiffieHellman::GenerateKeyPair(privateKey, publicKey, group);
+                g_sink += publicKey.Get64BitArray()[0];
+            });
+            p_suite.Run("dh/shared/" + size, 0, [&]
+            {
+                g_sink += DiffieHellman::GenerateSharedKey(peerPublic, privateKey, group).Get64BitArray()[0];
+            });
+        }
+
+        X25519::PrivateKey privateKey;
+        X25519::PublicKey publicKey;
+        X25519::PrivateKey peerPrivate;
+        X25519::PublicKey peerPublic;
+        X25519::GenerateKeyPair(peerPrivate, peerPublic);
+        p_suite.Run("x25519/keypair", 0, [&]
+        {
+            X25519::GenerateKeyPair(privateKey, publicKey);
+            g_sink += publicKey[0];
+        });
+        p_suite.Run("x25519/shared", 0, [&]
+        {
+            g_sink += X25519::GenerateSharedKey(peerPublic, privateKey)[0];
+        });
+    }
+
+    void BenchmarkSignature(Suite& p_suite)
+    {
+        const char* MESSAGE = "benchmark message";
+        for (uint32_t bits : {2048u, 3072u})
+        {
+            const std::string size = std::to_string(bits);
+            if (!p_suite.IsSelected("rsa/sign/" + size) && !p_suite.IsSelected("rsa/verify/" + size))
+                continue;
+
+            const Signature::RSAPrivateKey key = Signature::RSAPrivateKey::Generate(bits);
+            std::vector<uint8_t> signature(key.GetPublicKey().GetByteCount());
+            p_suite.Run("rsa/sign/" + size, 0, [&]
+            {
+                key.SignSHA256(reinterpret_cast<const uint8_t*>(MESSAGE), strlen(MESSAGE), signature.data());
+            });
+            p_suite.Run("rsa/verify/" + size, 0, [&]
+            {
+                g_sink += key.GetPublicKey().VerifySHA256(reinterpret_cast<const uint8_t*>(MESSAGE), strlen(MESSAGE), signature.data());
+            });
+        }
+    }
+
+    bool ParseOptions(int p_argc, char** p_argv, Options& p_options)
+    {
+        for (int i = 1; i < p_argc; ++i)
+        {
+            const std::string argument = p_argv[i];
+            if (i + 1 >= p_argc)
+                return false;
+
+            const char* value = p_argv[++i];
+            if (argument == "--filter")
+                p_options.filter = value;
+            else if (argument == "--cpu")
+                p_options.cpu = atoi(value);
+            else if (argument == "--warmup")
+                p_options.warmupTime = atof(value) / 1000;
+            else if (argument == "--time")
+                p_options.measureTime = atof(value) / 1000;
+            else if (argument == "--json")
+                p_options.jsonPath = value;
+            else
+                return false;
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        fprintf(stderr, "Usage: %s [--filter text] [--cpu index] [--warmup ms] [--time ms] [--json file|-]\n", argv[0]);
+        return 2;
+    }
+
+    if (options.cpu >= 0 && !PinToCpu(options.cpu))
+    {
+        fprintf(stderr, "Could not pin to cpu %d\n", options.cpu);
+        return 1;
+    }
+
+    Suite suite(options);
+    suite.PrintHeader();
+    BenchmarkAES(suite);
+    BenchmarkHash(suite);
+    BenchmarkAsync(suite);
+    BenchmarkNGMP(suite);
+    BenchmarkKeyExchange(suite);
+    BenchmarkSignature(suite);
+
+    if (!options.jsonPath.empty() && !suite.WriteJson())
+    {
+        fprintf(stderr, "Could not write %s\n", options.jsonPath.c_str());
+        return 1;
+    }
+    return 0;
+}
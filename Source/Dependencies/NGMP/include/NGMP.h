@@ -2,10 +2,32 @@
 #include <cstdint>
 #include <ostream>
 #include <initializer_list>
-#include <corecrt_memcpy_s.h>
+#include <cstring>
 #include <random>
 #include <cassert>
 #include <sstream>
+#include <stdexcept>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <functional>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+template<unsigned int ModBitCount>
+class BarrettContext;
+template<unsigned int ModBitCount>
+class MontgomeryContext;
+template<unsigned int BitCount>
+class PrimeSieve;
+template<unsigned int BitCount>
+class NGMPView;
+template<unsigned int BitCount>
+class NGMPProduct;
 
 template<unsigned int BitCount>
 class NGMP
@@ -13,32 +35,93 @@ class NGMP
     static_assert(BitCount % 64 == 0, "Only multiples of 64 are supported");
     template<unsigned int OtherBitCount>
     friend class NGMP;
+    template<unsigned int ModBitCount>
+    friend class BarrettContext;
+    template<unsigned int ModBitCount>
+    friend class MontgomeryContext;
+    template<unsigned int OtherBitCount>
+    friend class PrimeSieve;
+    template<unsigned int OtherBitCount>
+    friend class NGMPView;
 
 private:
     static const unsigned int MAX_LIMB_COUNT = BitCount / 64;
     uint64_t number[MAX_LIMB_COUNT] = {0};
 
+#pragma region Limb Operations
+    // a + b + carry, returns carry out
+    static uint8_t AddCarry(uint8_t carry, uint64_t a, uint64_t b, uint64_t& out);
+    // a - b - borrow, returns borrow out
+    static uint8_t SubBorrow(uint8_t borrow, uint64_t a, uint64_t b, uint64_t& out);
+    // Full 64x64 -> 128 bit product, returns low limb and stores high limb
+    static uint64_t MulLimb(uint64_t a, uint64_t b, uint64_t& high);
+    // 128/64 -> 64 bit division, requires high < divisor so the quotient fits a limb
+    static uint64_t DivLimb(uint64_t high, uint64_t low, uint64_t divisor, uint64_t& remainder);
+    // value must not be zero
+    static unsigned int CountLeadingZeros(uint64_t value);
+    // value must not be zero
+    static unsigned int CountTrailingZeros(uint64_t value);
+    // Schoolbook product, out must hold aSize + bSize limbs
+    static void MulLimbs(const uint64_t* a, unsigned int aSize, const uint64_t* b, unsigned int bSize, uint64_t* out);
+    // Adds a * b into a MAX_LIMB_COUNT limbs accumulator, truncated to BitCount
+    static void MulAccumulate(uint64_t* accumulator, const NGMP& a, const NGMP& b);
+    // Shifts a non-zero value right past its trailing zero bits and shrinks size to the used limbs, returns the shift
+    static uint64_t StripTrailingZeros(uint64_t* a, unsigned int& size);
+    // Reads 8 big-endian bytes at any alignment, a single load and byte swap
+    static uint64_t LoadBigEndian(const uint8_t* bytes);
+    // Writes value as 8 big-endian bytes at any alignment
+    static void StoreBigEndian(uint64_t value, uint8_t* bytes);
+#pragma endregion
+
+#pragma region Radix Conversion
+    // 10^19, the largest power of ten in a limb
+    static const uint64_t DECIMAL_CHUNK         = 10000000000000000000ull;
+    static const unsigned int DECIMAL_CHUNK_DIGITS = 19;
+    // Values above this many limbs are split before chunked conversion
+    static const unsigned int DECIMAL_BASE_LIMBS = 16;
+
+    // 10^(19 * 2^k) for every k whose square still fits, computed once per instantiation
+    static const NGMP* GetDecimalPowers(unsigned int& count);
+
+    /**
+     * \brief Writes value right to left ending before end, at least minDigits digits
+     * \return first written character
+     */
+    static char* WriteDecimal(const NGMP& value, char* end, uint64_t minDigits);
+#pragma endregion
+
 public:
 
 #pragma region Constructors & Assignments
     NGMP()   = default;
     ~NGMP()  = default;
-    NGMP(const uint64_t value);
-    NGMP(const uint64_t array[], unsigned int size);
-    NGMP(const uint32_t array[], unsigned int size);
+    constexpr NGMP(const uint64_t value);
+    // Limbs are read least significant first
+    constexpr NGMP(const uint64_t array[], unsigned int size);
+    // Words are read most significant first
+    constexpr NGMP(const uint32_t array[], unsigned int size);
 
-    NGMP(std::initializer_list<uint64_t> list);
-    NGMP(std::initializer_list<uint32_t> list);
-    NGMP(const NGMP<BitCount>& other);
+    constexpr NGMP(std::initializer_list<uint64_t> list);
+    constexpr NGMP(std::initializer_list<uint32_t> list);
+    constexpr NGMP(const NGMP<BitCount>& other);
 
     template<unsigned int OtherBitCount>
-    NGMP(const NGMP<OtherBitCount>& other);
+    constexpr NGMP(const NGMP<OtherBitCount>& other);
+    NGMP(const NGMPProduct<BitCount>& product);
 
     NGMP& operator=(const NGMP<BitCount>& other);
+    NGMP& operator=(const NGMPProduct<BitCount>& product);
     template<unsigned int OtherBitCount>
     NGMP& operator=(const NGMP<BitCount>& other);
 
+    // Draws every limb from std::random_device (OS entropy), slow but safe without a generator
     static NGMP<BitCount> Random();
+    // Fills the value from p_generator.Generate(uint8_t* out, uint64_t size), e.g. a per-thread DRBG
+    template<typename Generator>
+    static NGMP<BitCount> Random(Generator& p_generator);
+
+    // Zeroes every limb, the stores are never dropped as dead, for values holding secrets
+    void Wipe();
 #pragma endregion 
 
 #pragma region Comparison operators
@@ -55,8 +138,11 @@ public:
     NGMP<BitCount>& LeftShift(uint64_t value = 1);
     NGMP<BitCount>& RightShift(uint64_t value = 1);
 
+    bool         TestBit(uint64_t index) const;
     uint64_t     FindHighestBit() const;
-    unsigned int FindUsedLimbCount() const;
+    // Number of zero bits below the lowest set bit, 0 for a zero value
+    uint64_t     CountTrailingZeroBits() const;
+    constexpr unsigned int FindUsedLimbCount() const;
 
     NGMP operator~() const;
     NGMP& operator~();
@@ -64,38 +150,62 @@ public:
 
 #pragma region Arithmetic Operations
     NGMP operator+(const uint64_t other) const;
-    NGMP operator+(const NGMP other) const;
+    NGMP operator+(const NGMP& other) const;
     NGMP& operator+=(const uint64_t other);
-    NGMP& operator+=(const NGMP other);
+    NGMP& operator+=(const NGMP& other);
 
 
     NGMP operator-(const uint64_t other) const;
-    //Using 2s complement for BigInt subtraction
     NGMP operator-(const NGMP& other) const;
     NGMP& operator-=(const NGMP& other);
 
-    //Binary (peasant) multiplication 
-    NGMP LongMultiplication(NGMP b) const;
-    NGMP& LongMultiplication(NGMP b);
-    NGMP Karatsuba(NGMP b) const;
-    NGMP operator*(NGMP b) const;
-    NGMP& operator*=(NGMP b);
+    //Schoolbook limb multiplication over used limbs, truncated to BitCount
+    NGMP LongMultiplication(const NGMP& b) const;
+    NGMP& LongMultiplication(const NGMP& b);
+    NGMP Karatsuba(const NGMP& b) const;
+    //Returns a lazy product so a * b + c is evaluated in a single pass, do not store it with auto
+    NGMPProduct<BitCount> operator*(const NGMP& b) const;
+    NGMP& operator*=(const NGMP& b);
 
+    /**
+     * \brief Multi-limb long division (Knuth Algorithm D)
+     * \tparam OtherBitCount size of divisor in bits
+     * \tparam Remainder size of remainder in bits
+     * \param b divisor
+     * \param r receives instance % b
+     * \return instance / b
+     */
     template<unsigned int OtherBitCount, unsigned int Remainder>
     NGMP<BitCount> Divide(const NGMP<OtherBitCount>& b, NGMP<Remainder>& r) const;
 
     template<unsigned int OtherBitCount>
-    NGMP<BitCount> operator/(NGMP<OtherBitCount> b) const;
+    NGMP<BitCount> operator/(const NGMP<OtherBitCount>& b) const;
     template<unsigned int OtherBitCount>
-    NGMP<BitCount>& operator/=(NGMP<OtherBitCount> b);
+    NGMP<BitCount>& operator/=(const NGMP<OtherBitCount>& b);
 
     template<unsigned int OtherBitCount>
-    NGMP<BitCount> operator%(NGMP<OtherBitCount> b) const;
+    NGMP<BitCount> operator%(const NGMP<OtherBitCount>& b) const;
     template<unsigned int OtherBitCount>
-    NGMP<BitCount>& operator%=(NGMP<OtherBitCount> b);
+    NGMP<BitCount>& operator%=(const NGMP<OtherBitCount>& b);
+
+    /**
+     * \brief Remainder by a single limb, one short division pass
+     * \param divisor non-zero divisor
+     * \return instance % divisor
+     */
+    uint64_t ModLimb(uint64_t divisor) const;
 
     NGMP Power(uint64_t power) const;
-    NGMP Power(NGMP power) const;
+    NGMP Power(const NGMP& power) const;
+#pragma  endregion 
+
+#pragma region Three-address kernels
+    // Output may alias any operand, results are truncated to BitCount
+    static void Add(NGMP& out, const NGMP& a, const NGMP& b);
+    static void Sub(NGMP& out, const NGMP& a, const NGMP& b);
+    static void Mul(NGMP& out, const NGMP& a, const NGMP& b);
+    // out = a * b + c without an intermediate product
+    static void MulAdd(NGMP& out, const NGMP& a, const NGMP& b, const NGMP& c);
 #pragma  endregion 
 
 #pragma region Modular Arithmetic
@@ -110,7 +220,7 @@ public:
      * \return ref to instance
      */
     template<unsigned int OtherBitCount, unsigned int ModBitCount>
-    NGMP& MulMod(NGMP<OtherBitCount> b, const NGMP<ModBitCount>& mod);
+    NGMP& MulMod(const NGMP<OtherBitCount>& b, const NGMP<ModBitCount>& mod);
     /**
      * \brief Modular multiplication
      * \tparam OtherBitCount size of B in bits
@@ -120,7 +230,7 @@ public:
      * \return instance * b % mod
      */
     template<unsigned int OtherBitCount, unsigned int ModBitCount>
-    NGMP MulMod(NGMP<OtherBitCount> b, const NGMP<ModBitCount>& mod) const;
+    NGMP MulMod(const NGMP<OtherBitCount>& b, const NGMP<ModBitCount>& mod) const;
 
     /**
      * \brief Modular multiplication
@@ -132,7 +242,50 @@ public:
      * \return a * b % mod
      */
     template<unsigned int OtherBitCount, unsigned int ModBitCount>
-    static NGMP MulMod(NGMP<BitCount> a, NGMP<OtherBitCount> b, const NGMP<ModBitCount>& mod);
+    static NGMP MulMod(NGMP<BitCount> a, const NGMP<OtherBitCount>& b, const NGMP<ModBitCount>& mod);
+
+    /**
+     * \brief Modular multiplication using Barrett reduction
+     * \tparam OtherBitCount size of B in bits
+     * \tparam ModBitCount size of modulus in bits
+     * \param b value multiplied by instance, must not be wider than the modulus
+     * \param context precomputed reduction context of the modulus
+     * \return ref to instance
+     */
+    template<unsigned int OtherBitCount, unsigned int ModBitCount>
+    NGMP& MulMod(const NGMP<OtherBitCount>& b, const BarrettContext<ModBitCount>& context);
+    /**
+     * \brief Modular multiplication using Barrett reduction
+     * \tparam OtherBitCount size of B in bits
+     * \tparam ModBitCount size of modulus in bits
+     * \param b value multiplied by instance, must not be wider than the modulus
+     * \param context precomputed reduction context of the modulus
+     * \return instance * b % modulus
+     */
+    template<unsigned int OtherBitCount, unsigned int ModBitCount>
+    NGMP MulMod(const NGMP<OtherBitCount>& b, const BarrettContext<ModBitCount>& context) const;
+    /**
+     * \brief Modular multiplication using Barrett reduction
+     * \tparam OtherBitCount size of B in bits
+     * \tparam ModBitCount size of modulus in bits
+     * \param a value multiplied by b, must not be wider than the modulus
+     * \param b value multiplied by a, must not be wider than the modulus
+     * \param context precomputed reduction context of the modulus
+     * \return a * b % modulus
+     */
+    template<unsigned int OtherBitCount, unsigned int ModBitCount>
+    static NGMP MulMod(const NGMP<BitCount>& a, const NGMP<OtherBitCount>& b, const BarrettContext<ModBitCount>& context);
+    /**
+     * \brief Three-address modular multiplication using Barrett reduction
+     * \tparam OtherBitCount size of B in bits
+     * \tparam ModBitCount size of modulus in bits
+     * \param out receives a * b % modulus, may alias a or b
+     * \param a value multiplied by b, must not be wider than the modulus
+     * \param b value multiplied by a, must not be wider than the modulus
+     * \param context precomputed reduction context of the modulus
+     */
+    template<unsigned int OtherBitCount, unsigned int ModBitCount>
+    static void MulMod(NGMP<BitCount>& out, const NGMP<BitCount>& a, const NGMP<OtherBitCount>& b, const BarrettContext<ModBitCount>& context);
     #pragma  endregion 
 
     #pragma region Exponentiation
@@ -145,7 +298,7 @@ public:
      * \return ref to instance
      */
     template<unsigned int OtherBitCount, unsigned int ModBitCount>
-    NGMP& PowMod(NGMP<OtherBitCount> b, const NGMP<ModBitCount>& mod);
+    NGMP& PowMod(const NGMP<OtherBitCount>& b, const NGMP<ModBitCount>& mod);
     /**
      * \brief Modular exponentiation
      * \tparam OtherBitCount size of B in bits
@@ -155,7 +308,7 @@ public:
      * \return instance ^ b % mod
      */
     template<unsigned int OtherBitCount, unsigned int ModBitCount>
-    NGMP PowMod(NGMP<OtherBitCount> b, const NGMP<ModBitCount>& mod) const;
+    NGMP PowMod(const NGMP<OtherBitCount>& b, const NGMP<ModBitCount>& mod) const;
 
     /**
      * \brief Modular exponentiation
@@ -167,18 +320,186 @@ public:
      * \return a ^ b % mod
      */
     template<unsigned int OtherBitCount, unsigned int ModBitCount>
-    static NGMP PowMod(NGMP<BitCount> a, NGMP<OtherBitCount> b, const NGMP<ModBitCount>& mod);
+    static NGMP PowMod(NGMP<BitCount> a, const NGMP<OtherBitCount>& b, const NGMP<ModBitCount>& mod);
+
+    /**
+     * \brief Modular exponentiation using Barrett reduction
+     * \tparam OtherBitCount size of B in bits
+     * \tparam ModBitCount size of modulus in bits
+     * \param a base
+     * \param b exponent
+     * \param context precomputed reduction context of the modulus
+     * \return a ^ b % modulus
+     */
+    template<unsigned int OtherBitCount, unsigned int ModBitCount>
+    static NGMP PowMod(const NGMP<BitCount>& a, const NGMP<OtherBitCount>& b, const BarrettContext<ModBitCount>& context);
+
+    /**
+     * \brief Modular exponentiation in Montgomery form with fixed 4-bit windows
+     * \tparam OtherBitCount size of B in bits
+     * \tparam ModBitCount size of modulus in bits
+     * \param a base
+     * \param b exponent
+     * \param context precomputed Montgomery context of the odd modulus
+     * \return a ^ b % modulus
+     *
+     * Every window costs four squarings and one multiplication, and the table entry is
+     * selected by reading all of them, so timing depends on the bit length of b only.
+     */
+    template<unsigned int OtherBitCount, unsigned int ModBitCount>
+    static NGMP PowMod(const NGMP<BitCount>& a, const NGMP<OtherBitCount>& b, const MontgomeryContext<ModBitCount>& context);
+    /**
+     * \brief Modular exponentiation in Montgomery form over a fixed number of exponent bits
+     * \tparam OtherBitCount size of B in bits
+     * \tparam ModBitCount size of modulus in bits
+     * \param a base
+     * \param b exponent, below 2^exponentBits
+     * \param exponentBits number of bits of b processed, at most OtherBitCount
+     * \param context precomputed Montgomery context of the odd modulus
+     * \return a ^ b % modulus
+     *
+     * Same ladder as above with the window count taken from exponentBits instead of b,
+     * so the running time does not depend on the exponent at all. Use it for secret exponents.
+     */
+    template<unsigned int OtherBitCount, unsigned int ModBitCount>
+    static NGMP PowMod(const NGMP<BitCount>& a, const NGMP<OtherBitCount>& b, uint64_t exponentBits, const MontgomeryContext<ModBitCount>& context);
+    #pragma  endregion 
+
+    #pragma region Number Theory
+    /**
+     * \brief Jacobi symbol computed with the binary algorithm, shifts and subtractions only
+     * \tparam ModBitCount size of n in bits
+     * \param n odd modulus
+     * \return (this / n), -1, 0 or 1
+     */
+    template<unsigned int ModBitCount>
+    int Jacobi(const NGMP<ModBitCount>& n) const;
+
+    /**
+     * \brief Modular inverse by binary extended Euclid, running time depends on the values
+     * \tparam ModBitCount size of n in bits
+     * \param n modulus, even moduli cost an extra inversion modulo the instance
+     * \return x < n with instance * x = 1 mod n, 0 when gcd(instance, n) != 1
+     */
+    template<unsigned int ModBitCount>
+    NGMP<ModBitCount> ModInverse(const NGMP<ModBitCount>& n) const;
+
+    /**
+     * \brief Modular inverse whose operation sequence only depends on the bit length of n
+     * \tparam ModBitCount size of n in bits
+     * \param n odd modulus
+     * \return x < n with instance * x = 1 mod n, 0 when gcd(instance, n) != 1
+     *
+     * For secret values such as RSA primes. The instance must be below n.
+     */
+    template<unsigned int ModBitCount>
+    NGMP<ModBitCount> ModInverseConstantTime(const NGMP<ModBitCount>& n) const;
+
+    /**
+     * \brief Inverts count values with a single ModInverse and 3 * (count - 1) modular multiplications (Montgomery's trick)
+     * \tparam ModBitCount size of modulus in bits
+     * \param values values below the modulus, replaced by their inverses
+     * \param context Barrett context of the modulus
+     * \return false, leaving values untouched, when any value is not invertible
+     */
+    template<unsigned int ModBitCount>
+    static bool BatchModInverse(NGMP* values, uint64_t count, const BarrettContext<ModBitCount>& context);
+
+    /**
+     * \brief Probable prime test, trial division by small primes followed by Miller-Rabin
+     * \tparam Generator random source for the bases, anything with Generate(uint8_t*, uint64_t)
+     * \param rounds Miller-Rabin rounds, a composite passes each one with probability at most 1/4
+     */
+    template<typename Generator>
+    bool IsProbablePrime(unsigned int rounds, Generator& generator) const;
+
+    /**
+     * \brief Miller-Rabin rounds only, for odd candidates above 3 that already went through a sieve
+     * \tparam Generator random source for the bases, anything with Generate(uint8_t*, uint64_t)
+     * \param rounds number of random bases tried
+     */
+    template<typename Generator>
+    bool MillerRabin(unsigned int rounds, Generator& generator) const;
+
+    /**
+     * \brief Random prime of exactly bitCount bits, with its two top bits set
+     * \tparam Generator random source, anything with Generate(uint8_t*, uint64_t)
+     * \param out receives the prime
+     * \param bitCount size of the prime, from 32 to BitCount
+     * \param safe when true out = 2q + 1 with q prime as well
+     * \param rounds Miller-Rabin rounds passed by every returned prime (and by q)
+     * \param cancelled polled between candidates, the search gives up once it returns true
+     * \return false when cancelled, out is then left untouched
+     *
+     * Starts at a random point and walks through the survivors of a PrimeSieve, so only a few
+     * percent of the candidates pay for a Miller-Rabin round.
+     */
+    template<typename Generator>
+    static bool GeneratePrime(NGMP& out, unsigned int bitCount, Generator& generator, bool safe = false,
+                              unsigned int rounds = 32, const std::function<bool()>& cancelled = nullptr);
     #pragma  endregion 
 #pragma  endregion 
 
+#pragma region Encoding
+    /**
+     * \brief Reads a big-endian unsigned integer of any length (OS2IP)
+     * \param bytes most significant byte first
+     * \param size byte count, may exceed BitCount / 8 when the extra leading bytes are zero
+     * \return decoded value, throws std::overflow_error when it does not fit BitCount bits
+     */
+    static NGMP FromBigEndian(const uint8_t* bytes, uint64_t size);
+
+    /**
+     * \brief Writes the value as exactly size big-endian bytes, zero padded on the left (I2OSP)
+     * \param bytes receives size bytes
+     * \param size output length, throws std::overflow_error when the value needs more bytes
+     */
+    void ToBigEndian(uint8_t* bytes, uint64_t size) const;
+
+    // Upper bounds on the digit count of any value, without the terminating null
+    static const unsigned int MAX_HEX_DIGITS        = BitCount / 4;
+    static const unsigned int MAX_DECIMAL_DIGITS    = BitCount * 1233 / 4096 + 1;
+
+    /**
+     * \brief Uppercase hexadecimal digits without leading zeros, "0" for zero, null terminated
+     * \param buffer receives the digits
+     * \param size buffer size, MAX_HEX_DIGITS + 1 always suffices
+     * \return digit count, 0 when the buffer is too small
+     */
+    uint64_t ToHex(char* buffer, uint64_t size) const;
+
+    /**
+     * \brief Decimal digits without leading zeros, "0" for zero, null terminated
+     * \param buffer receives the digits
+     * \param size buffer size, MAX_DECIMAL_DIGITS + 1 always suffices
+     * \return digit count, 0 when the buffer is too small
+     *
+     * Values up to DECIMAL_BASE_LIMBS limbs are split into 19-digit chunks by short division
+     * with 10^19. Larger values are split in halves by 10^(19 * 2^k) and converted recursively.
+     */
+    uint64_t ToDecimal(char* buffer, uint64_t size) const;
+
+    /**
+     * \brief Parses hexadecimal digits, either case, no prefix
+     * \param length character count, leading zeros allowed
+     * \return false, leaving out untouched, on an empty string, a non-hex character or overflow
+     */
+    static bool FromHex(const char* text, uint64_t length, NGMP& out);
+
+    /**
+     * \brief Parses decimal digits, 19 at a time
+     * \param length character count, leading zeros allowed
+     * \return false, leaving out untouched, on an empty string, a non-digit character or overflow
+     */
+    static bool FromDecimal(const char* text, uint64_t length, NGMP& out);
+#pragma endregion
+
 #pragma region Utils
 
     //TODO Add casts to uint types
 
-    uint64_t NumberOfDigits() const
-    {
-        return 1 + FindHighestBit() * log10(2);
-    }
+    // Exact count of decimal digits, 1 for zero
+    uint64_t NumberOfDigits() const;
 
     friend std::ostream& operator<<(std::ostream& os, const NGMP<BitCount>& p_bigUInt)
     {
@@ -207,13 +528,25 @@ public:
     {
         return number;
     }
+
+    const uint64_t* Get64BitArray() const
+    {
+        return number;
+    }
 #pragma endregion
 };
 
 
 
+#include "NGMP_limb.hxx"
 #include "NGMP_ctor_assign.hxx"
 #include "NGMP_comp.hxx"
 #include "NGMP_bitwise.hxx"
 #include "NGMP_arithmetic.hxx"
+#include "NGMP_expression.hxx"
+#include "NGMP_barrett.hxx"
+#include "NGMP_montgomery.hxx"
 #include "NGMP_mod_arithmetic.hxx"
+#include "NGMP_prime.hxx"
+#include "NGMP_encoding.hxx"
+#include "NGMP_resumable.hxx"
@@ -5,58 +5,44 @@ template <unsigned BitCount>
 NGMP<BitCount> NGMP<BitCount>::operator+(const uint64_t other) const
 {
     NGMP<BitCount> res(*this);
-    res.number[0] = number[0] + other;
-    //Propagate overflow
-    for (int i = 0; res.number[i] < number[i] || res.number[i] < other && i < MAX_LIMB_COUNT - 1; ++i)
-    {
-        res.number[i + 1] = number[i + 1] + 1;
-    }
+    res += other;
     return res;
 }
 
 template <unsigned BitCount>
-NGMP<BitCount> NGMP<BitCount>::operator+(const NGMP other) const
+NGMP<BitCount> NGMP<BitCount>::operator+(const NGMP& other) const
 {
     NGMP<BitCount> res;
-    uint8_t overflow = 0;
-    for (int i = 0; i < MAX_LIMB_COUNT; ++i)
-    {
-        res.number[i] = number[i] + other.number[i] + overflow;
-        overflow = 0;
-        if (res.number[i] < number[i] || res.number[i] < other.number[i])
-            overflow = 1;
-    }
+    const unsigned int usedLimbs = std::max(FindUsedLimbCount(), other.FindUsedLimbCount());
+    uint8_t carry = 0;
+    for (unsigned int i = 0; i < usedLimbs; ++i)
+        carry = AddCarry(carry, number[i], other.number[i], res.number[i]);
+    if (usedLimbs < MAX_LIMB_COUNT)
+        res.number[usedLimbs] = carry;
     return res;
 }
 
 template <unsigned BitCount>
 NGMP<BitCount>& NGMP<BitCount>::operator+=(const uint64_t other)
 {
-    uint64_t add = number[0] + other;
+    uint8_t carry = AddCarry(0, number[0], other, number[0]);
     //Propagate overflow
-    int i;
-    for (i = 0; add < number[i] || add < other && i < MAX_LIMB_COUNT - 1; ++i)
-    {
-        number[i] = add;
-        add = number[i + 1] + 1;
-    }
-    number[i] = add;
+    for (unsigned int i = 1; carry && i < MAX_LIMB_COUNT; ++i)
+        carry = AddCarry(carry, number[i], 0, number[i]);
     return *this;
 }
 
 template <unsigned BitCount>
-NGMP<BitCount>& NGMP<BitCount>::operator+=(const NGMP other)
+NGMP<BitCount>& NGMP<BitCount>::operator+=(const NGMP& other)
 {
-    uint8_t overflow = 0;
-    for (int i = 0; i < MAX_LIMB_COUNT; ++i)
-    {
-        uint64_t add = number[i] + other.number[i] + overflow;
-        overflow = 0;
-        if (add < number[i] || add < other.number[i])
-            overflow = 1;
-
-        number[i] = add;
-    }
+    const unsigned int otherUsedLimbs = other.FindUsedLimbCount();
+    uint8_t carry = 0;
+    unsigned int i = 0;
+    for (; i < otherUsedLimbs; ++i)
+        carry = AddCarry(carry, number[i], other.number[i], number[i]);
+    //Propagate overflow
+    for (; carry && i < MAX_LIMB_COUNT; ++i)
+        carry = AddCarry(carry, number[i], 0, number[i]);
     return *this;
 }
 
@@ -66,85 +52,55 @@ NGMP<BitCount>& NGMP<BitCount>::operator+=(const NGMP other)
 template <unsigned BitCount>
 NGMP<BitCount> NGMP<BitCount>::operator-(const uint64_t other) const
 {
-    if (other == 0)
-        return *this;
-    NGMP<BitCount> result = *this;
-    result.number[0] -= other;
+    NGMP<BitCount> result(*this);
+    uint8_t borrow = SubBorrow(0, result.number[0], other, result.number[0]);
+    for (unsigned int i = 1; borrow && i < MAX_LIMB_COUNT; ++i)
+        borrow = SubBorrow(borrow, result.number[i], 0, result.number[i]);
     return result;
 }
 
 template <unsigned BitCount>
 NGMP<BitCount> NGMP<BitCount>::operator-(const NGMP& other) const
 {
-    if (other.IsZero())
-        return *this;
-    NGMP<BitCount> invertOther = ~other;
-    invertOther += 1;
-    return *this + invertOther;
+    NGMP<BitCount> result(*this);
+    result -= other;
+    return result;
 }
 
 template <unsigned BitCount>
 NGMP<BitCount>& NGMP<BitCount>::operator-=(const NGMP& other)
 {
-    if (other.IsZero())
-        return *this;
-    NGMP<BitCount> invertOther = ~other;
-    invertOther += 1;
-    *this += invertOther;
+    const unsigned int otherUsedLimbs = other.FindUsedLimbCount();
+    uint8_t borrow = 0;
+    unsigned int i = 0;
+    for (; i < otherUsedLimbs; ++i)
+        borrow = SubBorrow(borrow, number[i], other.number[i], number[i]);
+    //Propagate underflow
+    for (; borrow && i < MAX_LIMB_COUNT; ++i)
+        borrow = SubBorrow(borrow, number[i], 0, number[i]);
     return *this;
 }
 #pragma endregion 
 
 #pragma region Multiplication
 template <unsigned BitCount>
-NGMP<BitCount> NGMP<BitCount>::LongMultiplication(NGMP b) const
+NGMP<BitCount> NGMP<BitCount>::LongMultiplication(const NGMP& b) const
 {
-    if (b.IsZero())
-        return b;
-
-    NGMP<BitCount> a = *this;
     NGMP<BitCount> result;
-
-    while (!a.IsZero())
-    {
-        if (a.IsOdd())
-            result += b;
-
-        a.RightShift();
-        b.LeftShift();
-    }
-
+    Mul(result, *this, b);
     return result;
 }
 
 template <unsigned BitCount>
-NGMP<BitCount>& NGMP<BitCount>::LongMultiplication(NGMP b)
+NGMP<BitCount>& NGMP<BitCount>::LongMultiplication(const NGMP& b)
 {
-    if (b.IsZero())
-    {
-        memset(number, 0, BitCount / 8);
-        return *this;
-    }
-
-    NGMP<BitCount> a = *this;
-    NGMP<BitCount> result;
-
-    while (!a.IsZero())
-    {
-        if (a.IsOdd())
-            result += b;
-
-        a.RightShift();
-        b.LeftShift();
-    }
-
-    *this = result;
+    Mul(*this, *this, b);
     return *this;
 }
 
 
 template <unsigned BitCount>
-NGMP<BitCount> NGMP<BitCount>::Karatsuba(NGMP b) const
+NGMP<BitCount> NGMP<BitCount>::Karatsuba(const NGMP& b) const
 {
     NGMP a (*this);
     NGMP bTest (b);
@@ -186,21 +142,21 @@ NGMP<BitCount> NGMP<BitCount>::Karatsuba(NGMP b) const
 }
 
 template <unsigned BitCount>
-NGMP<BitCount> NGMP<BitCount>::operator*(NGMP b) const
+NGMPProduct<BitCount> NGMP<BitCount>::operator*(const NGMP& b) const
 {
     // if (FindHighestBit() > 512 || b.FindHighestBit() > 512)
     //     return Karatsuba(b);
     // else
-        return LongMultiplication(b);
+        return NGMPProduct<BitCount>(*this, b);
 }
 
 template <unsigned BitCount>
-NGMP<BitCount>& NGMP<BitCount>::operator*=(NGMP b)
+NGMP<BitCount>& NGMP<BitCount>::operator*=(const NGMP& b)
 {
     // if (FindHighestBit() > 512 || b.FindHighestBit() > 512)
     //     *this = Karatsuba(b);
     // else
-        *this = LongMultiplication(b);
+        Mul(*this, *this, b);
 
     return *this;
 }
@@ -211,45 +167,116 @@ template <unsigned int BitCount>
 template <unsigned int OtherBitCount, unsigned int Remainder>
 NGMP<BitCount> NGMP<BitCount>::Divide(const NGMP<OtherBitCount>& b, NGMP<Remainder>& r) const
 {
-    if(b.IsZero())
+    const unsigned int divisorLimbs  = b.FindUsedLimbCount();
+    if (divisorLimbs == 0)
         throw std::overflow_error("Divide by zero exception");
-    NGMP<BitCount> divisor = b;
-    NGMP quotient;
-    r = *this;
+    const unsigned int dividendLimbs = FindUsedLimbCount();
 
-    if (divisor.Compare(r) > 0)
-        return 0;
-    while (divisor.Compare(r) <= 0 && !(divisor.number[divisor.MAX_LIMB_COUNT - 1] & ((uint64_t)1 << 63)) )
+    NGMP<BitCount> quotient;
+    if (dividendLimbs < divisorLimbs)
     {
-        divisor.LeftShift();
+        r = *this;
+        return quotient;
     }
 
-    if(!(divisor.number[divisor.MAX_LIMB_COUNT - 1] & ((uint64_t)1 << 63)))
-        divisor.RightShift();
-    
-    while (r.Compare(b) >= 0)
+    // Single limb divisor: plain 128/64 short division
+    if (divisorLimbs == 1)
     {
-        if(r.Compare(divisor) >= 0)
+        uint64_t remainder = 0;
+        for (int i = dividendLimbs - 1; i >= 0; --i)
+            quotient.number[i] = DivLimb(remainder, number[i], b.number[0], remainder);
+        r = remainder;
+        return quotient;
+    }
+
+    // Normalize so the divisor top limb has its MSB set, quotient estimates are then off by at most 2
+    const unsigned int shift = CountLeadingZeros(b.number[divisorLimbs - 1]);
+    uint64_t v[NGMP<OtherBitCount>::MAX_LIMB_COUNT];
+    uint64_t u[MAX_LIMB_COUNT + 1];
+
+    for (unsigned int i = divisorLimbs - 1; i > 0; --i)
+        v[i] = shift ? (b.number[i] << shift) | (b.number[i - 1] >> (64 - shift)) : b.number[i];
+    v[0] = b.number[0] << shift;
+
+    u[dividendLimbs] = shift ? number[dividendLimbs - 1] >> (64 - shift) : 0;
+    for (unsigned int i = dividendLimbs - 1; i > 0; --i)
+        u[i] = shift ? (number[i] << shift) | (number[i - 1] >> (64 - shift)) : number[i];
+    u[0] = number[0] << shift;
+
+    const uint64_t divisorTop  = v[divisorLimbs - 1];
+    const uint64_t divisorNext = v[divisorLimbs - 2];
+
+    for (int j = dividendLimbs - divisorLimbs; j >= 0; --j)
+    {
+        // Estimate quotient limb from the top two dividend limbs
+        uint64_t qHat, rHat;
+        bool rHatOverflow = false;
+        if (u[j + divisorLimbs] == divisorTop)
+        {
+            qHat = ~uint64_t(0);
+            rHat = u[j + divisorLimbs - 1] + divisorTop;
+            rHatOverflow = rHat < divisorTop;
+        }
+        else
+        {
+            qHat = DivLimb(u[j + divisorLimbs], u[j + divisorLimbs - 1], divisorTop, rHat);
+        }
+
+        // Refine with the next divisor limb
+        while (!rHatOverflow)
         {
-            r -= divisor;
-            quotient.number[0] |= 1;
+            uint64_t high;
+            const uint64_t low = MulLimb(qHat, divisorNext, high);
+            if (high < rHat || (high == rHat && low <= u[j + divisorLimbs - 2]))
+                break;
+            --qHat;
+            rHat += divisorTop;
+            rHatOverflow = rHat < divisorTop;
         }
-        quotient.LeftShift();
-        divisor.RightShift();
+
+        // Multiply and subtract qHat * v from the current dividend window
+        uint64_t carry = 0;
+        uint8_t borrow = 0;
+        for (unsigned int i = 0; i < divisorLimbs; ++i)
+        {
+            uint64_t high;
+            uint64_t low = MulLimb(qHat, v[i], high);
+            low += carry;
+            carry = high + (low < carry);
+            borrow = SubBorrow(borrow, u[i + j], low, u[i + j]);
+        }
+        const bool negative = SubBorrow(borrow, u[j + divisorLimbs], carry, u[j + divisorLimbs]) != 0;
+
+        // Estimate was one too large, add divisor back
+        if (negative)
+        {
+            --qHat;
+            uint8_t addCarry = 0;
+            for (unsigned int i = 0; i < divisorLimbs; ++i)
+                addCarry = AddCarry(addCarry, u[i + j], v[i], u[i + j]);
+            u[j + divisorLimbs] += addCarry;
+        }
+        quotient.number[j] = qHat;
     }
+
+    // Denormalize remainder
+    NGMP<Remainder> remainder;
+    for (unsigned int i = 0; i < divisorLimbs && i < NGMP<Remainder>::MAX_LIMB_COUNT; ++i)
+        remainder.number[i] = shift ? (u[i] >> shift) | (u[i + 1] << (64 - shift)) : u[i];
+    r = remainder;
     return quotient;
 }
 
 template <unsigned int BitCount>
 template<unsigned int OtherBitCount>
-NGMP<BitCount> NGMP<BitCount>::operator/(NGMP<OtherBitCount> b) const
+NGMP<BitCount> NGMP<BitCount>::operator/(const NGMP<OtherBitCount>& b) const
 {
     NGMP r;
     return Divide(b,r);
 }
 template <unsigned int BitCount>
 template<unsigned int OtherBitCount>
-NGMP<BitCount>& NGMP<BitCount>::operator/=(NGMP<OtherBitCount> b)
+NGMP<BitCount>& NGMP<BitCount>::operator/=(const NGMP<OtherBitCount>& b)
 {
     NGMP r;
     *this = Divide(b,r);
@@ -258,7 +285,7 @@ NGMP<BitCount>& NGMP<BitCount>::operator/=(NGMP<OtherBitCount> b)
 
 template <unsigned int BitCount>
 template<unsigned int OtherBitCount>
-NGMP<BitCount> NGMP<BitCount>::operator%(NGMP<OtherBitCount> b) const
+NGMP<BitCount> NGMP<BitCount>::operator%(const NGMP<OtherBitCount>& b) const
 {
     NGMP r;
     Divide(b,r);
@@ -267,13 +294,25 @@ NGMP<BitCount> NGMP<BitCount>::operator%(NGMP<OtherBitCount> b) const
 
 template <unsigned int BitCount>
 template<unsigned int OtherBitCount>
-NGMP<BitCount>& NGMP<BitCount>::operator%=(NGMP<OtherBitCount> b)
+NGMP<BitCount>& NGMP<BitCount>::operator%=(const NGMP<OtherBitCount>& b)
 {
     NGMP r;
     Divide(b,r);
     *this = r;
     return *this;
 }
+
+template <unsigned BitCount>
+uint64_t NGMP<BitCount>::ModLimb(uint64_t divisor) const
+{
+    if (divisor == 0)
+        throw std::overflow_error("Divide by zero exception");
+
+    uint64_t remainder = 0;
+    for (int i = FindUsedLimbCount() - 1; i >= 0; --i)
+        DivLimb(remainder, number[i], divisor, remainder);
+    return remainder;
+}
 #pragma endregion 
 
 #pragma region Exponent
@@ -300,24 +339,94 @@ NGMP<BitCount> NGMP<BitCount>::Power(uint64_t power) const
 }
 
 template <unsigned BitCount>
-NGMP<BitCount> NGMP<BitCount>::Power(NGMP power) const
+NGMP<BitCount> NGMP<BitCount>::Power(const NGMP& power) const
 {
     NGMP result;
     NGMP a = *this;
     result += 1;
 
-
-    while (!power.IsZero())
+    const uint64_t powerBits = power.FindHighestBit();
+    for (uint64_t i = 0; i < powerBits; ++i)
     {
-        const bool isOdd = power.IsOdd();
-        power.RightShift();
-
-        if (isOdd)
+        if (power.TestBit(i))
             result *= a;
 
-        a *= a;
+        if (i + 1 < powerBits)
+            a *= a;
     }
 
     return result;
 }
-#pragma endregion 
\ No newline at end of file
+#pragma endregion
+
+#pragma region Three-address kernels
+template <unsigned BitCount>
+void NGMP<BitCount>::Add(NGMP& out, const NGMP& a, const NGMP& b)
+{
+    if (&out == &b)
+    {
+        out += a;
+        return;
+    }
+    if (&out != &a)
+        out = a;
+    out += b;
+}
+
+template <unsigned BitCount>
+void NGMP<BitCount>::Sub(NGMP& out, const NGMP& a, const NGMP& b)
+{
+    if (&out == &b)
+    {
+        NGMP<BitCount> result(a);
+        result -= b;
+        out = result;
+        return;
+    }
+    if (&out != &a)
+        out = a;
+    out -= b;
+}
+
+template <unsigned BitCount>
+void NGMP<BitCount>::Mul(NGMP& out, const NGMP& a, const NGMP& b)
+{
+    uint64_t product[MAX_LIMB_COUNT] = {0};
+    MulAccumulate(product, a, b);
+    memcpy(out.number, product, MAX_LIMB_COUNT * 8);
+}
+
+template <unsigned BitCount>
+void NGMP<BitCount>::MulAdd(NGMP& out, const NGMP& a, const NGMP& b, const NGMP& c)
+{
+    uint64_t product[MAX_LIMB_COUNT];
+    memcpy(product, c.number, MAX_LIMB_COUNT * 8);
+    MulAccumulate(product, a, b);
+    memcpy(out.number, product, MAX_LIMB_COUNT * 8);
+}
+
+template <unsigned BitCount>
+void NGMP<BitCount>::MulAccumulate(uint64_t* accumulator, const NGMP& a, const NGMP& b)
+{
+    const unsigned int aUsedLimbs = a.FindUsedLimbCount();
+    const unsigned int bUsedLimbs = b.FindUsedLimbCount();
+
+    for (unsigned int i = 0; i < aUsedLimbs; ++i)
+    {
+        uint64_t carry = 0;
+        unsigned int j = 0;
+        for (; j < bUsedLimbs && i + j < MAX_LIMB_COUNT; ++j)
+        {
+            uint64_t high;
+            uint64_t low = MulLimb(a.number[i], b.number[j], high);
+            low += carry;
+            high += low < carry;
+            accumulator[i + j] += low;
+            carry = high + (accumulator[i + j] < low);
+        }
+        //Propagate the row carry into the accumulated value
+        for (j += i; carry && j < MAX_LIMB_COUNT; ++j)
+            carry = AddCarry(0, accumulator[j], carry, accumulator[j]);
+    }
+}
+#pragma endregion
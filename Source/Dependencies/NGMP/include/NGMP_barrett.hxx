@@ -0,0 +1,232 @@
+#pragma once
+
+/**
+ * \brief Precomputed Barrett reduction for a fixed modulus
+ * \tparam ModBitCount size of modulus in bits
+ *
+ * Stores mu = floor(b^2k / m) with b = 2^64 and k the used limb count of m,
+ * so any value below b^2k is reduced with two truncated multiplications
+ * and a couple of final subtractions instead of a long division.
+ * The context is constexpr constructible so constant moduli get their
+ * mu computed at compile time.
+ */
+template<unsigned int ModBitCount>
+class BarrettContext
+{
+    template<unsigned int BitCount>
+    friend class NGMP;
+
+private:
+    static const unsigned int MAX_LIMB_COUNT = ModBitCount / 64;
+
+    NGMP<ModBitCount>      modulus;
+    unsigned int           modulusLimbs;
+    NGMP<ModBitCount + 64> mu;
+
+    // Constant-evaluable long division of b^2k by the modulus, in 32-bit digits so no intrinsics are needed
+    static constexpr NGMP<ModBitCount + 64> ComputeMu(const NGMP<ModBitCount>& p_modulus, unsigned int p_modulusLimbs);
+
+    /**
+     * \brief Reduces a raw limb array
+     * \param x value to reduce, must be below b^2k
+     * \param size number of limbs in x
+     * \param out receives x % modulus, MAX_LIMB_COUNT limbs
+     */
+    void Reduce(const uint64_t* x, unsigned int size, uint64_t* out) const;
+
+public:
+    explicit constexpr BarrettContext(const NGMP<ModBitCount>& p_modulus);
+    ~BarrettContext() = default;
+
+    constexpr const NGMP<ModBitCount>& GetModulus() const
+    {
+        return modulus;
+    }
+
+    /**
+     * \brief Barrett reduction
+     * \tparam BitCount size of x in bits
+     * \param x value to reduce, must be below b^2k
+     * \return x % modulus
+     */
+    template<unsigned int BitCount>
+    NGMP<ModBitCount> Reduce(const NGMP<BitCount>& x) const;
+};
+
+template <unsigned int ModBitCount>
+constexpr BarrettContext<ModBitCount>::BarrettContext(const NGMP<ModBitCount>& p_modulus) :
+    modulus(p_modulus), modulusLimbs(p_modulus.FindUsedLimbCount()), mu(ComputeMu(p_modulus, modulusLimbs))
+{
+}
+
+template <unsigned int ModBitCount>
+constexpr NGMP<ModBitCount + 64> BarrettContext<ModBitCount>::ComputeMu(const NGMP<ModBitCount>& p_modulus, unsigned int p_modulusLimbs)
+{
+    if (p_modulusLimbs == 0)
+        throw std::overflow_error("Barrett reduction modulus is zero");
+
+    const uint64_t base = uint64_t(1) << 32;
+
+    // Divisor digits, normalized so the top digit has its MSB set
+    uint32_t v[2 * MAX_LIMB_COUNT] = {};
+    unsigned int n = 2 * p_modulusLimbs;
+    for (unsigned int i = 0; i < p_modulusLimbs; ++i)
+    {
+        v[2 * i]     = static_cast<uint32_t>(p_modulus.number[i]);
+        v[2 * i + 1] = static_cast<uint32_t>(p_modulus.number[i] >> 32);
+    }
+    if (v[n - 1] == 0)
+        --n;
+
+    unsigned int shift = 0;
+    while (!(v[n - 1] & (uint32_t(1) << (31 - shift))))
+        ++shift;
+    for (unsigned int i = n - 1; i > 0 && shift; --i)
+        v[i] = (v[i] << shift) | (v[i - 1] >> (32 - shift));
+    v[0] <<= shift;
+
+    // Dividend b^2k = base^4k, normalized by the same shift
+    const unsigned int m = 4 * p_modulusLimbs + 1;
+    uint32_t u[4 * MAX_LIMB_COUNT + 2] = {};
+    u[m - 1] = uint32_t(1) << shift;
+
+    uint32_t q[4 * MAX_LIMB_COUNT + 2] = {};
+    for (int j = m - n; j >= 0; --j)
+    {
+        const uint64_t top = (static_cast<uint64_t>(u[j + n]) << 32) | u[j + n - 1];
+        uint64_t qHat = top / v[n - 1];
+        uint64_t rHat = top % v[n - 1];
+        while (qHat >= base || (n > 1 && qHat * v[n - 2] > ((rHat << 32) | u[j + n - 2])))
+        {
+            --qHat;
+            rHat += v[n - 1];
+            if (rHat >= base)
+                break;
+        }
+
+        uint64_t carry = 0, borrow = 0;
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            const uint64_t product = qHat * v[i] + carry;
+            carry = product >> 32;
+            const uint64_t diff = static_cast<uint64_t>(u[i + j]) - (product & 0xFFFFFFFF) - borrow;
+            u[i + j] = static_cast<uint32_t>(diff);
+            borrow = diff >> 63;
+        }
+        const uint64_t diff = static_cast<uint64_t>(u[j + n]) - carry - borrow;
+        u[j + n] = static_cast<uint32_t>(diff);
+
+        if (diff >> 63)
+        {
+            --qHat;
+            carry = 0;
+            for (unsigned int i = 0; i < n; ++i)
+            {
+                const uint64_t sum = static_cast<uint64_t>(u[i + j]) + v[i] + carry;
+                u[i + j] = static_cast<uint32_t>(sum);
+                carry = sum >> 32;
+            }
+            u[j + n] = static_cast<uint32_t>(u[j + n] + carry);
+        }
+        q[j] = static_cast<uint32_t>(qHat);
+    }
+
+    // mu < b^(k+1)
+    NGMP<ModBitCount + 64> result;
+    for (unsigned int i = 0; i <= p_modulusLimbs; ++i)
+        result.number[i] = q[2 * i] | (static_cast<uint64_t>(q[2 * i + 1]) << 32);
+    return result;
+}
+
+template <unsigned int ModBitCount>
+template <unsigned int BitCount>
+NGMP<ModBitCount> BarrettContext<ModBitCount>::Reduce(const NGMP<BitCount>& x) const
+{
+    const unsigned int size = x.FindUsedLimbCount();
+    assert(size <= modulusLimbs * 2);
+
+    NGMP<ModBitCount> result;
+    Reduce(x.number, size, result.number);
+    return result;
+}
+
+template <unsigned int ModBitCount>
+void BarrettContext<ModBitCount>::Reduce(const uint64_t* x, unsigned int size, uint64_t* out) const
+{
+    const unsigned int k = modulusLimbs;
+    memset(out, 0, MAX_LIMB_COUNT * 8);
+
+    // Fewer limbs than the modulus means x < b^(k-1) <= modulus
+    if (size < k)
+    {
+        memcpy(out, x, size * 8);
+        return;
+    }
+
+    // q1 = x / b^(k-1)
+    uint64_t q1[MAX_LIMB_COUNT + 1] = {0};
+    for (unsigned int i = k - 1; i < size; ++i)
+        q1[i - (k - 1)] = x[i];
+
+    // q3 = (q1 * mu) / b^(k+1), skipping partial products that cannot reach limb k+1.
+    // Dropped columns make q3 at most one lower, covered by the final subtractions.
+    uint64_t q2[2 * MAX_LIMB_COUNT + 2] = {0};
+    for (unsigned int i = 0; i <= k; ++i)
+    {
+        uint64_t carry = 0;
+        for (unsigned int j = (i + 1 < k) ? k - 1 - i : 0; j <= k; ++j)
+        {
+            uint64_t high;
+            uint64_t low = NGMP<ModBitCount>::MulLimb(q1[i], mu.number[j], high);
+            low += carry;
+            high += low < carry;
+            q2[i + j] += low;
+            carry = high + (q2[i + j] < low);
+        }
+        q2[i + k + 1] = carry;
+    }
+    const uint64_t* q3 = q2 + k + 1;
+
+    // r2 = (q3 * modulus) mod b^(k+1), only the low k+1 limbs are needed
+    uint64_t r2[MAX_LIMB_COUNT + 1] = {0};
+    for (unsigned int i = 0; i <= k; ++i)
+    {
+        uint64_t carry = 0;
+        for (unsigned int j = 0; j < k && i + j <= k; ++j)
+        {
+            uint64_t high;
+            uint64_t low = NGMP<ModBitCount>::MulLimb(q3[i], modulus.number[j], high);
+            low += carry;
+            high += low < carry;
+            r2[i + j] += low;
+            carry = high + (r2[i + j] < low);
+        }
+        if (i + k <= k)
+            r2[i + k] += carry;
+    }
+
+    // r = (x mod b^(k+1)) - r2, wrapping modulo b^(k+1)
+    uint64_t r[MAX_LIMB_COUNT + 1];
+    uint8_t borrow = 0;
+    for (unsigned int i = 0; i <= k; ++i)
+        borrow = NGMP<ModBitCount>::SubBorrow(borrow, i < size ? x[i] : 0, r2[i], r[i]);
+
+    // r < 3 * modulus (4 with the truncated q3)
+    for (;;)
+    {
+        int cmp = r[k] != 0 ? 1 : 0;
+        for (int i = k - 1; i >= 0 && cmp == 0; --i)
+        {
+            if (r[i] != modulus.number[i])
+                cmp = r[i] > modulus.number[i] ? 1 : -1;
+        }
+        if (cmp < 0)
+            break;
+
+        borrow = 0;
+        for (unsigned int i = 0; i <= k; ++i)
+            borrow = NGMP<ModBitCount>::SubBorrow(borrow, r[i], i < k ? modulus.number[i] : 0, r[i]);
+    }
+
+    memcpy(out, r, k * 8);
+}
@@ -5,22 +5,40 @@ template <unsigned BitCount>
 NGMP<BitCount>& NGMP<BitCount>::LeftShift(uint64_t value)
 {
     if(value == 0)
-        return * this;
-    
-    if(value > 64)
+        return *this;
+
+    if(value >= BitCount)
     {
-        LeftShift(static_cast<uint64_t>(std::ceil(value / 2)));
-        LeftShift(value - static_cast<uint64_t>(std::ceil(value / 2)));
+        memset(number, 0, BitCount / 8);
         return *this;
     }
 
-    uint64_t mask = (((uint64_t)1 << value) - 1);
-    for (int i = MAX_LIMB_COUNT - 1; i > 0; --i)
+    const unsigned int usedLimbs = FindUsedLimbCount();
+    if(usedLimbs == 0)
+        return *this;
+
+    //Whole limbs are moved, remaining bits are carried between adjacent limbs.
+    //Limbs above the used ones are zero and stay zero unless bits spill into them.
+    const unsigned int limbShift = static_cast<unsigned int>(value / 64);
+    const unsigned int bitShift  = static_cast<unsigned int>(value % 64);
+
+    if(bitShift == 0)
     {
-        //Move previous block MSD to current block LSD
-        number[i] = (number[i] << value) | ((number[i - 1] >> (64 - value)) & mask);
+        for (unsigned int i = std::min(MAX_LIMB_COUNT - 1, usedLimbs - 1 + limbShift); i >= limbShift; --i)
+            number[i] = number[i - limbShift];
     }
-    number[0] <<= value;
+    else
+    {
+        for (unsigned int i = std::min(MAX_LIMB_COUNT - 1, usedLimbs + limbShift); i > limbShift; --i)
+        {
+            //Move previous block MSD to current block LSD
+            number[i] = (number[i - limbShift] << bitShift) | (number[i - limbShift - 1] >> (64 - bitShift));
+        }
+        number[limbShift] = number[0] << bitShift;
+    }
+
+    for (unsigned int i = 0; i < limbShift; ++i)
+        number[i] = 0;
     return *this;
 }
 
@@ -30,40 +48,62 @@ NGMP<BitCount>& NGMP<BitCount>::RightShift(uint64_t value)
     if(value == 0)
         return *this;
 
-    if(value > 64)
-    {
-        RightShift(static_cast<uint64_t>(std::ceil(value / 2)));
-        RightShift(value - static_cast<uint64_t>(std::ceil(value / 2)));
-        return *this;
-    }
+    const unsigned int usedLimbs = FindUsedLimbCount();
+    const unsigned int limbShift = static_cast<unsigned int>(std::min<uint64_t>(value / 64, usedLimbs));
+    const unsigned int bitShift  = static_cast<unsigned int>(value % 64);
+    const unsigned int newUsed   = usedLimbs - limbShift;
 
-    for (int i = 0; i < MAX_LIMB_COUNT - 1; ++i)
+    if(newUsed != 0)
     {
-        //Move next block LSD to current block MSD
-        number[i] = (number[i] >> value) | ((number[i + 1] << (64 - value)));
+        if(bitShift == 0)
+        {
+            for (unsigned int i = 0; i < newUsed; ++i)
+                number[i] = number[i + limbShift];
+        }
+        else
+        {
+            for (unsigned int i = 0; i < newUsed - 1; ++i)
+            {
+                //Move next block LSD to current block MSD
+                number[i] = (number[i + limbShift] >> bitShift) | (number[i + limbShift + 1] << (64 - bitShift));
+            }
+            number[newUsed - 1] = number[usedLimbs - 1] >> bitShift;
+        }
     }
-    number[MAX_LIMB_COUNT - 1] >>= value;
+
+    for (unsigned int i = newUsed; i < usedLimbs; ++i)
+        number[i] = 0;
     return *this;
 }
 
 template <unsigned BitCount>
-uint64_t  NGMP<BitCount>::FindHighestBit() const
+bool NGMP<BitCount>::TestBit(uint64_t index) const
 {
-    for (int i = MAX_LIMB_COUNT - 1; i >= 0; --i)
+    return index < BitCount && ((number[index / 64] >> (index % 64)) & 1);
+}
+
+template <unsigned BitCount>
+uint64_t NGMP<BitCount>::FindHighestBit() const
+{
+    const unsigned int usedLimbs = FindUsedLimbCount();
+    if(usedLimbs == 0)
+        return 0;
+    return usedLimbs * 64 - CountLeadingZeros(number[usedLimbs - 1]);
+}
+
+template <unsigned BitCount>
+uint64_t NGMP<BitCount>::CountTrailingZeroBits() const
+{
+    for (unsigned int i = 0; i < MAX_LIMB_COUNT; ++i)
     {
-        if(number[i] == 0)
-            continue;
-        for(int j = 63; j >=0; --j)
-        {
-            if(number[i] & (uint64_t(1) << j))
-                return i * 64 + j + 1;
-        }
+        if (number[i])
+            return i * 64 + CountTrailingZeros(number[i]);
     }
     return 0;
 }
 
 template <unsigned BitCount>
-unsigned int  NGMP<BitCount>::FindUsedLimbCount() const
+constexpr unsigned int NGMP<BitCount>::FindUsedLimbCount() const
 {
     for (int i = MAX_LIMB_COUNT - 1; i >= 0; --i)
     {
@@ -3,7 +3,7 @@
 template <unsigned BitCount>
 bool NGMP<BitCount>::IsZero() const
 {
-    for (int i = 0; i < MAX_LIMB_COUNT; ++i)
+    for (unsigned int i = 0; i < MAX_LIMB_COUNT; ++i)
     {
         if (number[i] != 0)
             return false;
@@ -33,7 +33,7 @@ bool NGMP<BitCount>::operator==(const NGMP& other) const
 {
     if (other.MAX_LIMB_COUNT != MAX_LIMB_COUNT)
         return false;
-    for (int i = 0; i < MAX_LIMB_COUNT; ++i)
+    for (unsigned int i = 0; i < MAX_LIMB_COUNT; ++i)
     {
         if (number[i] != other.number[i])
             return false;
@@ -44,12 +44,15 @@ bool NGMP<BitCount>::operator==(const NGMP& other) const
 template <unsigned BitCount>
 int NGMP<BitCount>::Compare(const NGMP<BitCount>& other) const
 {
-    for (int i = MAX_LIMB_COUNT - 1; i >= 0; --i)
+    //Borrow chain over the used limbs: sign from the final borrow, equality from the accumulated difference
+    const unsigned int usedLimbs = std::max(FindUsedLimbCount(), other.FindUsedLimbCount());
+    uint8_t borrow = 0;
+    uint64_t difference = 0;
+    for (unsigned int i = 0; i < usedLimbs; ++i)
     {
-        if (number[i] > other.number[i])
-            return 1;
-        if (number[i] < other.number[i])
-            return -1;
+        uint64_t limb;
+        borrow = SubBorrow(borrow, number[i], other.number[i], limb);
+        difference |= limb;
     }
-    return 0;
+    return borrow ? -1 : (difference != 0);
 }
\ No newline at end of file
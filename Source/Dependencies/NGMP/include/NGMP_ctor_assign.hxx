@@ -1,78 +1,68 @@
 #pragma once
 
 template <unsigned BitCount>
-NGMP<BitCount>::NGMP(const uint64_t value)
+constexpr NGMP<BitCount>::NGMP(const uint64_t value)
 {
     number[0] = value;
 }
 
 template <unsigned BitCount>
-NGMP<BitCount>::NGMP(const uint64_t array[], unsigned size)
+constexpr NGMP<BitCount>::NGMP(const uint64_t array[], unsigned size)
 {
-    if (MAX_LIMB_COUNT >= size)
-        memcpy_s(number, MAX_LIMB_COUNT * 8, array, size * 8);
-    else
-        memcpy_s(number, MAX_LIMB_COUNT * 8, array, MAX_LIMB_COUNT * 8);
+    for (unsigned int i = 0; i < size && i < MAX_LIMB_COUNT; ++i)
+        number[i] = array[i];
 }
 
 template <unsigned BitCount>
-NGMP<BitCount>::NGMP(const uint32_t array[], unsigned size)
+constexpr NGMP<BitCount>::NGMP(const uint32_t array[], unsigned size)
 {
-    for (unsigned int i = 0, j = 0; i < MAX_LIMB_COUNT && j < size; ++i, ++j)
+    for (unsigned int i = 0; i < size && i / 2 < MAX_LIMB_COUNT; ++i)
     {
-        number[i] = array[j];
-        number[i] <<= 32;
-        ++j;
-        if (j < size)
-            number[i] |= array[j];
+        const uint64_t word = array[size - 1 - i];
+        number[i / 2] |= (i % 2) ? word << 32 : word;
     }
 }
 
 template <unsigned BitCount>
-NGMP<BitCount>::NGMP(std::initializer_list<uint64_t> list)
+constexpr NGMP<BitCount>::NGMP(std::initializer_list<uint64_t> list)
 {
     auto it = list.begin();
-    for (int i = 0; i < list.size(); ++i, ++it)
+    for (unsigned int i = 0; i < list.size() && i < MAX_LIMB_COUNT; ++i, ++it)
     {
         number[i] = *it;
     }
 }
 
 template <unsigned BitCount>
-NGMP<BitCount>::NGMP(std::initializer_list<uint32_t> list)
+constexpr NGMP<BitCount>::NGMP(std::initializer_list<uint32_t> list)
 {
-    int i = 0;
-    for (auto it = list.begin(); it != list.end(); ++it, ++i)
+    const unsigned int size = static_cast<unsigned int>(list.size());
+    for (unsigned int i = 0; i < size && i / 2 < MAX_LIMB_COUNT; ++i)
     {
-        number[i] = *it;
-        number[i] <<= 32;
-        ++it;
-        if (it == list.end())
-            break;
-        number[i] |= *it;
+        const uint64_t word = list.begin()[size - 1 - i];
+        number[i / 2] |= (i % 2) ? word << 32 : word;
     }
 }
 
 template <unsigned BitCount>
-NGMP<BitCount>::NGMP(const NGMP<BitCount>& other)
+constexpr NGMP<BitCount>::NGMP(const NGMP<BitCount>& other)
 {
-    memcpy_s(number, MAX_LIMB_COUNT * 8, other.number, other.MAX_LIMB_COUNT * 8);
+    for (unsigned int i = 0; i < MAX_LIMB_COUNT; ++i)
+        number[i] = other.number[i];
 }
 
 template <unsigned BitCount>
 template <unsigned OtherBitCount>
-NGMP<BitCount>::NGMP(const NGMP<OtherBitCount>& other)
+constexpr NGMP<BitCount>::NGMP(const NGMP<OtherBitCount>& other)
 {
-    if constexpr (MAX_LIMB_COUNT >= other.MAX_LIMB_COUNT)
-        memcpy_s(number, MAX_LIMB_COUNT * 8, other.number, other.MAX_LIMB_COUNT * 8);
-    else
-        memcpy_s(number, MAX_LIMB_COUNT * 8, other.number, MAX_LIMB_COUNT * 8);
+    for (unsigned int i = 0; i < MAX_LIMB_COUNT && i < NGMP<OtherBitCount>::MAX_LIMB_COUNT; ++i)
+        number[i] = other.number[i];
 }
 
 template <unsigned BitCount>
 NGMP<BitCount>& NGMP<BitCount>::operator=(const NGMP<BitCount>& other)
 {
-    memcpy_s(number, MAX_LIMB_COUNT * 8, other.number, other.MAX_LIMB_COUNT * 8);
+    memcpy(number, other.number, MAX_LIMB_COUNT * 8);
     return *this;
 }
 
@@ -81,22 +71,45 @@ template <unsigned OtherBitCount>
 NGMP<BitCount>& NGMP<BitCount>::operator=(const NGMP<BitCount>& other)
 {
     if constexpr (MAX_LIMB_COUNT >= other.MAX_LIMB_COUNT)
-        memcpy_s(number, MAX_LIMB_COUNT * 8, other.number, other.MAX_LIMB_COUNT * 8);
+        memcpy(number, other.number, other.MAX_LIMB_COUNT * 8);
     else
-        memcpy_s(number, MAX_LIMB_COUNT * 8, other.number, MAX_LIMB_COUNT * 8);
+        memcpy(number, other.number, MAX_LIMB_COUNT * 8);
     return *this;
 }
 
 template <unsigned BitCount>
 NGMP<BitCount> NGMP<BitCount>::Random()
 {
-    static std::mt19937 randEngine;
-    static std::uniform_int_distribution<uint64_t> uintDist;
+    // One device per thread, so concurrent key generation does not share state
+    thread_local std::random_device device;
 
     NGMP<BitCount> res;
     for (int i = 0; i < MAX_LIMB_COUNT; ++i)
     {
-        res.number[i] = uintDist(randEngine);
+        res.number[i] = (static_cast<uint64_t>(device()) << 32) | device();
     }
     return res;
-}
\ No newline at end of file
+}
+
+template <unsigned BitCount>
+template <typename Generator>
+NGMP<BitCount> NGMP<BitCount>::Random(Generator& p_generator)
+{
+    NGMP<BitCount> res;
+    p_generator.Generate(reinterpret_cast<uint8_t*>(res.number), MAX_LIMB_COUNT * 8);
+    return res;
+}
+
+template <unsigned BitCount>
+void NGMP<BitCount>::Wipe()
+{
+#if defined(_MSC_VER)
+    volatile uint64_t* limbs = number;
+    for (unsigned int i = 0; i < MAX_LIMB_COUNT; ++i)
+        limbs[i] = 0;
+#else
+    memset(number, 0, sizeof(number));
+    // The compiler must assume the asm reads the limbs, so the memset is not a dead store
+    __asm__ __volatile__("" : : "r"(number) : "memory");
+#endif
+}
@@ -0,0 +1,370 @@
+#pragma once
+
+template <unsigned BitCount>
+NGMP<BitCount> NGMP<BitCount>::FromBigEndian(const uint8_t* bytes, uint64_t size)
+{
+    // Leading bytes past the container must be zero
+    const uint64_t maxSize = BitCount / 8;
+    for (; size > maxSize; ++bytes, --size)
+    {
+        if (*bytes)
+            throw std::overflow_error("Encoded value does not fit the container");
+    }
+
+    // Whole limbs come from the end of the buffer, one load and byte swap each
+    NGMP<BitCount> result;
+    const unsigned int fullLimbs = static_cast<unsigned int>(size / 8);
+    for (unsigned int i = 0; i < fullLimbs; ++i)
+        result.number[i] = LoadBigEndian(bytes + size - 8 * (i + 1));
+
+    // Remaining most significant bytes
+    const unsigned int head = static_cast<unsigned int>(size % 8);
+    if (head)
+    {
+        uint64_t limb = 0;
+        for (unsigned int i = 0; i < head; ++i)
+            limb = (limb << 8) | bytes[i];
+        result.number[fullLimbs] = limb;
+    }
+    return result;
+}
+
+template <unsigned BitCount>
+void NGMP<BitCount>::ToBigEndian(uint8_t* bytes, uint64_t size) const
+{
+    if ((FindHighestBit() + 7) / 8 > size)
+        throw std::overflow_error("Value does not fit the output size");
+
+    const unsigned int usedLimbs = FindUsedLimbCount();
+    const unsigned int fullLimbs = static_cast<unsigned int>(std::min<uint64_t>(size / 8, usedLimbs));
+    for (unsigned int i = 0; i < fullLimbs; ++i)
+        StoreBigEndian(number[i], bytes + size - 8 * (i + 1));
+
+    // Top limb when it only partially fits, then the zero padding
+    uint64_t written = 8 * uint64_t(fullLimbs);
+    if (fullLimbs < usedLimbs)
+    {
+        for (uint64_t limb = number[fullLimbs]; written < size && limb; limb >>= 8)
+            bytes[size - ++written] = static_cast<uint8_t>(limb);
+    }
+    memset(bytes, 0, size - written);
+}
+
+template <unsigned BitCount>
+const NGMP<BitCount>* NGMP<BitCount>::GetDecimalPowers(unsigned int& count)
+{
+    struct Table
+    {
+        NGMP            powers[16];
+        unsigned int    count;
+    };
+    static const Table table = []
+    {
+        Table result;
+        result.powers[0] = NGMP(DECIMAL_CHUNK);
+        result.count = 1;
+        while (result.count < 16 && 2 * result.powers[result.count - 1].FindHighestBit() <= BitCount)
+        {
+            result.powers[result.count] = result.powers[result.count - 1] * result.powers[result.count - 1];
+            ++result.count;
+        }
+        return result;
+    }();
+
+    count = table.count;
+    return table.powers;
+}
+
+template <unsigned BitCount>
+char* NGMP<BitCount>::WriteDecimal(const NGMP& value, char* end, uint64_t minDigits)
+{
+    const unsigned int usedLimbs = value.FindUsedLimbCount();
+    if (usedLimbs > DECIMAL_BASE_LIMBS)
+    {
+        // Split at the largest power not above the value, the low part takes exactly 19 * 2^k digits
+        unsigned int count;
+        const NGMP* powers = GetDecimalPowers(count);
+        unsigned int k = count - 1;
+        while (k > 0 && powers[k].Compare(value) > 0)
+            --k;
+
+        NGMP remainder;
+        const NGMP quotient = value.Divide(powers[k], remainder);
+        const uint64_t lowDigits = uint64_t(DECIMAL_CHUNK_DIGITS) << k;
+        char* start = WriteDecimal(remainder, end, lowDigits);
+        return WriteDecimal(quotient, start, minDigits > lowDigits ? minDigits - lowDigits : 0);
+    }
+
+    static const char DIGIT_PAIRS[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+
+    // Short division by 10^19, one chunk of 19 digits per pass from the least significant end
+    uint64_t limbs[DECIMAL_BASE_LIMBS];
+    unsigned int used = usedLimbs;
+    for (unsigned int i = 0; i < used; ++i)
+        limbs[i] = value.number[i];
+
+    char* cursor = end;
+    while (used)
+    {
+        uint64_t chunk = 0;
+        for (unsigned int i = used; i-- > 0;)
+            limbs[i] = DivLimb(chunk, limbs[i], DECIMAL_CHUNK, chunk);
+        while (used && limbs[used - 1] == 0)
+            --used;
+
+        for (unsigned int i = 0; i < DECIMAL_CHUNK_DIGITS / 2; ++i)
+        {
+            const char* pair = DIGIT_PAIRS + 2 * (chunk % 100);
+            chunk /= 100;
+            *--cursor = pair[1];
+            *--cursor = pair[0];
+        }
+        *--cursor = static_cast<char>('0' + chunk);
+    }
+
+    // The top chunk is zero padded, trim it down to minDigits and at least one digit
+    const uint64_t keep = std::max<uint64_t>(minDigits, 1);
+    while (uint64_t(end - cursor) > keep && *cursor == '0')
+        ++cursor;
+    while (uint64_t(end - cursor) < keep)
+        *--cursor = '0';
+    return cursor;
+}
+
+template <unsigned BitCount>
+uint64_t NGMP<BitCount>::ToHex(char* buffer, uint64_t size) const
+{
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+    const uint64_t length = IsZero() ? 1 : (FindHighestBit() + 3) / 4;
+    if (length + 1 > size)
+        return 0;
+
+    for (uint64_t i = 0; i < length; ++i)
+        buffer[length - 1 - i] = HEX_DIGITS[(number[i / 16] >> (4 * (i % 16))) & 0xF];
+    buffer[length] = '\0';
+    return length;
+}
+
+template <unsigned BitCount>
+uint64_t NGMP<BitCount>::ToDecimal(char* buffer, uint64_t size) const
+{
+    // The top chunk may be written with up to 18 zeros before they are trimmed
+    char digits[MAX_DECIMAL_DIGITS + DECIMAL_CHUNK_DIGITS];
+    char* end = digits + sizeof(digits);
+    const char* start = WriteDecimal(*this, end, 1);
+
+    const uint64_t length = end - start;
+    if (length + 1 > size)
+        return 0;
+
+    memcpy(buffer, start, length);
+    buffer[length] = '\0';
+    return length;
+}
+
+template <unsigned BitCount>
+bool NGMP<BitCount>::FromHex(const char* text, uint64_t length, NGMP& out)
+{
+    if (length == 0)
+        return false;
+    while (length > 1 && *text == '0')
+    {
+        ++text;
+        --length;
+    }
+    if (length > MAX_HEX_DIGITS)
+        return false;
+
+    NGMP result;
+    for (uint64_t i = 0; i < length; ++i)
+    {
+        const char c = text[length - 1 - i];
+        uint64_t digit;
+        if (c >= '0' && c <= '9')
+            digit = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            digit = c - 'A' + 10;
+        else
+            return false;
+        result.number[i / 16] |= digit << (4 * (i % 16));
+    }
+
+    out = result;
+    return true;
+}
+
+template <unsigned BitCount>
+bool NGMP<BitCount>::FromDecimal(const char* text, uint64_t length, NGMP& out)
+{
+    if (length == 0)
+        return false;
+
+    NGMP result;
+    unsigned int used = 0;
+    // The first chunk takes the leftover digits so the rest are whole 19-digit chunks
+    uint64_t chunkDigits = length % DECIMAL_CHUNK_DIGITS ? length % DECIMAL_CHUNK_DIGITS : DECIMAL_CHUNK_DIGITS;
+    for (uint64_t position = 0; position < length; position += chunkDigits, chunkDigits = DECIMAL_CHUNK_DIGITS)
+    {
+        uint64_t chunk = 0;
+        uint64_t scale = 1;
+        for (uint64_t i = position; i < position + chunkDigits; ++i)
+        {
+            if (text[i] < '0' || text[i] > '9')
+                return false;
+            chunk = chunk * 10 + (text[i] - '0');
+            scale *= 10;
+        }
+
+        // result = result * scale + chunk
+        uint64_t carry = chunk;
+        for (unsigned int i = 0; i < used; ++i)
+        {
+            uint64_t high;
+            const uint64_t low = MulLimb(result.number[i], scale, high);
+            carry = high + AddCarry(0, low, carry, result.number[i]);
+        }
+        if (carry)
+        {
+            if (used == MAX_LIMB_COUNT)
+                return false;
+            result.number[used++] = carry;
+        }
+    }
+
+    out = result;
+    return true;
+}
+
+template <unsigned BitCount>
+uint64_t NGMP<BitCount>::NumberOfDigits() const
+{
+    const uint64_t bits = FindHighestBit();
+    if (bits == 0)
+        return 1;
+
+    // 78913 / 2^18 is just below log10(2), so 10^digits <= 2^(bits - 1) and the loop steps up at most twice
+    uint64_t digits = (bits - 1) * 78913 >> 18;
+    NGMP<BitCount + 64> power = NGMP<BitCount + 64>(10).Power(digits);
+    const NGMP<BitCount + 64> value(*this);
+    while (power.Compare(value) <= 0)
+    {
+        power *= NGMP<BitCount + 64>(10);
+        ++digits;
+    }
+    return digits;
+}
+
+/**
+ * \brief Read-only NGMP over a big-endian byte buffer, such as a key received from the network
+ * \tparam BitCount size of the value in bits
+ *
+ * Limbs are decoded on demand with a byte swapped load, so range checks and comparisons run on
+ * the received bytes directly. Operations that need the full value (PowMod, Jacobi) go through
+ * ToNGMP, a single decode. The buffer must outlive the view.
+ */
+template<unsigned int BitCount>
+class NGMPView
+{
+private:
+    const uint8_t*  bytes;
+    uint64_t        size;
+
+public:
+    /**
+     * \param p_bytes most significant byte first
+     * \param p_size byte count, leading bytes past BitCount / 8 must be zero, throws std::overflow_error otherwise
+     */
+    NGMPView(const uint8_t* p_bytes, uint64_t p_size) : bytes(p_bytes), size(p_size)
+    {
+        for (; size > BitCount / 8; ++bytes, --size)
+        {
+            if (*bytes)
+                throw std::overflow_error("Encoded value does not fit the container");
+        }
+    }
+    ~NGMPView() = default;
+
+    const uint8_t*  GetBytes() const { return bytes; }
+    uint64_t        GetSize() const { return size; }
+
+    // Limb index, least significant first, as in NGMP::Get64BitArray
+    uint64_t GetLimb(unsigned int index) const
+    {
+        const uint64_t end = 8 * uint64_t(index + 1);
+        if (end <= size)
+            return NGMP<BitCount>::LoadBigEndian(bytes + size - end);
+
+        uint64_t limb = 0;
+        for (uint64_t i = end - 8; i < size; ++i)
+            limb |= uint64_t(bytes[size - 1 - i]) << (8 * (i % 8));
+        return limb;
+    }
+
+    unsigned int FindUsedLimbCount() const
+    {
+        // Skip leading zero bytes without decoding
+        uint64_t first = 0;
+        while (first < size && bytes[first] == 0)
+            ++first;
+        return static_cast<unsigned int>((size - first + 7) / 8);
+    }
+
+    uint64_t FindHighestBit() const
+    {
+        const unsigned int usedLimbs = FindUsedLimbCount();
+        if (usedLimbs == 0)
+            return 0;
+        return usedLimbs * 64 - NGMP<BitCount>::CountLeadingZeros(GetLimb(usedLimbs - 1));
+    }
+
+    bool IsZero() const
+    {
+        return FindUsedLimbCount() == 0;
+    }
+
+    bool IsOdd() const
+    {
+        return size && (bytes[size - 1] & 1);
+    }
+
+    // Compares limbs from the most significant down, stops at the first difference
+    int Compare(const NGMP<BitCount>& other) const
+    {
+        const uint64_t* otherLimbs = other.number;
+        const unsigned int limbs = std::max(FindUsedLimbCount(), other.FindUsedLimbCount());
+        for (unsigned int i = limbs; i-- > 0;)
+        {
+            const uint64_t limb = GetLimb(i);
+            if (limb != otherLimbs[i])
+                return limb > otherLimbs[i] ? 1 : -1;
+        }
+        return 0;
+    }
+
+    bool operator==(const NGMP<BitCount>& other) const
+    {
+        return Compare(other) == 0;
+    }
+
+    uint64_t ModLimb(uint64_t divisor) const
+    {
+        if (divisor == 0)
+            throw std::overflow_error("Divide by zero exception");
+
+        uint64_t remainder = 0;
+        for (unsigned int i = FindUsedLimbCount(); i-- > 0;)
+            NGMP<BitCount>::DivLimb(remainder, GetLimb(i), divisor, remainder);
+        return remainder;
+    }
+
+    NGMP<BitCount> ToNGMP() const
+    {
+        return NGMP<BitCount>::FromBigEndian(bytes, size);
+    }
+};
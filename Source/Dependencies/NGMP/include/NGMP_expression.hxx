@@ -0,0 +1,67 @@
+#pragma once
+
+/**
+ * \brief Lazy product returned by NGMP::operator*
+ * \tparam BitCount size of operands in bits
+ *
+ * Holds references to both operands and is evaluated when converted to NGMP,
+ * letting chains such as a * b + c run as a single multiply-accumulate
+ * without an intermediate product. Operands must outlive the expression,
+ * so a product should not be stored with auto.
+ */
+template<unsigned int BitCount>
+class NGMPProduct
+{
+private:
+    const NGMP<BitCount>& a;
+    const NGMP<BitCount>& b;
+
+public:
+    NGMPProduct(const NGMP<BitCount>& p_a, const NGMP<BitCount>& p_b) : a(p_a), b(p_b) {}
+
+    void Evaluate(NGMP<BitCount>& out) const
+    {
+        NGMP<BitCount>::Mul(out, a, b);
+    }
+
+    friend NGMP<BitCount> operator+(const NGMPProduct& product, const NGMP<BitCount>& c)
+    {
+        NGMP<BitCount> result;
+        NGMP<BitCount>::MulAdd(result, product.a, product.b, c);
+        return result;
+    }
+
+    friend NGMP<BitCount> operator+(const NGMP<BitCount>& c, const NGMPProduct& product)
+    {
+        NGMP<BitCount> result;
+        NGMP<BitCount>::MulAdd(result, product.a, product.b, c);
+        return result;
+    }
+
+    friend NGMP<BitCount> operator-(const NGMPProduct& product, const NGMP<BitCount>& c)
+    {
+        NGMP<BitCount> result(product);
+        result -= c;
+        return result;
+    }
+
+    friend NGMP<BitCount> operator*(const NGMPProduct& product, const NGMP<BitCount>& c)
+    {
+        NGMP<BitCount> result(product);
+        result *= c;
+        return result;
+    }
+};
+
+template <unsigned BitCount>
+NGMP<BitCount>::NGMP(const NGMPProduct<BitCount>& product)
+{
+    product.Evaluate(*this);
+}
+
+template <unsigned BitCount>
+NGMP<BitCount>& NGMP<BitCount>::operator=(const NGMPProduct<BitCount>& product)
+{
+    product.Evaluate(*this);
+    return *this;
+}
@@ -0,0 +1,215 @@
+#pragma once
+
+template <unsigned BitCount>
+uint8_t NGMP<BitCount>::AddCarry(uint8_t carry, uint64_t a, uint64_t b, uint64_t& out)
+{
+#if defined(_M_X64)
+    return _addcarry_u64(carry, a, b, reinterpret_cast<unsigned long long*>(&out));
+#elif defined(__x86_64__)
+    unsigned long long sum;
+    carry = _addcarry_u64(carry, a, b, &sum);
+    out = sum;
+    return carry;
+#else
+    const uint64_t sum = a + b;
+    const uint64_t res = sum + carry;
+    out = res;
+    return (sum < a) | (res < sum);
+#endif
+}
+
+template <unsigned BitCount>
+uint8_t NGMP<BitCount>::SubBorrow(uint8_t borrow, uint64_t a, uint64_t b, uint64_t& out)
+{
+#if defined(_M_X64)
+    return _subborrow_u64(borrow, a, b, reinterpret_cast<unsigned long long*>(&out));
+#elif defined(__x86_64__)
+    unsigned long long diff;
+    borrow = _subborrow_u64(borrow, a, b, &diff);
+    out = diff;
+    return borrow;
+#else
+    const uint64_t diff = a - b;
+    const uint64_t res  = diff - borrow;
+    out = res;
+    return (diff > a) | (res > diff);
+#endif
+}
+
+template <unsigned BitCount>
+uint64_t NGMP<BitCount>::MulLimb(uint64_t a, uint64_t b, uint64_t& high)
+{
+#if defined(__SIZEOF_INT128__)
+    const unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    high = static_cast<uint64_t>(product >> 64);
+    return static_cast<uint64_t>(product);
+#elif defined(_M_X64)
+    return _umul128(a, b, &high);
+#else
+    const uint64_t aLow = a & 0xFFFFFFFF, aHigh = a >> 32;
+    const uint64_t bLow = b & 0xFFFFFFFF, bHigh = b >> 32;
+
+    const uint64_t lowLow   = aLow * bLow;
+    const uint64_t highLow  = aHigh * bLow;
+    const uint64_t lowHigh  = aLow * bHigh;
+    const uint64_t highHigh = aHigh * bHigh;
+
+    const uint64_t middle = (lowLow >> 32) + (highLow & 0xFFFFFFFF) + lowHigh;
+    high = highHigh + (highLow >> 32) + (middle >> 32);
+    return (middle << 32) | (lowLow & 0xFFFFFFFF);
+#endif
+}
+
+template <unsigned BitCount>
+uint64_t NGMP<BitCount>::DivLimb(uint64_t high, uint64_t low, uint64_t divisor, uint64_t& remainder)
+{
+    assert(high < divisor);
+#if defined(__SIZEOF_INT128__)
+    const unsigned __int128 dividend = (static_cast<unsigned __int128>(high) << 64) | low;
+    remainder = static_cast<uint64_t>(dividend % divisor);
+    return static_cast<uint64_t>(dividend / divisor);
+#elif defined(_M_X64)
+    return _udiv128(high, low, divisor, &remainder);
+#else
+    // Two 64/32 digit steps on the normalized divisor (Hacker's Delight divlu)
+    const uint64_t base = uint64_t(1) << 32;
+    const unsigned int shift = CountLeadingZeros(divisor);
+    divisor <<= shift;
+    high = shift ? (high << shift) | (low >> (64 - shift)) : high;
+    low <<= shift;
+
+    const uint64_t divisorHigh = divisor >> 32;
+    const uint64_t divisorLow  = divisor & 0xFFFFFFFF;
+    const uint64_t lowHigh     = low >> 32;
+    const uint64_t lowLow      = low & 0xFFFFFFFF;
+
+    uint64_t quotientHigh = high / divisorHigh;
+    uint64_t rHat         = high - quotientHigh * divisorHigh;
+    while (quotientHigh >= base || quotientHigh * divisorLow > ((rHat << 32) | lowHigh))
+    {
+        --quotientHigh;
+        rHat += divisorHigh;
+        if (rHat >= base)
+            break;
+    }
+
+    const uint64_t partial = (high << 32) + lowHigh - quotientHigh * divisor;
+    uint64_t quotientLow = partial / divisorHigh;
+    rHat = partial - quotientLow * divisorHigh;
+    while (quotientLow >= base || quotientLow * divisorLow > ((rHat << 32) | lowLow))
+    {
+        --quotientLow;
+        rHat += divisorHigh;
+        if (rHat >= base)
+            break;
+    }
+
+    remainder = ((partial << 32) + lowLow - quotientLow * divisor) >> shift;
+    return (quotientHigh << 32) | quotientLow;
+#endif
+}
+
+template <unsigned BitCount>
+unsigned int NGMP<BitCount>::CountLeadingZeros(uint64_t value)
+{
+    assert(value != 0);
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return 63 - index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32)))
+        return 31 - index;
+    _BitScanReverse(&index, static_cast<unsigned long>(value));
+    return 63 - index;
+#else
+    return static_cast<unsigned int>(__builtin_clzll(value));
+#endif
+}
+
+template <unsigned BitCount>
+unsigned int NGMP<BitCount>::CountTrailingZeros(uint64_t value)
+{
+    assert(value != 0);
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if (_BitScanForward(&index, static_cast<unsigned long>(value)))
+        return index;
+    _BitScanForward(&index, static_cast<unsigned long>(value >> 32));
+    return 32 + index;
+#else
+    return static_cast<unsigned int>(__builtin_ctzll(value));
+#endif
+}
+
+template <unsigned BitCount>
+void NGMP<BitCount>::MulLimbs(const uint64_t* a, unsigned int aSize, const uint64_t* b, unsigned int bSize, uint64_t* out)
+{
+    memset(out, 0, (aSize + bSize) * 8);
+    for (unsigned int i = 0; i < aSize; ++i)
+    {
+        uint64_t carry = 0;
+        for (unsigned int j = 0; j < bSize; ++j)
+        {
+            uint64_t high;
+            uint64_t low = MulLimb(a[i], b[j], high);
+            low += carry;
+            high += low < carry;
+            out[i + j] += low;
+            carry = high + (out[i + j] < low);
+        }
+        out[i + bSize] = carry;
+    }
+}
+
+template <unsigned BitCount>
+uint64_t NGMP<BitCount>::StripTrailingZeros(uint64_t* a, unsigned int& size)
+{
+    unsigned int zeroLimbs = 0;
+    while (a[zeroLimbs] == 0)
+        ++zeroLimbs;
+    const unsigned int zeroBits = CountTrailingZeros(a[zeroLimbs]);
+
+    if (zeroLimbs)
+    {
+        memmove(a, a + zeroLimbs, (size - zeroLimbs) * 8);
+        size -= zeroLimbs;
+    }
+    if (zeroBits)
+    {
+        for (unsigned int i = 0; i + 1 < size; ++i)
+            a[i] = (a[i] >> zeroBits) | (a[i + 1] << (64 - zeroBits));
+        a[size - 1] >>= zeroBits;
+        if (a[size - 1] == 0)
+            --size;
+    }
+    return zeroLimbs * 64 + zeroBits;
+}
+
+template <unsigned BitCount>
+uint64_t NGMP<BitCount>::LoadBigEndian(const uint8_t* bytes)
+{
+    uint64_t value;
+    memcpy(&value, bytes, sizeof(value));
+#if defined(_MSC_VER)
+    return _byteswap_uint64(value);
+#else
+    return __builtin_bswap64(value);
+#endif
+}
+
+template <unsigned BitCount>
+void NGMP<BitCount>::StoreBigEndian(uint64_t value, uint8_t* bytes)
+{
+#if defined(_MSC_VER)
+    value = _byteswap_uint64(value);
+#else
+    value = __builtin_bswap64(value);
+#endif
+    memcpy(bytes, &value, sizeof(value));
+}
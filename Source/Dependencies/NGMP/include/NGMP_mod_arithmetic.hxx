@@ -4,113 +4,79 @@
 
 template <unsigned int BitCount>
 template <unsigned int OtherBitCount, unsigned int ModBitCount>
- NGMP<BitCount>& NGMP<BitCount>::MulMod(NGMP<OtherBitCount> b, const NGMP<ModBitCount>& mod)
+ NGMP<BitCount>& NGMP<BitCount>::MulMod(const NGMP<OtherBitCount>& b, const NGMP<ModBitCount>& mod)
 {
-    NGMP<BitCount * 2> maxValue = 2;
-    maxValue = maxValue.Power(ModBitCount);
-    maxValue -= 1;
-    maxValue *= 2;
-
-    NGMP<BitCount * 2> maxHandledSize = 2;
-    maxHandledSize = maxHandledSize.Power(BitCount);
-    maxHandledSize -= 1;
-
-    // Instance should handle (mod-1)*2
-    assert(maxValue.Compare(maxHandledSize) <= 0);
-    
-    NGMP<BitCount> result;
-
-	while (!b.IsZero()) 
-    {
-		if (b.IsOdd()) 
-        {
-			result += *this;
-            // Really naive and bad modulus
-			while (result.Compare(mod) > 0)
-			   result -= mod;
-        }
-
-        b.RightShift();
-        LeftShift();
-		while (Compare(mod) > 0)
-		{
-		   *this -= mod;
-		}
-    }
-    *this = result;
+    // b may alias the instance, so work on a copy
+    *this = std::as_const(*this).MulMod(b, mod);
     return *this;
 }
 
 template <unsigned int BitCount>
 template <unsigned int OtherBitCount, unsigned int ModBitCount>
- NGMP<BitCount> NGMP<BitCount>::MulMod(NGMP<OtherBitCount> b, const NGMP<ModBitCount>& mod) const
+ NGMP<BitCount> NGMP<BitCount>::MulMod(const NGMP<OtherBitCount>& b, const NGMP<ModBitCount>& mod) const
 {
-    NGMP<BitCount * 2> maxValue = 2;
-    maxValue = maxValue.Power(ModBitCount);
-    maxValue -= 1;
-    maxValue *= 2;
+    return MulMod(*this, b, mod);
+}
 
-    NGMP<BitCount * 2> maxHandledSize = 2;
-    maxHandledSize = maxHandledSize.Power(BitCount);
-    maxHandledSize -= 1;
+template <unsigned int BitCount>
+template<unsigned int OtherBitCount, unsigned int ModBitCount>
+NGMP<BitCount> NGMP<BitCount>::MulMod(NGMP<BitCount> a, const NGMP<OtherBitCount>& b, const NGMP<ModBitCount>& mod)
+{
+    static_assert(BitCount >= ModBitCount, "Instance should handle values up to modulus - 1");
 
-    // Instance should handle (mod-1)*2
-    assert(maxValue.Compare(maxHandledSize) <= 0);
-    
-    NGMP<OtherBitCount> result;
-    NGMP a = *this;
+    // Full product over the used limbs, then a single long division
+    NGMP<BitCount + OtherBitCount> product;
+    MulLimbs(a.number, a.FindUsedLimbCount(), b.number, b.FindUsedLimbCount(), product.number);
 
-	while (!b.IsZero()) 
-    {
-		if (b.IsOdd()) 
-        {
-			result += a;
-            // Really naive and bad modulus
-			while (result.Compare(mod) > 0)
-			   result -= mod;
-        }
+    NGMP<ModBitCount> remainder;
+    product.Divide(mod, remainder);
+    return NGMP<BitCount>(remainder);
+}
 
-        b.RightShift();
-        a.LeftShift();
-		while (a.Compare(mod) > 0)
-		   a -= mod;
-    }
+template <unsigned int BitCount>
+template <unsigned int OtherBitCount, unsigned int ModBitCount>
+NGMP<BitCount>& NGMP<BitCount>::MulMod(const NGMP<OtherBitCount>& b, const BarrettContext<ModBitCount>& context)
+{
+    MulMod(*this, *this, b, context);
+    return *this;
+}
+
+template <unsigned int BitCount>
+template <unsigned int OtherBitCount, unsigned int ModBitCount>
+NGMP<BitCount> NGMP<BitCount>::MulMod(const NGMP<OtherBitCount>& b, const BarrettContext<ModBitCount>& context) const
+{
+    NGMP<BitCount> result;
+    MulMod(result, *this, b, context);
     return result;
 }
 
 template <unsigned int BitCount>
-template<unsigned int OtherBitCount, unsigned int ModBitCount>
-NGMP<BitCount> NGMP<BitCount>::MulMod(NGMP<BitCount> a, NGMP<OtherBitCount> b, const NGMP<ModBitCount>& mod)
+template <unsigned int OtherBitCount, unsigned int ModBitCount>
+NGMP<BitCount> NGMP<BitCount>::MulMod(const NGMP<BitCount>& a, const NGMP<OtherBitCount>& b, const BarrettContext<ModBitCount>& context)
 {
-   NGMP<BitCount * 2> maxValue = 2;
-    maxValue = maxValue.Power(ModBitCount);
-    maxValue -= 1;
-    maxValue *= 2;
+    NGMP<BitCount> result;
+    MulMod(result, a, b, context);
+    return result;
+}
 
-    NGMP<BitCount * 2> maxHandledSize = 2;
-    maxHandledSize = maxHandledSize.Power(BitCount);
-    maxHandledSize -= 1;
+template <unsigned int BitCount>
+template <unsigned int OtherBitCount, unsigned int ModBitCount>
+void NGMP<BitCount>::MulMod(NGMP<BitCount>& out, const NGMP<BitCount>& a, const NGMP<OtherBitCount>& b, const BarrettContext<ModBitCount>& context)
+{
+    static_assert(BitCount >= ModBitCount, "Instance should handle values up to modulus - 1");
 
-    // Instance should handle (mod-1)*2
-    assert(maxValue.Compare(maxHandledSize) <= 0);
-    
-    NGMP<OtherBitCount> result;
+    const unsigned int aLimbs = a.FindUsedLimbCount();
+    const unsigned int bLimbs = b.FindUsedLimbCount();
+    // Barrett reduction handles products below b^2k
+    assert(aLimbs <= context.modulusLimbs && bLimbs <= context.modulusLimbs);
 
-	while (!b.IsZero()) 
-    {
-		if (b.IsOdd()) 
-        {
-			result += a;
-            if (result.Compare(mod) > 0)
-			   result %= mod;
-        }
+    // Product is buffered so out may alias a or b
+    uint64_t product[2 * NGMP<ModBitCount>::MAX_LIMB_COUNT];
+    MulLimbs(a.number, aLimbs, b.number, bLimbs, product);
 
-        b.RightShift();
-        a.LeftShift();
-        if (a.Compare(mod) > 0)
-		   a %= mod;
-    }
-    return result;
+    context.Reduce(product, aLimbs + bLimbs, out.number);
+    if constexpr (BitCount > ModBitCount)
+        memset(out.number + NGMP<ModBitCount>::MAX_LIMB_COUNT, 0, (BitCount - ModBitCount) / 8);
 }
 
 #pragma endregion
@@ -118,29 +84,19 @@ NGMP<BitCount> NGMP<BitCount>::MulMod(NGMP<BitCount> a, NGMP<OtherBitCount> b, c
 #pragma region Exponentiation
 template <unsigned int BitCount>
 template <unsigned int OtherBitCount, unsigned int ModBitCount>
- NGMP<BitCount>& NGMP<BitCount>::PowMod(NGMP<OtherBitCount> b, const NGMP<ModBitCount>& mod)
+ NGMP<BitCount>& NGMP<BitCount>::PowMod(const NGMP<OtherBitCount>& b, const NGMP<ModBitCount>& mod)
 {
-    NGMP<BitCount * 2> maxValue = 2;
-    maxValue = maxValue.Power(ModBitCount);
-    maxValue -= 1;
-    maxValue = maxValue.Power(2);
-
-    NGMP<BitCount * 2> maxHandledSize = 2;
-    maxHandledSize = maxHandledSize.Power(BitCount);
-    maxHandledSize -= 1;
-
-    // Instance should handle (mod-1)^2
-    assert(maxValue.Compare(maxHandledSize) <= 0);
+    static_assert(BitCount >= ModBitCount * 2, "Instance should handle (mod-1)^2");
     
     NGMP<BitCount> result(1);
 
-	while (!b.IsZero()) 
+    const uint64_t bBits = b.FindHighestBit();
+    for (uint64_t i = 0; i < bBits; ++i)
     {
-		if (b.IsOdd()) 
-			result = NGMP<BitCount>::MulMod(*this, result, mod);
+        if (b.TestBit(i))
+            result = NGMP<BitCount>::MulMod(*this, result, mod);
 
         this->MulMod(*this, mod);
-        b.RightShift();
     }
     *this = result;
     return *this;
@@ -148,60 +104,450 @@ template <unsigned int OtherBitCount, unsigned int ModBitCount>
 
 template <unsigned int BitCount>
 template <unsigned int OtherBitCount, unsigned int ModBitCount>
- NGMP<BitCount> NGMP<BitCount>::PowMod(NGMP<OtherBitCount> b, const NGMP<ModBitCount>& mod) const
+ NGMP<BitCount> NGMP<BitCount>::PowMod(const NGMP<OtherBitCount>& b, const NGMP<ModBitCount>& mod) const
 {
-    NGMP<BitCount * 2> maxValue = 2;
-    maxValue = maxValue.Power(ModBitCount);
-    maxValue -= 1;
-    maxValue = maxValue.Power(2);
-
-    NGMP<BitCount * 2> maxHandledSize = 2;
-    maxHandledSize = maxHandledSize.Power(BitCount);
-    maxHandledSize -= 1;
-
-    // Instance should handle (mod-1)^2
-    assert(maxValue.Compare(maxHandledSize) <= 0);
+    static_assert(BitCount >= ModBitCount * 2, "Instance should handle (mod-1)^2");
     
     NGMP<BitCount> result(1);
     NGMP<BitCount> a(*this);
 
-	while (!b.IsZero()) 
+    const uint64_t bBits = b.FindHighestBit();
+    for (uint64_t i = 0; i < bBits; ++i)
     {
-		if (b.IsOdd()) 
-			result = NGMP<BitCount>::MulMod(a, result, mod);
+        if (b.TestBit(i))
+            result = NGMP<BitCount>::MulMod(a, result, mod);
 
         a.MulMod(a, mod);
-        b.RightShift();
     }
     return result;
 }
 
 template <unsigned int BitCount>
 template<unsigned int OtherBitCount, unsigned int ModBitCount>
-NGMP<BitCount> NGMP<BitCount>::PowMod(NGMP<BitCount> a, NGMP<OtherBitCount> b, const NGMP<ModBitCount>& mod)
+NGMP<BitCount> NGMP<BitCount>::PowMod(NGMP<BitCount> a, const NGMP<OtherBitCount>& b, const NGMP<ModBitCount>& mod)
 {
-    NGMP<BitCount * 2> maxValue = 2;
-    maxValue = maxValue.Power(ModBitCount);
-    maxValue -= 1;
-    maxValue = maxValue.Power(2);
-
-    NGMP<BitCount * 2> maxHandledSize = 2;
-    maxHandledSize = maxHandledSize.Power(BitCount);
-    maxHandledSize -= 1;
-
-    // Instance should handle (mod-1)^2
-    assert(maxValue.Compare(maxHandledSize) <= 0);
+    static_assert(BitCount >= ModBitCount * 2, "Instance should handle (mod-1)^2");
     
     NGMP<BitCount> result(1);
 
-	while (!b.IsZero()) 
+    const uint64_t bBits = b.FindHighestBit();
+    for (uint64_t i = 0; i < bBits; ++i)
     {
-		if (b.IsOdd()) 
-			result = NGMP<BitCount>::MulMod(a, result, mod);
+        if (b.TestBit(i))
+            result = NGMP<BitCount>::MulMod(a, result, mod);
 
         a.MulMod(a, mod);
-        b.RightShift();
     }
     return result;
 }
-#pragma endregion 
\ No newline at end of file
+template <unsigned int BitCount>
+template<unsigned int OtherBitCount, unsigned int ModBitCount>
+NGMP<BitCount> NGMP<BitCount>::PowMod(const NGMP<BitCount>& a, const NGMP<OtherBitCount>& b, const BarrettContext<ModBitCount>& context)
+{
+    NGMP<BitCount> result(1);
+    NGMP<BitCount> base(a);
+    if (base.Compare(context.GetModulus()) >= 0)
+        base %= context.GetModulus();
+
+    const uint64_t bBits = b.FindHighestBit();
+    for (uint64_t i = 0; i < bBits; ++i)
+    {
+        if (b.TestBit(i))
+            MulMod(result, result, base, context);
+
+        MulMod(base, base, base, context);
+    }
+    return result;
+}
+
+template <unsigned int BitCount>
+template<unsigned int OtherBitCount, unsigned int ModBitCount>
+NGMP<BitCount> NGMP<BitCount>::PowMod(const NGMP<BitCount>& a, const NGMP<OtherBitCount>& b, const MontgomeryContext<ModBitCount>& context)
+{
+    return PowMod(a, b, b.FindHighestBit(), context);
+}
+
+template <unsigned int BitCount>
+template<unsigned int OtherBitCount, unsigned int ModBitCount>
+NGMP<BitCount> NGMP<BitCount>::PowMod(const NGMP<BitCount>& a, const NGMP<OtherBitCount>& b, uint64_t exponentBits, const MontgomeryContext<ModBitCount>& context)
+{
+    assert(exponentBits <= OtherBitCount);
+    static_assert(BitCount >= ModBitCount, "Instance should handle values up to modulus - 1");
+    const unsigned int WINDOW_BITS = 4;
+    const unsigned int WINDOW_SIZE = 1 << WINDOW_BITS;
+    const unsigned int k = context.modulusLimbs;
+
+    NGMP<ModBitCount> base(a);
+    if (a.FindUsedLimbCount() > k || base.Compare(context.GetModulus()) >= 0)
+        base = NGMP<ModBitCount>(a % context.GetModulus());
+
+    // table[i] = base ^ i in Montgomery form
+    uint64_t table[WINDOW_SIZE][NGMP<ModBitCount>::MAX_LIMB_COUNT];
+    memcpy(table[0], context.ToMontgomery(NGMP<ModBitCount>(1)).number, k * 8);
+    memcpy(table[1], context.ToMontgomery(base).number, k * 8);
+    for (unsigned int i = 2; i < WINDOW_SIZE; ++i)
+        context.Multiply(table[i - 1], table[1], table[i]);
+
+    uint64_t accumulator[NGMP<ModBitCount>::MAX_LIMB_COUNT];
+    uint64_t factor[NGMP<ModBitCount>::MAX_LIMB_COUNT];
+    memcpy(accumulator, table[0], k * 8);
+
+    const uint64_t windows = (exponentBits + WINDOW_BITS - 1) / WINDOW_BITS;
+    for (uint64_t window = windows; window-- > 0;)
+    {
+        for (unsigned int i = 0; i < WINDOW_BITS; ++i)
+            context.Multiply(accumulator, accumulator, accumulator);
+
+        const uint64_t bit = window * WINDOW_BITS;
+        const uint64_t digit = (b.number[bit / 64] >> (bit % 64)) & (WINDOW_SIZE - 1);
+        for (unsigned int i = 0; i < k; ++i)
+            factor[i] = 0;
+        for (uint64_t entry = 0; entry < WINDOW_SIZE; ++entry)
+        {
+            const uint64_t mask = 0 - static_cast<uint64_t>(entry == digit);
+            for (unsigned int i = 0; i < k; ++i)
+                factor[i] |= table[entry][i] & mask;
+        }
+        context.Multiply(accumulator, factor, accumulator);
+    }
+
+    NGMP<ModBitCount> montgomery;
+    memcpy(montgomery.number, accumulator, k * 8);
+    return NGMP<BitCount>(context.FromMontgomery(montgomery));
+}
+#pragma endregion
+
+#pragma region Number Theory
+template <unsigned int BitCount>
+template <unsigned int ModBitCount>
+int NGMP<BitCount>::Jacobi(const NGMP<ModBitCount>& n) const
+{
+    assert(n.IsOdd());
+    const unsigned int limbCount = NGMP<ModBitCount>::MAX_LIMB_COUNT;
+
+    // Raw limb buffers swapped by pointer, sizes track the used limbs as values shrink.
+    // One spare limb takes the carry of a + m.
+    const NGMP<ModBitCount> reduced(*this % n);
+    uint64_t bufferA[limbCount + 1];
+    uint64_t bufferM[limbCount + 1];
+    memcpy(bufferA, reduced.number, limbCount * 8);
+    memcpy(bufferM, n.number, limbCount * 8);
+    uint64_t* a = bufferA;
+    uint64_t* m = bufferM;
+    unsigned int aSize = reduced.FindUsedLimbCount();
+    unsigned int mSize = n.FindUsedLimbCount();
+    int symbol = 1;
+
+    // Divides a by its largest power of two, (2 / m) = -1 exactly when m = 3 or 5 mod 8
+    auto stripTwos = [&]()
+    {
+        if ((StripTrailingZeros(a, aSize) & 1) && ((m[0] & 7) == 3 || (m[0] & 7) == 5))
+            symbol = -symbol;
+    };
+
+    if (aSize)
+        stripTwos();
+
+    while (aSize)
+    {
+        // Both odd, order them so a > m; reciprocity flips the sign when both are 3 mod 4
+        int order = aSize == mSize ? 0 : (aSize > mSize ? 1 : -1);
+        for (int i = static_cast<int>(aSize) - 1; order == 0 && i >= 0; --i)
+        {
+            if (a[i] != m[i])
+                order = a[i] > m[i] ? 1 : -1;
+        }
+        if (order == 0)
+            break;
+        if (order < 0)
+        {
+            std::swap(a, m);
+            std::swap(aSize, mSize);
+            if ((a[0] & 3) == 3 && (m[0] & 3) == 3)
+                symbol = -symbol;
+        }
+
+        // One of a - m and a + m is a multiple of 4, both are congruent to a mod m.
+        // Taking that one removes at least two bits per step; (a + m) / 4 < a since a > m.
+        const bool add = ((a[0] - m[0]) & 3) != 0;
+        uint64_t low;
+        uint8_t carry = add ? AddCarry(0, a[0], m[0], low) : SubBorrow(0, a[0], m[0], low);
+
+        if (low == 0)
+        {
+            // Rare: the low limb cancels, so the shift is not known up front
+            a[0] = 0;
+            for (unsigned int i = 1; i < aSize; ++i)
+            {
+                const uint64_t mLimb = i < mSize ? m[i] : 0;
+                carry = add ? AddCarry(carry, a[i], mLimb, a[i]) : SubBorrow(carry, a[i], mLimb, a[i]);
+            }
+            a[aSize] = add ? carry : 0;
+            aSize += a[aSize] != 0;
+            while (aSize && a[aSize - 1] == 0)
+                --aSize;
+            if (aSize)
+                stripTwos();
+            continue;
+        }
+
+        // Add or subtract and shift in the same pass
+        const unsigned int shift = CountTrailingZeros(low);
+        if (((shift & 1) != 0) && ((m[0] & 7) == 3 || (m[0] & 7) == 5))
+            symbol = -symbol;
+
+        uint64_t previous = low;
+        uint64_t current;
+        if (add)
+        {
+            for (unsigned int i = 1; i < aSize; ++i)
+            {
+                carry = AddCarry(carry, a[i], i < mSize ? m[i] : 0, current);
+                a[i - 1] = (previous >> shift) | (current << (64 - shift));
+                previous = current;
+            }
+        }
+        else
+        {
+            for (unsigned int i = 1; i < aSize; ++i)
+            {
+                carry = SubBorrow(carry, a[i], i < mSize ? m[i] : 0, current);
+                a[i - 1] = (previous >> shift) | (current << (64 - shift));
+                previous = current;
+            }
+        }
+        // a > m, so only the addition can carry out
+        const uint64_t top = add ? carry : 0;
+        a[aSize - 1] = (previous >> shift) | (top << (64 - shift));
+        while (aSize && a[aSize - 1] == 0)
+            --aSize;
+    }
+
+    // Stopped on a == m or a == 0, either way m is gcd(a, n) and the symbol needs it to be 1
+    return (mSize == 1 && m[0] == 1) ? symbol : 0;
+}
+
+template <unsigned int BitCount>
+template <unsigned int ModBitCount>
+NGMP<ModBitCount> NGMP<BitCount>::ModInverse(const NGMP<ModBitCount>& n) const
+{
+    NGMP<ModBitCount> result;
+    const NGMP<ModBitCount> reduced(*this % n);
+    if (reduced.IsZero())
+        return result;
+    if (reduced == 1)
+        return NGMP<ModBitCount>(1);
+
+    if (!n.IsOdd())
+    {
+        // a^-1 mod n = (1 + n * (a - y)) / a with y = n^-1 mod a, and a is odd whenever it is invertible
+        if (!reduced.IsOdd())
+            return result;
+        const NGMP<ModBitCount> y = n.ModInverse(reduced);
+        if (y.IsZero())
+            return result;
+
+        NGMP<ModBitCount * 2> numerator;
+        NGMP<ModBitCount * 2>::MulAdd(numerator, NGMP<ModBitCount * 2>(n), NGMP<ModBitCount * 2>(reduced - y), NGMP<ModBitCount * 2>(1));
+        return NGMP<ModBitCount>(numerator / reduced);
+    }
+
+    // Invariants: reduced * x1 = u and reduced * x2 = v mod n, u and v shrink to gcd(reduced, n)
+    const unsigned int limbCount = NGMP<ModBitCount>::MAX_LIMB_COUNT;
+    const unsigned int k = n.FindUsedLimbCount();
+    const uint64_t* modulus = n.number;
+    uint64_t u[limbCount], v[limbCount], x1[limbCount] = {1}, x2[limbCount] = {0};
+    memcpy(u, reduced.number, k * 8);
+    memcpy(v, modulus, k * 8);
+    unsigned int uSize = reduced.FindUsedLimbCount();
+    unsigned int vSize = k;
+
+    // n^-1 mod 2^64 by Newton iteration, each step doubles the correct low bits
+    uint64_t nInverse = 1;
+    for (int i = 0; i < 6; ++i)
+        nInverse *= 2 - modulus[0] * nInverse;
+
+    // x = x / 2^shift mod n, up to 63 bits per pass: adding m * n clears the low bits and (x + m * n) / 2^s stays below n
+    auto halve = [&](uint64_t* x, uint64_t shift)
+    {
+        while (shift)
+        {
+            const unsigned int s = static_cast<unsigned int>(std::min<uint64_t>(shift, 63));
+            const uint64_t m = (0 - x[0] * nInverse) & ((uint64_t(1) << s) - 1);
+
+            uint64_t carry = 0;
+            for (unsigned int i = 0; i < k; ++i)
+            {
+                uint64_t high;
+                uint64_t low = MulLimb(m, modulus[i], high);
+                low += carry;
+                high += low < carry;
+                carry = high + AddCarry(0, x[i], low, x[i]);
+            }
+            for (unsigned int i = 0; i + 1 < k; ++i)
+                x[i] = (x[i] >> s) | (x[i + 1] << (64 - s));
+            x[k - 1] = (x[k - 1] >> s) | (carry << (64 - s));
+            shift -= s;
+        }
+    };
+
+    // x = x - y mod n
+    auto subtract = [&](uint64_t* x, const uint64_t* y)
+    {
+        uint8_t borrow = 0;
+        for (unsigned int i = 0; i < k; ++i)
+            borrow = SubBorrow(borrow, x[i], y[i], x[i]);
+        if (borrow)
+        {
+            uint8_t carry = 0;
+            for (unsigned int i = 0; i < k; ++i)
+                carry = AddCarry(carry, x[i], modulus[i], x[i]);
+        }
+    };
+
+    halve(x1, StripTrailingZeros(u, uSize));
+    for (;;)
+    {
+        // Both odd, the larger one takes the difference, which is even
+        int order = uSize == vSize ? 0 : (uSize > vSize ? 1 : -1);
+        for (int i = static_cast<int>(uSize) - 1; order == 0 && i >= 0; --i)
+        {
+            if (u[i] != v[i])
+                order = u[i] > v[i] ? 1 : -1;
+        }
+        if (order == 0)
+            break;
+
+        uint64_t* larger = order > 0 ? u : v;
+        const uint64_t* smaller = order > 0 ? v : u;
+        unsigned int& largerSize = order > 0 ? uSize : vSize;
+        const unsigned int smallerSize = order > 0 ? vSize : uSize;
+        uint64_t* coefficient = order > 0 ? x1 : x2;
+
+        uint8_t borrow = 0;
+        for (unsigned int i = 0; i < largerSize; ++i)
+            borrow = SubBorrow(borrow, larger[i], i < smallerSize ? smaller[i] : 0, larger[i]);
+        while (larger[largerSize - 1] == 0)
+            --largerSize;
+
+        subtract(coefficient, order > 0 ? x2 : x1);
+        halve(coefficient, StripTrailingZeros(larger, largerSize));
+    }
+
+    // Stopped on u == v == gcd
+    if (uSize == 1 && u[0] == 1)
+        memcpy(result.number, x1, k * 8);
+    return result;
+}
+
+template <unsigned int BitCount>
+template <unsigned int ModBitCount>
+NGMP<ModBitCount> NGMP<BitCount>::ModInverseConstantTime(const NGMP<ModBitCount>& n) const
+{
+    assert(n.IsOdd());
+    assert(FindUsedLimbCount() <= n.FindUsedLimbCount());
+    const NGMP<ModBitCount> a(*this);
+    assert(a.Compare(n) < 0);
+
+    // Same invariants as ModInverse, but every step runs both branches and selects with masks.
+    // Each step shortens u or v by a bit until u reaches 0, so 2 * bits(n) steps always suffice.
+    const unsigned int limbCount = NGMP<ModBitCount>::MAX_LIMB_COUNT;
+    const unsigned int k = n.FindUsedLimbCount();
+    const uint64_t* modulus = n.number;
+    uint64_t u[limbCount], v[limbCount], x1[limbCount] = {1}, x2[limbCount] = {0}, difference[limbCount];
+    memcpy(u, a.number, k * 8);
+    memcpy(v, modulus, k * 8);
+
+    const uint64_t steps = 2 * n.FindHighestBit();
+    for (uint64_t step = 0; step < steps; ++step)
+    {
+        const uint64_t odd = 0 - (u[0] & 1);
+
+        // Swap when u is odd and below v, so the subtraction below never goes negative
+        uint8_t borrow = 0;
+        for (unsigned int i = 0; i < k; ++i)
+            borrow = SubBorrow(borrow, u[i], v[i], difference[i]);
+        const uint64_t swap = odd & (0 - static_cast<uint64_t>(borrow));
+        for (unsigned int i = 0; i < k; ++i)
+        {
+            const uint64_t t = (u[i] ^ v[i]) & swap;
+            u[i] ^= t;
+            v[i] ^= t;
+            const uint64_t tx = (x1[i] ^ x2[i]) & swap;
+            x1[i] ^= tx;
+            x2[i] ^= tx;
+        }
+
+        // When u is odd: u -= v, x1 -= x2 mod n
+        borrow = 0;
+        for (unsigned int i = 0; i < k; ++i)
+        {
+            borrow = SubBorrow(borrow, u[i], v[i], difference[i]);
+            u[i] = (difference[i] & odd) | (u[i] & ~odd);
+        }
+        borrow = 0;
+        for (unsigned int i = 0; i < k; ++i)
+            borrow = SubBorrow(borrow, x1[i], x2[i], difference[i]);
+        const uint64_t wrap = 0 - static_cast<uint64_t>(borrow);
+        uint8_t carry = 0;
+        for (unsigned int i = 0; i < k; ++i)
+        {
+            carry = AddCarry(carry, difference[i], modulus[i] & wrap, difference[i]);
+            x1[i] = (difference[i] & odd) | (x1[i] & ~odd);
+        }
+
+        // u is even now: u /= 2, x1 = x1 / 2 mod n
+        for (unsigned int i = 0; i + 1 < k; ++i)
+            u[i] = (u[i] >> 1) | (u[i + 1] << 63);
+        u[k - 1] >>= 1;
+
+        const uint64_t add = 0 - (x1[0] & 1);
+        carry = 0;
+        for (unsigned int i = 0; i < k; ++i)
+            carry = AddCarry(carry, x1[i], modulus[i] & add, x1[i]);
+        for (unsigned int i = 0; i + 1 < k; ++i)
+            x1[i] = (x1[i] >> 1) | (x1[i + 1] << 63);
+        x1[k - 1] = (x1[k - 1] >> 1) | (static_cast<uint64_t>(carry) << 63);
+    }
+
+    // v holds the gcd, the result is masked to 0 unless it is 1
+    uint64_t notOne = v[0] ^ 1;
+    for (unsigned int i = 1; i < k; ++i)
+        notOne |= v[i];
+    const uint64_t keep = ((notOne | (0 - notOne)) >> 63) - 1;
+
+    NGMP<ModBitCount> result;
+    for (unsigned int i = 0; i < k; ++i)
+        result.number[i] = x2[i] & keep;
+    return result;
+}
+
+template <unsigned int BitCount>
+template <unsigned int ModBitCount>
+bool NGMP<BitCount>::BatchModInverse(NGMP* values, uint64_t count, const BarrettContext<ModBitCount>& context)
+{
+    if (count == 0)
+        return true;
+
+    // prefix[i] = values[0] * ... * values[i]
+    std::vector<NGMP> prefix(count);
+    prefix[0] = values[0];
+    for (uint64_t i = 1; i < count; ++i)
+        MulMod(prefix[i], prefix[i - 1], values[i], context);
+
+    NGMP inverse(prefix[count - 1].ModInverse(context.GetModulus()));
+    if (inverse.IsZero())
+        return false;
+
+    // inverse holds (values[0] * ... * values[i])^-1 on entry of step i
+    for (uint64_t i = count - 1; i > 0; --i)
+    {
+        NGMP valueInverse;
+        MulMod(valueInverse, inverse, prefix[i - 1], context);
+        MulMod(inverse, inverse, values[i], context);
+        values[i] = valueInverse;
+    }
+    values[0] = inverse;
+    return true;
+}
+#pragma endregion
@@ -0,0 +1,141 @@
+#pragma once
+
+/**
+ * \brief Precomputed Montgomery multiplication for a fixed odd modulus
+ * \tparam ModBitCount size of modulus in bits
+ *
+ * Works with R = b^k, b = 2^64 and k the used limb count of the modulus.
+ * Values are moved into Montgomery form x * R mod m once, after which every
+ * product is reduced limb by limb (CIOS) with a single final subtraction,
+ * done with a mask so the running time does not depend on the operands.
+ */
+template<unsigned int ModBitCount>
+class MontgomeryContext
+{
+    template<unsigned int BitCount>
+    friend class NGMP;
+
+private:
+    static const unsigned int MAX_LIMB_COUNT = ModBitCount / 64;
+
+    NGMP<ModBitCount>   modulus;
+    unsigned int        modulusLimbs;
+    // -modulus^-1 mod b
+    uint64_t            n0;
+    // R^2 mod modulus, turns a plain value into Montgomery form with one product
+    NGMP<ModBitCount>   rSquared;
+
+    /**
+     * \brief Montgomery product of raw limb arrays
+     * \param a,b modulusLimbs limbs each, below the modulus
+     * \param out receives a * b / R mod modulus, modulusLimbs limbs, may alias a or b
+     */
+    void Multiply(const uint64_t* a, const uint64_t* b, uint64_t* out) const;
+
+public:
+    // Throws std::invalid_argument when the modulus is even
+    explicit MontgomeryContext(const NGMP<ModBitCount>& p_modulus);
+    ~MontgomeryContext() = default;
+
+    const NGMP<ModBitCount>& GetModulus() const
+    {
+        return modulus;
+    }
+
+    // x * R mod modulus, x must be below the modulus
+    NGMP<ModBitCount> ToMontgomery(const NGMP<ModBitCount>& x) const;
+    // x / R mod modulus
+    NGMP<ModBitCount> FromMontgomery(const NGMP<ModBitCount>& x) const;
+    // a * b / R mod modulus, both in Montgomery form
+    NGMP<ModBitCount> Multiply(const NGMP<ModBitCount>& a, const NGMP<ModBitCount>& b) const;
+};
+
+template <unsigned int ModBitCount>
+MontgomeryContext<ModBitCount>::MontgomeryContext(const NGMP<ModBitCount>& p_modulus) :
+    modulus(p_modulus), modulusLimbs(p_modulus.FindUsedLimbCount()), n0(0)
+{
+    if (!p_modulus.IsOdd())
+        throw std::invalid_argument("Montgomery reduction modulus must be odd");
+
+    // Newton iteration doubles the correct low bits of the inverse each step, 1 -> 64 bits
+    uint64_t inverse = 1;
+    for (int i = 0; i < 6; ++i)
+        inverse *= 2 - modulus.number[0] * inverse;
+    n0 = 0 - inverse;
+
+    NGMP<ModBitCount * 2 + 64> r(1);
+    r.LeftShift(2 * 64 * uint64_t(modulusLimbs));
+    rSquared = NGMP<ModBitCount>(r % modulus);
+}
+
+template <unsigned int ModBitCount>
+void MontgomeryContext<ModBitCount>::Multiply(const uint64_t* a, const uint64_t* b, uint64_t* out) const
+{
+    const unsigned int k = modulusLimbs;
+    const uint64_t* m = modulus.number;
+    uint64_t t[MAX_LIMB_COUNT + 2] = {0};
+
+    for (unsigned int i = 0; i < k; ++i)
+    {
+        // t += a * b[i]
+        uint64_t carry = 0;
+        for (unsigned int j = 0; j < k; ++j)
+        {
+            uint64_t high;
+            uint64_t low = NGMP<ModBitCount>::MulLimb(a[j], b[i], high);
+            low += carry;
+            high += low < carry;
+            carry = high + NGMP<ModBitCount>::AddCarry(0, t[j], low, t[j]);
+        }
+        t[k + 1] = NGMP<ModBitCount>::AddCarry(0, t[k], carry, t[k]);
+
+        // t = (t + q * m) / b, q chosen so the low limb cancels
+        const uint64_t q = t[0] * n0;
+        uint64_t high;
+        uint64_t low = NGMP<ModBitCount>::MulLimb(q, m[0], high);
+        carry = high + NGMP<ModBitCount>::AddCarry(0, t[0], low, low);
+        for (unsigned int j = 1; j < k; ++j)
+        {
+            low = NGMP<ModBitCount>::MulLimb(q, m[j], high);
+            low += carry;
+            high += low < carry;
+            carry = high + NGMP<ModBitCount>::AddCarry(0, t[j], low, t[j - 1]);
+        }
+        const uint8_t top = NGMP<ModBitCount>::AddCarry(0, t[k], carry, t[k - 1]);
+        t[k] = t[k + 1] + top;
+    }
+
+    // t < 2 * modulus, subtract once when t[k] is set or the subtraction does not borrow
+    uint64_t reduced[MAX_LIMB_COUNT];
+    uint8_t borrow = 0;
+    for (unsigned int i = 0; i < k; ++i)
+        borrow = NGMP<ModBitCount>::SubBorrow(borrow, t[i], m[i], reduced[i]);
+    const uint64_t keep = 0 - static_cast<uint64_t>(borrow & (t[k] == 0));
+    for (unsigned int i = 0; i < k; ++i)
+        out[i] = (t[i] & keep) | (reduced[i] & ~keep);
+}
+
+template <unsigned int ModBitCount>
+NGMP<ModBitCount> MontgomeryContext<ModBitCount>::ToMontgomery(const NGMP<ModBitCount>& x) const
+{
+    NGMP<ModBitCount> result;
+    Multiply(x.number, rSquared.number, result.number);
+    return result;
+}
+
+template <unsigned int ModBitCount>
+NGMP<ModBitCount> MontgomeryContext<ModBitCount>::FromMontgomery(const NGMP<ModBitCount>& x) const
+{
+    NGMP<ModBitCount> one(1);
+    NGMP<ModBitCount> result;
+    Multiply(x.number, one.number, result.number);
+    return result;
+}
+
+template <unsigned int ModBitCount>
+NGMP<ModBitCount> MontgomeryContext<ModBitCount>::Multiply(const NGMP<ModBitCount>& a, const NGMP<ModBitCount>& b) const
+{
+    NGMP<ModBitCount> result;
+    Multiply(a.number, b.number, result.number);
+    return result;
+}
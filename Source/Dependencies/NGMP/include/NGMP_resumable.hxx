@@ -0,0 +1,117 @@
+#pragma once
+
+/**
+ * \brief Modular exponentiation that can be suspended between exponent windows
+ * \tparam BitCount size of base and result in bits
+ * \tparam ExponentBitCount size of exponent in bits
+ * \tparam ModBitCount size of modulus in bits
+ *
+ * Runs the same fixed 4-bit window Montgomery ladder as NGMP::PowMod with a Montgomery context,
+ * but Step only processes a bounded number of windows, so an event loop can
+ * interleave many exponentiations with other work and keep each slice short.
+ * Every window costs four squarings and one multiplication, and all ExponentBitCount bits
+ * are processed, so neither the exponent bits nor its length affect the running time.
+ * The context must outlive the task. The destructor wipes the exponent and every intermediate.
+ */
+template<unsigned int BitCount, unsigned int ExponentBitCount, unsigned int ModBitCount>
+class ResumablePowMod
+{
+    static_assert(BitCount >= ModBitCount, "Instance should handle values up to modulus - 1");
+
+private:
+    static constexpr unsigned int WINDOW_BITS   = 4;
+    static constexpr unsigned int WINDOW_SIZE   = 1 << WINDOW_BITS;
+    static constexpr uint64_t     WINDOW_COUNT  = (ExponentBitCount + WINDOW_BITS - 1) / WINDOW_BITS;
+
+    const MontgomeryContext<ModBitCount>*   context;
+    // base ^ i in Montgomery form
+    NGMP<ModBitCount>                       table[WINDOW_SIZE];
+    // Montgomery form, holds base ^ (exponent windows processed so far)
+    NGMP<ModBitCount>                       accumulator;
+    NGMP<BitCount>                          result;
+    NGMP<ExponentBitCount>                  exponent;
+    // Windows are processed from the most significant one down
+    uint64_t                                nextWindow;
+    unsigned int                            limbCount;
+
+public:
+    ResumablePowMod(const NGMP<BitCount>& p_base, const NGMP<ExponentBitCount>& p_exponent, const MontgomeryContext<ModBitCount>& p_context) :
+        context(&p_context), exponent(p_exponent), nextWindow(0), limbCount(p_context.GetModulus().FindUsedLimbCount())
+    {
+        NGMP<ModBitCount> base(p_base);
+        if (p_base.FindUsedLimbCount() > limbCount || base.Compare(p_context.GetModulus()) >= 0)
+            base = NGMP<ModBitCount>(p_base % p_context.GetModulus());
+
+        table[0] = p_context.ToMontgomery(NGMP<ModBitCount>(1));
+        table[1] = p_context.ToMontgomery(base);
+        for (unsigned int i = 2; i < WINDOW_SIZE; ++i)
+            table[i] = p_context.Multiply(table[i - 1], table[1]);
+        accumulator = table[0];
+        base.Wipe();
+    }
+
+    ~ResumablePowMod()
+    {
+        for (NGMP<ModBitCount>& entry : table)
+            entry.Wipe();
+        accumulator.Wipe();
+        result.Wipe();
+        exponent.Wipe();
+    }
+
+    /**
+     * \brief Advances the exponentiation
+     * \param maxWindows upper bound on 4-bit exponent windows processed by this call
+     * \return true once the result is available
+     */
+    bool Step(uint64_t maxWindows)
+    {
+        const uint64_t end = std::min(WINDOW_COUNT, nextWindow + maxWindows);
+        NGMP<ModBitCount> factor;
+        uint64_t* selected = factor.Get64BitArray();
+
+        for (; nextWindow < end; ++nextWindow)
+        {
+            for (unsigned int i = 0; i < WINDOW_BITS; ++i)
+                accumulator = context->Multiply(accumulator, accumulator);
+
+            const uint64_t bit = (WINDOW_COUNT - 1 - nextWindow) * WINDOW_BITS;
+            const uint64_t digit = (exponent.Get64BitArray()[bit / 64] >> (bit % 64)) & (WINDOW_SIZE - 1);
+
+            // Every entry is read so the access pattern does not depend on the exponent
+            for (unsigned int i = 0; i < limbCount; ++i)
+                selected[i] = 0;
+            for (uint64_t entry = 0; entry < WINDOW_SIZE; ++entry)
+            {
+                const uint64_t mask = 0 - static_cast<uint64_t>(entry == digit);
+                const uint64_t* limbs = table[entry].Get64BitArray();
+                for (unsigned int i = 0; i < limbCount; ++i)
+                    selected[i] |= limbs[i] & mask;
+            }
+            accumulator = context->Multiply(accumulator, factor);
+
+            if (nextWindow + 1 == WINDOW_COUNT)
+                result = NGMP<BitCount>(context->FromMontgomery(accumulator));
+        }
+
+        factor.Wipe();
+        return IsDone();
+    }
+
+    bool IsDone() const
+    {
+        return nextWindow >= WINDOW_COUNT;
+    }
+
+    uint64_t GetRemainingWindows() const
+    {
+        return WINDOW_COUNT - nextWindow;
+    }
+
+    // Only meaningful once IsDone
+    const NGMP<BitCount>& GetResult() const
+    {
+        assert(IsDone());
+        return result;
+    }
+};
@@ -2,10 +2,32 @@
 
 // KeyExchange
 #include "NGCrypto/KeyExchange/DiffieHellman.h"
+#include "NGCrypto/KeyExchange/DiffieHellmanGroup.h"
+#include "NGCrypto/KeyExchange/KeyPairPool.h"
+#include "NGCrypto/KeyExchange/X25519.h"
 
 // Hashing
 #include "NGCrypto/Hash/SHA256.h"
 #include "NGCrypto/Hash/HMAC.h"
 
 // Encryption
-#include "NGCrypto/Encryption/AES.h"
\ No newline at end of file
+#include "NGCrypto/Encryption/AES.h"
+#include "NGCrypto/Encryption/EncryptThenMAC.h"
+
+// Signature
+#include "NGCrypto/Signature/RSA.h"
+
+// Random
+#include "NGCrypto/Random/CtrDrbg.h"
+#include "NGCrypto/Random/PrimeGenerator.h"
+
+// Async
+#include "NGCrypto/Async/JobScheduler.h"
+
+// Utils
+#include "NGCrypto/Utils/BoundedQueue.h"
+#include "NGCrypto/Utils/CpuFeatures.h"
+#include "NGCrypto/Utils/Instrumentation.h"
+#include "NGCrypto/Utils/MpscQueue.h"
+#include "NGCrypto/Utils/SecureArena.h"
+#include "NGCrypto/Utils/ThreadPool.h"
\ No newline at end of file
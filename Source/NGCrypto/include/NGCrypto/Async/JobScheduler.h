@@ -0,0 +1,154 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "NGCrypto/export.h"
+#include "NGCrypto/Encryption/AES.h"
+#include "NGCrypto/Utils/MpscQueue.h"
+
+#pragma warning(push)
+#pragma warning(disable: 4251)
+
+namespace Cryptography
+{
+    namespace Async
+    {
+        enum class Algorithm : uint8_t
+        {
+            EncryptECB,
+            DecryptECB,
+            SHA256,
+            HMACSHA256,
+            Count
+        };
+
+        /**
+         * One unit of work, the caller keeps every buffer alive until its completion runs.
+         * AES jobs write the input length rounded up to whole blocks, hash jobs write 32 bytes.
+         */
+        struct NG_CRYPTO_API Job
+        {
+            Algorithm                   algorithm;
+            const Encryption::AES*      cipher;
+            const unsigned char*        key;
+            uint64_t                    keyLength;
+            const unsigned char*        input;
+            uint64_t                    size;
+            uint8_t*                    output;
+
+            static Job EncryptECB(const Encryption::AES& p_cipher, const unsigned char* p_data, uint8_t* p_out, uint64_t p_dataLength);
+            static Job DecryptECB(const Encryption::AES& p_cipher, const unsigned char* p_data, uint8_t* p_out, uint64_t p_dataLength);
+            static Job SHA256(const unsigned char* p_message, uint64_t p_size, uint8_t* p_digest);
+            static Job HMACSHA256(const unsigned char* p_key, uint64_t p_keyLength,
+                                  const unsigned char* p_message, uint64_t p_size, uint8_t* p_mac);
+        };
+
+        /**
+         * Collects AES, SHA256 and HMAC jobs submitted one at a time and runs them in batches.
+         * Each worker thread owns a lock-free queue fed by the producer threads assigned to it.
+         * Pending jobs are grouped by algorithm and size class; a group goes to the batch kernel
+         * of its algorithm once it holds MAX_BATCH jobs, or once its oldest job has waited for the
+         * latency budget. Jobs of the largest size class gain nothing from batching and run at once.
+         * Completions run on the worker thread, in submission order within a batch, and must not throw.
+         */
+        class NG_CRYPTO_API JobScheduler
+        {
+        public:
+            using Callback = std::function<void()>;
+
+            static const uint32_t MAX_BATCH = 16;
+            // Classes by padded block count: 1, 2, 3-4, 5-8, ..., 33-64 and anything longer
+            static const uint32_t SIZE_CLASS_COUNT = 8;
+
+            struct Statistics
+            {
+                uint64_t completed;
+                uint64_t batches;
+                // Batches dispatched because the latency budget ran out before they were full
+                uint64_t timedFlushes;
+                // Jobs run on the submitting thread because the worker queue was full
+                uint64_t inlineJobs;
+            };
+
+        private:
+            using TimePoint = std::chrono::steady_clock::time_point;
+
+            struct PendingJob
+            {
+                Job         job;
+                Callback    callback;
+            };
+
+            struct Group
+            {
+                uint32_t    count = 0;
+                TimePoint   oldest;
+                PendingJob  jobs[MAX_BATCH];
+            };
+
+            struct Worker
+            {
+                Utils::MpscQueue<PendingJob>    queue;
+                Group                           groups[static_cast<uint32_t>(Algorithm::Count)][SIZE_CLASS_COUNT];
+                std::atomic<bool>               sleeping {false};
+                std::mutex                      mutex;
+                std::condition_variable         condition;
+                std::thread                     thread;
+
+                // Only the worker thread writes these
+                std::atomic<uint64_t>           completed {0};
+                std::atomic<uint64_t>           batches {0};
+                std::atomic<uint64_t>           timedFlushes {0};
+
+                explicit Worker(uint64_t p_queueCapacity) : queue(p_queueCapacity) {}
+            };
+
+            std::vector<std::unique_ptr<Worker>>    m_workers;
+            const std::chrono::nanoseconds          m_latencyBudget;
+            std::atomic<bool>                       m_stopping {false};
+            std::atomic<uint64_t>                   m_inlineJobs {0};
+
+            void WorkerLoop(Worker& p_worker);
+            void AddToGroup(Worker& p_worker, PendingJob& p_pending);
+            // Dispatches the groups that have waited p_budget or longer, returns when the next one is due
+            TimePoint FlushExpired(Worker& p_worker, TimePoint p_now, std::chrono::nanoseconds p_budget);
+            // Dispatches every partial group on shutdown, not counted as timed flushes
+            void FlushAll(Worker& p_worker);
+            void Dispatch(Worker& p_worker, Algorithm p_algorithm, Group& p_group);
+
+            static uint32_t GetSizeClass(const Job& p_job);
+            // Runs p_count jobs of one algorithm through its batch kernel
+            static void     RunBatch(Algorithm p_algorithm, const PendingJob* p_jobs, uint32_t p_count);
+
+        public:
+            /**
+             * \param p_workerCount worker threads, each producer thread always feeds the same one
+             * \param p_latencyBudget longest time a job waits for companions before its partial batch runs
+             * \param p_queueCapacity jobs each worker queue holds, a producer finding it full runs the job itself
+             */
+            explicit JobScheduler(uint32_t p_workerCount = 1,
+                                  std::chrono::microseconds p_latencyBudget = std::chrono::microseconds(50),
+                                  uint64_t p_queueCapacity = 4096);
+            // Runs every job already submitted, then stops the workers
+            ~JobScheduler();
+
+            JobScheduler(const JobScheduler&) = delete;
+            JobScheduler& operator=(const JobScheduler&) = delete;
+
+            void                Submit(const Job& p_job, Callback p_callback);
+            // Allocates the shared state of the future, prefer the callback form on hot paths
+            std::future<void>   Submit(const Job& p_job);
+
+            Statistics          GetStatistics() const;
+        };
+    }
+}
+
+#pragma warning(pop)
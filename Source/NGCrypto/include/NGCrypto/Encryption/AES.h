@@ -1,6 +1,6 @@
 #pragma once
 
-#include <wmmintrin.h>
+#include <emmintrin.h>
 #include <cstdint>
 #include "NGCrypto/export.h"
 
@@ -10,6 +10,16 @@ namespace Cryptography
     {
         class NG_CRYPTO_API AES
         {
+        public:
+            // One buffer of EncryptECBBatch or DecryptECBBatch
+            struct ECBRequest
+            {
+                const AES*              cipher;
+                const unsigned char*    data;
+                unsigned char*          out;
+                uint64_t                dataLength;
+            };
+
         private:
             inline static const unsigned char sbox[256] = {
                 0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5,
@@ -89,17 +99,44 @@ namespace Cryptography
             //expands cipherkey to 14 encryptionRoundKeys for AES 256
             __m128i encryptionRoundKeys[ROUND_COUNT + 1];
             __m128i decryptionRoundKeys[ROUND_COUNT + 1];
-            static inline void KeyAssist1(__m128i* p_temp1, __m128i* p_temp2);
-            static inline void KeyAssist2(__m128i* p_temp1, __m128i* p_temp3);
             void GenerateEncryptionRoundKeys();
             void GenerateDecryptionRoundKeys();
+
+            // Byte-wise rounds for CPUs without AES-NI, S-box lookups depend on the data so they are not constant time
+            void EncryptBlock(const unsigned char* p_data, unsigned char* p_out) const;
+            void DecryptBlock(const unsigned char* p_data, unsigned char* p_out) const;
+
+            // AES-NI kernels, built in AESNI.cpp for that instruction set only
+            static void EncryptBlocksNI(const __m128i* p_roundKeys, const unsigned char* p_data, unsigned char* p_out, uint64_t p_blockCount);
+            static void DecryptBlocksNI(const __m128i* p_roundKeys, const unsigned char* p_data, unsigned char* p_out, uint64_t p_blockCount);
+
+            // Single block of a batch with the round keys of its own cipher
+            struct BlockRef
+            {
+                const __m128i*          roundKeys;
+                const unsigned char*    data;
+                unsigned char*          out;
+            };
+
+            static void EncryptGatherNI(const BlockRef* p_blocks, uint64_t p_blockCount);
+            static void DecryptGatherNI(const BlockRef* p_blocks, uint64_t p_blockCount);
+            static void RunECBBatch(const ECBRequest* p_requests, uint64_t p_count, bool p_decrypt);
         public:
             AES(const unsigned char p_cipherKey[64]);
-            ~AES() = default;
+            // Wipes the key and the round keys
+            ~AES();
 
             void EncryptECB(const unsigned char *p_data, unsigned char *p_out, uint64_t p_dataLength);
             void DecryptECB(const unsigned char *p_data, unsigned char *p_out, uint64_t p_dataLength);
 
+            /**
+             * ECB over independent buffers, possibly under different keys.
+             * Whole groups of four blocks run as in EncryptECB, the leftover blocks of
+             * every request are gathered four at a time so short buffers keep the unit busy too.
+             */
+            static void EncryptECBBatch(const ECBRequest* p_requests, uint64_t p_count);
+            static void DecryptECBBatch(const ECBRequest* p_requests, uint64_t p_count);
+
             void EncryptCBC(const unsigned char *p_data, unsigned char *p_out, uint64_t p_dataLength);
             void DecryptCBC(const unsigned char *p_data, unsigned char *p_out, uint64_t p_dataLength);
 
@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include "NGCrypto/export.h"
+#include "NGCrypto/Encryption/AES.h"
+
+namespace Cryptography
+{
+    namespace Encryption
+    {
+        /**
+         * Authenticated message frames: AES-256 in counter mode, then HMAC-SHA256 over everything before the tag.
+         *
+         * Frame layout, integers big-endian:
+         *   header      VERSION (1), reserved zeros (3), plaintext length (4)
+         *   nonce       NONCE_SIZE random bytes, the counter block is nonce || 32-bit block index
+         *   ciphertext  as long as the plaintext, counter mode needs no padding
+         *   tag         TAG_SIZE bytes of HMAC-SHA256 over header, nonce and ciphertext
+         *
+         * Seal and Open write straight into the caller's buffer and allocate nothing.
+         * The plaintext may already sit at the ciphertext position of the frame, and Open may
+         * decrypt anywhere from the frame start up to the ciphertext, so messages are built and read in place.
+         * An instance is not thread-safe.
+         */
+        class NG_CRYPTO_API EncryptThenMAC
+        {
+        public:
+            static const uint8_t  VERSION         = 1;
+            static const uint32_t KEY_SIZE        = 32;
+            static const uint32_t HEADER_SIZE     = 8;
+            static const uint32_t NONCE_SIZE      = 12;
+            static const uint32_t TAG_SIZE        = 32;
+            static const uint32_t OVERHEAD        = HEADER_SIZE + NONCE_SIZE + TAG_SIZE;
+            // Offset of the ciphertext in a frame
+            static const uint32_t PAYLOAD_OFFSET  = HEADER_SIZE + NONCE_SIZE;
+            static const uint64_t MAX_PLAINTEXT   = UINT32_MAX;
+
+        private:
+            AES     m_cipher;
+            uint8_t m_macKey[KEY_SIZE];
+
+            // XORs the counter mode keystream of p_nonce into p_size bytes
+            void ApplyKeystream(const uint8_t* p_nonce, const unsigned char* p_in, unsigned char* p_out, uint64_t p_size);
+
+        public:
+            // The two keys must be independent, derive them from a shared secret with different labels
+            EncryptThenMAC(const unsigned char p_encryptionKey[KEY_SIZE], const unsigned char p_macKey[KEY_SIZE]);
+            // Wipes the MAC key, the cipher wipes its own
+            ~EncryptThenMAC();
+
+            EncryptThenMAC(const EncryptThenMAC&) = delete;
+            EncryptThenMAC& operator=(const EncryptThenMAC&) = delete;
+
+            static uint64_t GetFrameSize(uint64_t p_plaintextLength)    { return p_plaintextLength + OVERHEAD; }
+            // 0 for anything shorter than an empty frame
+            static uint64_t GetPlaintextSize(uint64_t p_frameLength)    { return p_frameLength < OVERHEAD ? 0 : p_frameLength - OVERHEAD; }
+
+            /**
+             * Writes the frame of p_plaintext to p_out, which must hold GetFrameSize(p_size) bytes.
+             * A fresh nonce comes from the thread's CtrDrbg. Returns the frame size,
+             * or 0 when p_size exceeds MAX_PLAINTEXT.
+             */
+            uint64_t Seal(unsigned char* p_out, const unsigned char* p_plaintext, uint64_t p_size);
+
+            /**
+             * Checks the tag of p_frame in constant time and only then decrypts into p_out,
+             * which must hold GetPlaintextSize(p_frameLength) bytes. Returns false, leaving
+             * p_out untouched, for malformed frames and frames whose tag does not match.
+             */
+            bool     Open(unsigned char* p_out, const unsigned char* p_frame, uint64_t p_frameLength);
+        };
+    }
+}
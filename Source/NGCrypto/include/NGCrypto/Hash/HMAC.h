@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <array>
 #include "NGCrypto/export.h"
 
@@ -10,10 +11,28 @@ namespace Cryptography
         {
         public:
             static const uint32_t SIZE {32};
+
+            // One message of HMAC_SHA256Batch, mac receives SIZE bytes
+            struct Request
+            {
+                const unsigned char*    key;
+                uint64_t                keyLength;
+                const unsigned char*    message;
+                uint64_t                messageLength;
+                uint8_t*                mac;
+            };
+
+        private:
+            // Zero padded block of the key, hashed first when longer than a block
+            static void LoadKey(const unsigned char* p_key, uint64_t p_keyLength, uint8_t* p_block);
+
+        public:
             HMAC() = delete;
             ~HMAC() = delete;
             static std::array<uint8_t, SIZE> HMAC_SHA256(const unsigned char* p_key, uint64_t p_keyLength,
                                              const unsigned char* p_message, uint64_t p_messageLength);
+            // Runs the inner and outer hashes of all requests as SHA256 batches
+            static void HMAC_SHA256Batch(const Request* p_requests, uint64_t p_count);
         };
     }
 }
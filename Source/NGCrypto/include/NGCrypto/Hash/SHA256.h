@@ -11,29 +11,76 @@ namespace Cryptography
         class NG_CRYPTO_API SHA256
         {
             using WORD = uint32_t;
+            friend class HMAC;
 
         public:
             static const uint8_t BLOCK_SIZE = 64;
             static const uint8_t OUTPUT_SIZE = 32;
             static const uint8_t WORDS_PER_BLOCK = {BLOCK_SIZE / (sizeof(WORD))};
 
+            // One message of HashBatch, p_digest receives OUTPUT_SIZE bytes
+            struct HashRequest
+            {
+                const unsigned char*    message;
+                uint64_t                size;
+                uint8_t*                digest;
+            };
+
         private:
             struct SHA256_Block
             {
-                WORD words[WORDS_PER_BLOCK] = {0};
+                WORD words[WORDS_PER_BLOCK];
             };
 
             static const uint32_t SHA256_H[8];
             static const uint32_t SHA256_K[64];
 
             uint32_t m_h[8] {0};
+            // Bytes of an unfinished block and the message length so far
+            uint8_t  m_buffer[BLOCK_SIZE] {0};
+            uint64_t m_length {0};
 
             void CompressBlock(SHA256_Block& p_block);
+            // Compresses p_blockCount whole blocks of message bytes
+            void CompressBlocks(const uint8_t* p_data, uint64_t p_blockCount);
+            // SHA-NI kernels, built in SHA256NI.cpp for that instruction set only
+            static void CompressBlocksNI(uint32_t p_state[8], const SHA256_Block* p_blocks, uint64_t p_blockCount);
+            static void CompressBlocksNIx2(uint32_t p_state0[8], uint32_t p_state1[8],
+                                           const SHA256_Block* p_blocks0, const SHA256_Block* p_blocks1, uint64_t p_blockCount);
+
+            // Message of a batch, optionally preceded by one whole block such as an HMAC pad
+            struct Lane
+            {
+                const uint8_t*  prefix;
+                const uint8_t*  data;
+                uint64_t        size;
+                uint8_t*        digest;
+            };
+
+            static uint64_t GetBlockCount(const Lane& p_lane);
+            // Block p_index of the padded lane message, in host word order
+            static void     LoadBlock(const Lane& p_lane, uint64_t p_index, SHA256_Block& p_block);
+            // Hashes the lanes two at a time on the SHA-NI unit, one after the other without it
+            static void     HashLanes(const Lane* p_lanes, uint64_t p_count);
         public:
             SHA256();
-            ~SHA256() = default;
+            // Wipes the state, it is derived from the message
+            ~SHA256();
+
+            // Starts a new message, Final already does this
+            void Reset();
+            void Update(const unsigned char* p_data, uint64_t p_size);
+            // Pads the message, returns its digest and resets the object for the next message
+            std::array<uint8_t,OUTPUT_SIZE> Final();
 
             std::array<uint8_t,OUTPUT_SIZE> Hash(const unsigned char* p_message, const uint64_t& p_size);
+
+            /**
+             * Hashes independent messages, interleaving two at a time so the
+             * latency of one stream's rounds is hidden behind the other's.
+             * Pairs of neighbouring requests should have similar sizes.
+             */
+            static void HashBatch(const HashRequest* p_requests, uint64_t p_count);
         };
     }
 }
@@ -1,51 +1,108 @@
 #pragma once
 #include "NGMP.h"
 #include "NGCrypto/export.h"
+#include "NGCrypto/KeyExchange/DiffieHellmanGroup.h"
+#include "NGCrypto/Utils/ThreadPool.h"
 
 #pragma warning(push)
 #pragma warning(disable: 4251)
 
-#define PUBLIC_KEY_SIZE 2048
-#define PRIVATE_KEY_SIZE 256
 namespace Cryptography
 {
     namespace KeyExchange
     {
-        using PublicKey     = NGMP<PUBLIC_KEY_SIZE>;
-        using PrivateKey    = NGMP<PRIVATE_KEY_SIZE>;
-        using SharedKey     = NGMP<PUBLIC_KEY_SIZE>;
+        // Shared key or public key computation that runs a bounded number of 4-bit private key windows per Step
+        using ExponentiationTask = ResumablePowMod<MAX_PUBLIC_KEY_SIZE, PRIVATE_KEY_SIZE, MAX_PUBLIC_KEY_SIZE>;
 
+        // Per-item result of a batch operation
+        enum class KeyStatus : uint8_t
+        {
+            Success,
+            InvalidPublicKey,
+            Failure
+        };
+
+        // How thoroughly a peer public key is checked before use
+        enum class ValidationMode : uint8_t
+        {
+            // Range check and Jacobi symbol, about the cost of a GCD
+            Fast,
+            // Range check and y ^ q == 1, costs a full exponentiation, for auditing
+            Full
+        };
+
+        /**
+         * Key exchange over a DiffieHellmanGroup, the 2048-bit MODP group unless one is given.
+         * Both sides must use the same group; keys from different groups are not interchangeable.
+         */
         class NG_CRYPTO_API DiffieHellman
         {
         private:
+            // Rejects the degenerate keys 0, 1 and prime - 1 along with anything not reduced mod prime
+            static bool         IsPublicKeyInRange(const PublicKey& p_publicKey, const DiffieHellmanGroup& p_group);
 
-                //Using RFC3526 MODP Groups
-        #if PUBLIC_KEY_SIZE == 2048
-            static const uint32_t       PRIME_ARRAY[64];
-            static const uint8_t        GENERATOR = 2;
-            #define OVERFLOW_SAFE_SIZE 4096
+        public:
+            DiffieHellman() = delete;
+            ~DiffieHellman() = delete;
 
-        #elif PUBLIC_KEY_SIZE == 1536
-            static const uint32_t       PRIME_ARRAY[48];
-            static const uint8_t        GENERATOR = 2;
-            #define OVERFLOW_SAFE_SIZE 2048
+            static void         GenerateKeyPair(PrivateKey& p_privateKey, PublicKey&  p_publicKey,
+                                                const DiffieHellmanGroup& p_group = DiffieHellmanGroup::GetDefault());
+            // Batch form of GenerateKeyPair, public keys are computed on p_pool
+            static void         GenerateKeyPairs(PrivateKey* p_privateKeys, PublicKey* p_publicKeys, uint64_t p_count,
+                                                 const DiffieHellmanGroup& p_group = DiffieHellmanGroup::GetDefault(),
+                                                 Utils::ThreadPool& p_pool = Utils::ThreadPool::GetDefault());
+            // Throws std::invalid_argument when p_otherPublic fails ValidatePublicKey
+            static SharedKey    GenerateSharedKey(const PublicKey&  p_otherPublic, const PrivateKey& p_privateKey,
+                                                  const DiffieHellmanGroup& p_group = DiffieHellmanGroup::GetDefault());
 
-        #elif PUBLIC_KEY_SIZE == 1024
-            static const uint32_t       PRIME_ARRAY[32];
-            static const uint8_t        GENERATOR = 2;
-            #define OVERFLOW_SAFE_SIZE 2048
-        #endif
+            /**
+             * Checks that a peer public key lies in the prime order subgroup.
+             * The prime is a safe prime 2q + 1 and the generator is a quadratic residue, so the subgroup of order q
+             * is exactly the quadratic residues and the Jacobi symbol (y / prime) = 1 decides membership.
+             * Full mode checks y ^ q == 1 instead and gives the same answer at the cost of an exponentiation.
+             */
+            static bool         ValidatePublicKey(const PublicKey& p_publicKey,
+                                                  const DiffieHellmanGroup& p_group = DiffieHellmanGroup::GetDefault(),
+                                                  ValidationMode p_mode = ValidationMode::Fast);
 
-            static const NGMP<PUBLIC_KEY_SIZE>  PRIME;
+            /**
+             * Fixed-length big-endian wire form of a public or shared key, p_group.GetByteCount() bytes
+             * left padded with zeros (RFC 3526 / I2OSP).
+             */
+            static void         EncodeKey(const PublicKey& p_key, uint8_t* p_out,
+                                          const DiffieHellmanGroup& p_group = DiffieHellmanGroup::GetDefault());
+            /**
+             * Reads a peer public key of p_group.GetByteCount() bytes.
+             * The range check runs on the received bytes, so out of range keys are rejected before decoding.
+             * Returns false, leaving p_publicKey untouched, when the key is out of range or fails ValidatePublicKey.
+             */
+            static bool         DecodePublicKey(const uint8_t* p_in, PublicKey& p_publicKey,
+                                                const DiffieHellmanGroup& p_group = DiffieHellmanGroup::GetDefault());
 
-        public:
-            DiffieHellman() = delete;
-            ~DiffieHellman() = delete;
+            /**
+             * Resumable forms of GenerateKeyPair and GenerateSharedKey for event loops.
+             * Call Step on the returned task until it reports completion, then read GetResult.
+             * The task refers to p_group, which must outlive it.
+             */
+            static ExponentiationTask   StartKeyPair(PrivateKey& p_privateKey,
+                                                     const DiffieHellmanGroup& p_group = DiffieHellmanGroup::GetDefault());
+            // Throws std::invalid_argument when p_otherPublic fails ValidatePublicKey
+            static ExponentiationTask   StartSharedKey(const PublicKey& p_otherPublic, const PrivateKey& p_privateKey,
+                                                       const DiffieHellmanGroup& p_group = DiffieHellmanGroup::GetDefault());
 
-            static void         GenerateKeyPair(PrivateKey& p_privateKey, PublicKey&  p_publicKey);
-            static SharedKey    GenerateSharedKey(const PublicKey&  p_otherPublic, const PrivateKey& p_privateKey);
+            /**
+             * Computes p_count independent shared keys on a thread pool.
+             * Item i uses p_otherPublics[i] and p_privateKeys[i] and writes p_sharedKeys[i] and p_status[i];
+             * peer keys failing ValidatePublicKey get InvalidPublicKey.
+             * p_sharedKeys[i] is zeroed when p_status[i] is not Success.
+             * Returns once every item is done.
+             */
+            static void         GenerateSharedKeys(const PublicKey* p_otherPublics, const PrivateKey* p_privateKeys,
+                                                   SharedKey* p_sharedKeys, KeyStatus* p_status, uint64_t p_count,
+                                                   const DiffieHellmanGroup& p_group = DiffieHellmanGroup::GetDefault(),
+                                                   Utils::ThreadPool& p_pool = Utils::ThreadPool::GetDefault());
         };
-        
+
     }
 }
 
@@ -0,0 +1,116 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "NGMP.h"
+#include "NGCrypto/export.h"
+#include "NGCrypto/Utils/ThreadPool.h"
+
+#pragma warning(push)
+#pragma warning(disable: 4251)
+
+// Key storage is sized for the largest group, smaller groups leave the top limbs zero
+#define MAX_PUBLIC_KEY_SIZE 4096
+#define PRIVATE_KEY_SIZE 256
+namespace Cryptography
+{
+    namespace KeyExchange
+    {
+        using PublicKey     = NGMP<MAX_PUBLIC_KEY_SIZE>;
+        using PrivateKey    = NGMP<PRIVATE_KEY_SIZE>;
+        using SharedKey     = NGMP<MAX_PUBLIC_KEY_SIZE>;
+
+        // Built-in MODP groups, 1024 from RFC 2409 and the rest from RFC 3526
+        enum class GroupId : uint8_t
+        {
+            Modp1024,
+            Modp1536,
+            Modp2048,
+            Modp3072,
+            Modp4096
+        };
+
+        class MontgomeryLanes;
+
+        /**
+         * Prime, generator and every constant derived from them for one Diffie-Hellman group.
+         * The built-in groups refer to primes and Barrett contexts evaluated at compile time, custom groups build their own.
+         * Construction precomputes the Montgomery context, the vector Montgomery constants and a
+         * fixed-base table of generator powers, so a group should be built once and shared.
+         * Groups are immutable afterwards and safe to use from any thread.
+         */
+        class NG_CRYPTO_API DiffieHellmanGroup
+        {
+            friend class DiffieHellman;
+
+        public:
+            // Generator powers are tabulated per 4-bit window of the private key
+            static const uint32_t WINDOW_BITS   = 4;
+            static const uint32_t WINDOW_SIZE   = 1 << WINDOW_BITS;
+            static const uint32_t WINDOW_COUNT  = PRIVATE_KEY_SIZE / WINDOW_BITS;
+
+        private:
+            // Null for the built-in groups, whose context is a compile-time constant
+            std::unique_ptr<const BarrettContext<MAX_PUBLIC_KEY_SIZE>> m_ownedContext;
+            // Holds the prime
+            const BarrettContext<MAX_PUBLIC_KEY_SIZE>& m_context;
+            // (prime - 1) / 2, the order of the generator
+            PublicKey                           m_subgroupOrder;
+            uint8_t                             m_generator;
+            uint32_t                            m_bitCount;
+            uint32_t                            m_limbCount;
+            // Every exponentiation by a private key runs in Montgomery form, in constant time
+            MontgomeryContext<MAX_PUBLIC_KEY_SIZE> m_montgomeryContext;
+            // Null when the prime is too large for the vector kernels
+            std::unique_ptr<MontgomeryLanes>    m_lanes;
+            // generator ^ (digit * 2^(WINDOW_BITS * window)) in Montgomery form at [window][digit], m_limbCount limbs each
+            std::vector<uint64_t>               m_generatorTable;
+
+            // Exactly one of p_context and p_ownedContext is set
+            DiffieHellmanGroup(const BarrettContext<MAX_PUBLIC_KEY_SIZE>* p_context,
+                               std::unique_ptr<const BarrettContext<MAX_PUBLIC_KEY_SIZE>> p_ownedContext, uint8_t p_generator);
+
+            void BuildGeneratorTable();
+
+            const MontgomeryLanes* GetLanes() const { return m_lanes.get(); }
+
+        public:
+            /**
+             * \param p_prime safe prime 2q + 1
+             * \param p_generator generator of the order q subgroup, i.e. a quadratic residue mod p_prime
+             * Throws std::invalid_argument when p_generator is not a quadratic residue.
+             */
+            DiffieHellmanGroup(const PublicKey& p_prime, uint8_t p_generator);
+            ~DiffieHellmanGroup();
+
+            DiffieHellmanGroup(const DiffieHellmanGroup&) = delete;
+            DiffieHellmanGroup& operator=(const DiffieHellmanGroup&) = delete;
+
+            const PublicKey&    GetPrime() const            { return m_context.GetModulus(); }
+            const PublicKey&    GetSubgroupOrder() const    { return m_subgroupOrder; }
+            uint8_t             GetGenerator() const        { return m_generator; }
+            uint32_t            GetBitCount() const         { return m_bitCount; }
+            // Size of public and shared keys on the wire
+            uint32_t            GetByteCount() const        { return (m_bitCount + 7) / 8; }
+
+            const BarrettContext<MAX_PUBLIC_KEY_SIZE>&      GetContext() const              { return m_context; }
+            const MontgomeryContext<MAX_PUBLIC_KEY_SIZE>&   GetMontgomeryContext() const    { return m_montgomeryContext; }
+
+            // generator ^ p_exponent mod prime from the fixed-base table, one multiplication per window, constant time
+            PublicKey           PowGenerator(const PrivateKey& p_exponent) const;
+
+            /**
+             * New group on a freshly generated safe prime of p_bitCount bits, from Random::PrimeGenerator.
+             * The generator is 2 when it is a quadratic residue and 4 otherwise.
+             * Expect seconds for 1024 bits and minutes for 2048 bits, divided by the pool size.
+             */
+            static std::unique_ptr<DiffieHellmanGroup> Generate(uint32_t p_bitCount, Utils::ThreadPool& p_pool = Utils::ThreadPool::GetDefault());
+
+            // Built-in group, precomputed on first use
+            static const DiffieHellmanGroup& Get(GroupId p_id);
+            // 2048-bit MODP group
+            static const DiffieHellmanGroup& GetDefault();
+        };
+    }
+}
+
+#pragma warning(pop)
@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include "NGCrypto/export.h"
+#include "NGCrypto/KeyExchange/DiffieHellman.h"
+#include "NGCrypto/Utils/BoundedQueue.h"
+
+#pragma warning(push)
+#pragma warning(disable: 4251)
+
+namespace Cryptography
+{
+    namespace KeyExchange
+    {
+        /**
+         * Keeps fresh Diffie-Hellman key pairs ready ahead of handshakes.
+         * A background thread tops the pool up to the high watermark in batches whenever
+         * it drops below the low watermark. Acquire pops a pair without locking and only
+         * generates one on the calling thread when the pool is empty.
+         */
+        class NG_CRYPTO_API KeyPairPool
+        {
+        public:
+            struct KeyPair
+            {
+                PrivateKey privateKey;
+                PublicKey  publicKey;
+            };
+
+            struct Statistics
+            {
+                // Acquire calls served from the pool
+                uint64_t hits;
+                // Acquire calls that had to generate synchronously
+                uint64_t misses;
+                // Pairs added by the background thread
+                uint64_t refilled;
+                // Background pairs per second of refill work
+                double   refillRate;
+                uint64_t available;
+            };
+
+        private:
+            Utils::BoundedQueue<KeyPair>    m_pairs;
+            const uint64_t                  m_lowWatermark;
+            const uint64_t                  m_highWatermark;
+            const uint64_t                  m_batchSize;
+            const DiffieHellmanGroup&       m_group;
+            Utils::ThreadPool&              m_pool;
+
+            std::atomic<uint64_t>           m_hits {0};
+            std::atomic<uint64_t>           m_misses {0};
+            std::atomic<uint64_t>           m_refilled {0};
+            std::atomic<uint64_t>           m_refillNanoseconds {0};
+
+            std::atomic<bool>               m_refillRequested {false};
+            bool                            m_stopping = false;
+            std::mutex                      m_refillMutex;
+            std::condition_variable         m_refillCondition;
+            std::thread                     m_refillThread;
+
+            void RequestRefill();
+            void RefillLoop();
+
+        public:
+            /**
+             * \param p_lowWatermark refill starts when fewer pairs are available
+             * \param p_highWatermark refill stops once this many pairs are available, also the queue capacity
+             * \param p_batchSize pairs generated per refill step, the lane count of the vector kernels is a good fit
+             * \param p_group group every pair belongs to, must outlive the pool
+             * \param p_pool threads used for refill exponentiations
+             */
+            KeyPairPool(uint64_t p_lowWatermark, uint64_t p_highWatermark, uint64_t p_batchSize = 8,
+                        const DiffieHellmanGroup& p_group = DiffieHellmanGroup::GetDefault(),
+                        Utils::ThreadPool& p_pool = Utils::ThreadPool::GetDefault());
+            ~KeyPairPool();
+
+            KeyPairPool(const KeyPairPool&) = delete;
+            KeyPairPool& operator=(const KeyPairPool&) = delete;
+
+            void        Acquire(PrivateKey& p_privateKey, PublicKey& p_publicKey);
+            Statistics  GetStatistics() const;
+        };
+    }
+}
+
+#pragma warning(pop)
@@ -0,0 +1,53 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include "NGCrypto/export.h"
+#include "NGCrypto/KeyExchange/DiffieHellman.h"
+#include "NGCrypto/Utils/ThreadPool.h"
+
+namespace Cryptography
+{
+    namespace KeyExchange
+    {
+        /**
+         * X25519 key exchange from RFC 7748.
+         * Field elements are kept as five 51-bit limbs so products accumulate in 128 bits without
+         * intermediate carries, and the scalar is processed by a Montgomery ladder whose sequence
+         * of operations and memory accesses does not depend on the private key.
+         * Keys are the little-endian 32-byte strings of the RFC.
+         */
+        class NG_CRYPTO_API X25519
+        {
+        public:
+            static const uint32_t KEY_SIZE = 32;
+
+            using PrivateKey    = std::array<uint8_t, KEY_SIZE>;
+            using PublicKey     = std::array<uint8_t, KEY_SIZE>;
+            using SharedKey     = std::array<uint8_t, KEY_SIZE>;
+
+            X25519() = delete;
+            ~X25519() = delete;
+
+            // RFC 7748 X25519 function: p_out = clamp(p_scalar) * p_point, on the u-coordinate only
+            static void         ScalarMult(uint8_t p_out[KEY_SIZE], const uint8_t p_scalar[KEY_SIZE], const uint8_t p_point[KEY_SIZE]);
+
+            static void         GenerateKeyPair(PrivateKey& p_privateKey, PublicKey& p_publicKey);
+            // Batch form of GenerateKeyPair, public keys are computed on p_pool
+            static void         GenerateKeyPairs(PrivateKey* p_privateKeys, PublicKey* p_publicKeys, uint64_t p_count,
+                                                 Utils::ThreadPool& p_pool = Utils::ThreadPool::GetDefault());
+
+            // Throws std::invalid_argument when p_otherPublic is a low order point, i.e. the shared key would be all zero
+            static SharedKey    GenerateSharedKey(const PublicKey& p_otherPublic, const PrivateKey& p_privateKey);
+
+            /**
+             * Computes p_count independent shared keys on a thread pool.
+             * Item i uses p_otherPublics[i] and p_privateKeys[i] and writes p_sharedKeys[i] and p_status[i];
+             * low order peer keys get InvalidPublicKey and a zeroed shared key.
+             * Returns once every item is done.
+             */
+            static void         GenerateSharedKeys(const PublicKey* p_otherPublics, const PrivateKey* p_privateKeys,
+                                                   SharedKey* p_sharedKeys, KeyStatus* p_status, uint64_t p_count,
+                                                   Utils::ThreadPool& p_pool = Utils::ThreadPool::GetDefault());
+        };
+    }
+}
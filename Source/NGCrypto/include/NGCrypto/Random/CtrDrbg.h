@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include "NGCrypto/export.h"
+#include "NGCrypto/Encryption/AES.h"
+
+namespace Cryptography
+{
+    namespace Random
+    {
+        /**
+         * NIST SP 800-90A CTR_DRBG on AES-256, without derivation function.
+         * Keystream is produced a buffer at a time and handed out in slices; served bytes are wiped
+         * and the key is rotated after every refill, so earlier output cannot be recovered from the state.
+         * Instances seeded from the OS reseed on first use in the child of a fork, so parent and child never share output.
+         * An instance is not thread-safe, GetThreadInstance gives each thread its own.
+         */
+        class NG_CRYPTO_API CtrDrbg
+        {
+        public:
+            static const uint32_t KEY_SIZE          = 32;
+            static const uint32_t BLOCK_SIZE        = 16;
+            static const uint32_t SEED_SIZE         = KEY_SIZE + BLOCK_SIZE;
+            static const uint32_t BUFFER_SIZE       = 4096;
+            // Buffer refills between reseeds from the OS, far below the 2^48 requests allowed by SP 800-90A
+            static const uint64_t RESEED_INTERVAL   = uint64_t(1) << 16;
+
+        private:
+            uint8_t                 m_key[KEY_SIZE];
+            uint8_t                 m_v[BLOCK_SIZE];
+            Encryption::AES         m_cipher;
+            uint8_t                 m_buffer[BUFFER_SIZE];
+            uint32_t                m_position;
+            uint64_t                m_reseedCounter;
+            // Fork generation at the last OS reseed, compared on every Generate
+            uint64_t                m_forkGeneration;
+
+            // SP 800-90A CTR_DRBG_Update
+            void Update(const uint8_t p_data[SEED_SIZE]);
+            void IncrementCounter();
+            void Refill();
+
+        public:
+            // Seeds from the OS entropy source
+            CtrDrbg();
+            // Deterministic instance, for known answer tests
+            explicit CtrDrbg(const uint8_t p_seed[SEED_SIZE]);
+            // Wipes the state
+            ~CtrDrbg();
+
+            CtrDrbg(const CtrDrbg&) = delete;
+            CtrDrbg& operator=(const CtrDrbg&) = delete;
+
+            void Reseed();
+            void Reseed(const uint8_t p_seed[SEED_SIZE]);
+
+            void Generate(uint8_t* p_out, uint64_t p_size);
+
+            // Lazily seeded instance owned by the calling thread, no locking involved
+            static CtrDrbg& GetThreadInstance();
+
+            // Generate on the calling thread's instance, for IVs, nonces and keys
+            static void Fill(uint8_t* p_out, uint64_t p_size);
+
+            // Reads p_size bytes from the OS entropy source, throws std::runtime_error on failure
+            static void GetEntropy(uint8_t* p_out, uint64_t p_size);
+        };
+    }
+}
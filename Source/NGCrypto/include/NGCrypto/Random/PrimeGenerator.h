@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "NGMP.h"
+#include "NGCrypto/export.h"
+#include "NGCrypto/Utils/ThreadPool.h"
+
+namespace Cryptography
+{
+    namespace Random
+    {
+        /**
+         * Random prime and safe prime generation for RSA keys and Diffie-Hellman groups.
+         * Every pool thread runs its own sieve search (NGMP::GeneratePrime) from a different random
+         * start, with bases and starts drawn from its CtrDrbg thread instance; the first prime found
+         * stops the other searches.
+         */
+        class NG_CRYPTO_API PrimeGenerator
+        {
+        public:
+            static const uint32_t MAX_BIT_COUNT     = 4096;
+            // Miller-Rabin rounds, a composite survives with probability below 2^-64
+            static const uint32_t DEFAULT_ROUNDS    = 32;
+
+            using Prime = NGMP<MAX_BIT_COUNT>;
+
+            PrimeGenerator() = delete;
+            ~PrimeGenerator() = delete;
+
+            /**
+             * \param p_prime receives a prime of exactly p_bitCount bits with its two top bits set
+             * \param p_safe search for a safe prime 2q + 1, q prime
+             * \param p_cancel polled between candidates, may be set from any thread
+             * Returns false, leaving p_prime untouched, when p_cancel was set first.
+             * Throws std::invalid_argument unless 32 <= p_bitCount <= MAX_BIT_COUNT.
+             */
+            static bool     Generate(Prime& p_prime, uint32_t p_bitCount, bool p_safe, const std::atomic<bool>* p_cancel = nullptr,
+                                     uint32_t p_rounds = DEFAULT_ROUNDS, Utils::ThreadPool& p_pool = Utils::ThreadPool::GetDefault());
+
+            static Prime    GeneratePrime(uint32_t p_bitCount, Utils::ThreadPool& p_pool = Utils::ThreadPool::GetDefault());
+            static Prime    GenerateSafePrime(uint32_t p_bitCount, Utils::ThreadPool& p_pool = Utils::ThreadPool::GetDefault());
+        };
+    }
+}
@@ -0,0 +1,105 @@
+#pragma once
+#include <cstdint>
+#include "NGMP.h"
+#include "NGCrypto/export.h"
+#include "NGCrypto/Utils/ThreadPool.h"
+
+#pragma warning(push)
+#pragma warning(disable: 4251)
+
+namespace Cryptography
+{
+    namespace Signature
+    {
+        /**
+         * RSA public key for 2048, 3072 or 4096-bit moduli (any odd modulus up to MAX_MODULUS_SIZE works).
+         * Exponentiation runs in Montgomery form; e = 65537 takes 16 squarings and one multiplication.
+         */
+        class NG_CRYPTO_API RSAPublicKey
+        {
+        public:
+            static const uint32_t   MAX_MODULUS_SIZE    = 4096;
+            static const uint64_t   DEFAULT_EXPONENT    = 65537;
+
+            using Modulus = NGMP<MAX_MODULUS_SIZE>;
+
+        private:
+            Modulus                             m_modulus;
+            Modulus                             m_exponent;
+            uint32_t                            m_bitCount;
+            MontgomeryContext<MAX_MODULUS_SIZE> m_context;
+
+        public:
+            // Throws std::invalid_argument when the modulus is even or the exponent is even or below 3
+            RSAPublicKey(const Modulus& p_modulus, const Modulus& p_exponent = Modulus(DEFAULT_EXPONENT));
+            ~RSAPublicKey() = default;
+
+            const Modulus&  GetModulus() const  { return m_modulus; }
+            const Modulus&  GetExponent() const { return m_exponent; }
+            // Montgomery arithmetic modulo n
+            const MontgomeryContext<MAX_MODULUS_SIZE>& GetContext() const { return m_context; }
+            uint32_t        GetBitCount() const { return m_bitCount; }
+            // Size of signatures and ciphertexts
+            uint32_t        GetByteCount() const { return (m_bitCount + 7) / 8; }
+
+            // RSAEP / RSAVP1: p_value ^ e mod n, throws std::invalid_argument unless p_value < n
+            Modulus         Encrypt(const Modulus& p_value) const;
+
+            // RSASSA-PKCS1-v1_5 with SHA-256, p_signature holds GetByteCount() bytes
+            bool            VerifySHA256(const uint8_t* p_message, uint64_t p_size, const uint8_t* p_signature) const;
+        };
+
+        /**
+         * RSA private key in CRT form.
+         * A private operation is two half-size exponentiations with dP = d mod (p - 1) and dQ = d mod (q - 1),
+         * recombined with qInv = q^-1 mod p (Garner), roughly four times cheaper than one full-size exponentiation.
+         * Inputs are blinded with a fresh random r as c * r^e before the exponentiations and the result is
+         * multiplied by r^-1 afterwards, so their timing does not depend on the value a caller chose.
+         * Results are checked with the public exponent so a faulty computation never leaks a factor of n.
+         */
+        class NG_CRYPTO_API RSAPrivateKey
+        {
+        public:
+            using Modulus   = RSAPublicKey::Modulus;
+            using Prime     = NGMP<RSAPublicKey::MAX_MODULUS_SIZE / 2>;
+
+        private:
+            // p > q
+            Prime                                               m_p;
+            Prime                                               m_q;
+            Prime                                               m_dP;
+            Prime                                               m_dQ;
+            // qInv in Montgomery form for p, so recombination takes one product
+            Prime                                               m_qInv;
+            MontgomeryContext<RSAPublicKey::MAX_MODULUS_SIZE / 2> m_pContext;
+            MontgomeryContext<RSAPublicKey::MAX_MODULUS_SIZE / 2> m_qContext;
+            RSAPublicKey                                        m_publicKey;
+
+        public:
+            // Throws std::invalid_argument when the primes are equal or even, or e is not invertible mod p - 1 or q - 1
+            RSAPrivateKey(const Prime& p_p, const Prime& p_q, const Modulus& p_exponent = Modulus(RSAPublicKey::DEFAULT_EXPONENT));
+            // Wipes the primes and exponents
+            ~RSAPrivateKey();
+
+            RSAPrivateKey(const RSAPrivateKey&) = delete;
+            RSAPrivateKey& operator=(const RSAPrivateKey&) = delete;
+
+            /**
+             * Fresh key with a modulus of exactly p_bitCount bits, primes come from Random::PrimeGenerator.
+             * Throws std::invalid_argument unless p_bitCount is even and between 512 and MAX_MODULUS_SIZE.
+             */
+            static RSAPrivateKey Generate(uint32_t p_bitCount, const Modulus& p_exponent = Modulus(RSAPublicKey::DEFAULT_EXPONENT),
+                                          Utils::ThreadPool& p_pool = Utils::ThreadPool::GetDefault());
+
+            const RSAPublicKey& GetPublicKey() const { return m_publicKey; }
+
+            // RSADP / RSASP1: p_value ^ d mod n, throws std::invalid_argument unless p_value < n
+            Modulus         Decrypt(const Modulus& p_value) const;
+
+            // RSASSA-PKCS1-v1_5 with SHA-256, p_signature receives GetPublicKey().GetByteCount() bytes
+            void            SignSHA256(const uint8_t* p_message, uint64_t p_size, uint8_t* p_signature) const;
+        };
+    }
+}
+
+#pragma warning(pop)
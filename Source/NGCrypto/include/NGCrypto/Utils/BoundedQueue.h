@@ -0,0 +1,122 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "NGCrypto/Utils/SecureArena.h"
+
+namespace Cryptography
+{
+    namespace Utils
+    {
+        /**
+         * Lock-free bounded multi-producer multi-consumer queue.
+         * Each cell carries a sequence number telling producers and consumers whose turn it is,
+         * so push and pop are a single compare-exchange on the fast path.
+         * Capacity is rounded up to a power of two.
+         * Cells are wiped once their value is popped, so key material does not linger in the ring.
+         */
+        template<typename T>
+        class BoundedQueue
+        {
+            static_assert(std::is_trivially_destructible<T>::value, "Popped cells are wiped byte by byte");
+
+        private:
+            struct Cell
+            {
+                std::atomic<uint64_t>   sequence;
+                T                       value;
+            };
+
+            // Producer and consumer positions live on separate cache lines
+            static const uint64_t CACHE_LINE_SIZE = 64;
+
+            std::unique_ptr<Cell[]>                         m_cells;
+            uint64_t                                        m_mask;
+            alignas(CACHE_LINE_SIZE) std::atomic<uint64_t>  m_enqueuePosition {0};
+            alignas(CACHE_LINE_SIZE) std::atomic<uint64_t>  m_dequeuePosition {0};
+
+        public:
+            explicit BoundedQueue(uint64_t p_capacity)
+            {
+                uint64_t capacity = 2;
+                while (capacity < p_capacity)
+                    capacity <<= 1;
+
+                m_cells = std::make_unique<Cell[]>(capacity);
+                m_mask = capacity - 1;
+                for (uint64_t i = 0; i < capacity; ++i)
+                    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            ~BoundedQueue() = default;
+
+            BoundedQueue(const BoundedQueue&) = delete;
+            BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+            uint64_t GetCapacity() const { return m_mask + 1; }
+
+            // Exact when no push or pop is in flight
+            uint64_t GetSize() const
+            {
+                const uint64_t dequeued = m_dequeuePosition.load(std::memory_order_relaxed);
+                const uint64_t enqueued = m_enqueuePosition.load(std::memory_order_relaxed);
+                return enqueued > dequeued ? enqueued - dequeued : 0;
+            }
+
+            // Returns false when the queue is full
+            template<typename U>
+            bool TryPush(U&& p_value)
+            {
+                uint64_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+                for (;;)
+                {
+                    Cell& cell = m_cells[position & m_mask];
+                    const uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+                    const int64_t difference = static_cast<int64_t>(sequence - position);
+
+                    if (difference == 0)
+                    {
+                        if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        {
+                            cell.value = std::forward<U>(p_value);
+                            cell.sequence.store(position + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (difference < 0)
+                        return false;
+                    else
+                        position = m_enqueuePosition.load(std::memory_order_relaxed);
+                }
+            }
+
+            // Returns false when the queue is empty
+            bool TryPop(T& p_value)
+            {
+                uint64_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+                for (;;)
+                {
+                    Cell& cell = m_cells[position & m_mask];
+                    const uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+                    const int64_t difference = static_cast<int64_t>(sequence - (position + 1));
+
+                    if (difference == 0)
+                    {
+                        if (m_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        {
+                            p_value = std::move(cell.value);
+                            SecureZero(&cell.value, sizeof(T));
+                            cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (difference < 0)
+                        return false;
+                    else
+                        position = m_dequeuePosition.load(std::memory_order_relaxed);
+                }
+            }
+        };
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "NGCrypto/export.h"
+
+namespace Cryptography
+{
+    namespace Utils
+    {
+        /**
+         * Instruction set extensions usable on the running CPU.
+         * AVX flags also require the OS to save the extended register state.
+         * Kernels built for one of these are picked at run time, the rest of the library targets baseline x86-64.
+         */
+        struct NG_CRYPTO_API CpuFeatures
+        {
+            bool sse41      = false;
+            bool aesni      = false;
+            bool sha        = false;
+            bool avx2       = false;
+            bool bmi2       = false;
+            bool adx        = false;
+            bool avx512f    = false;
+            bool avx512ifma = false;
+
+            // Queried once, on first use
+            static const CpuFeatures& Get();
+        };
+    }
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include "NGCrypto/export.h"
+
+namespace Cryptography
+{
+    namespace Utils
+    {
+        // Operations with a probe, HMAC time includes its hashing, which streams into SHA256 without counting under it
+        enum class Operation : uint32_t
+        {
+            AESEncrypt,
+            AESDecrypt,
+            SHA256,
+            HMACSHA256,
+            DHKeyPair,
+            DHSharedKey,
+            Count
+        };
+
+        struct NG_CRYPTO_API OperationCounters
+        {
+            static const uint32_t BUCKET_COUNT = 64;
+
+            uint64_t    calls           = 0;
+            uint64_t    bytes           = 0;
+            // Calls whose cycles were read, one in GetSamplePeriod()
+            uint64_t    sampledCalls    = 0;
+            uint64_t    cycles          = 0;
+            // latency[i] counts sampled calls that took [2^(i - 1), 2^i) cycles, the last bucket is open ended
+            uint64_t    latency[BUCKET_COUNT] = {};
+
+            void        Merge(const OperationCounters& p_other);
+            uint64_t    GetMeanCycles() const { return sampledCalls ? cycles / sampledCalls : 0; }
+            // Upper bound in cycles of the bucket holding the p_fraction quantile, 0 without samples
+            uint64_t    GetLatencyPercentile(double p_fraction) const;
+        };
+
+        struct NG_CRYPTO_API InstrumentationSnapshot
+        {
+            static const uint32_t OPERATION_COUNT = static_cast<uint32_t>(Operation::Count);
+
+            OperationCounters operations[OPERATION_COUNT];
+
+            const OperationCounters&    operator[](Operation p_operation) const { return operations[static_cast<uint32_t>(p_operation)]; }
+            OperationCounters&          operator[](Operation p_operation)       { return operations[static_cast<uint32_t>(p_operation)]; }
+
+            // Adds every counter of p_other, used to combine snapshots of several processes or intervals
+            void                        Merge(const InstrumentationSnapshot& p_other);
+        };
+
+        /**
+         * Per-thread call and byte counters, with rdtsc cycles and log2 latency histograms.
+         * Each thread only writes its own counters, without a lock or a locked instruction;
+         * Snapshot() sums them with the counters of exited threads.
+         * Reading the cycle counter costs as much as a 16-byte AES call, so only one call in
+         * GetSamplePeriod() is timed. Probes exist only when the library is built with
+         * NG_CRYPTO_INSTRUMENTATION, otherwise every snapshot stays empty.
+         */
+        class NG_CRYPTO_API Instrumentation
+        {
+        public:
+            // Whether the library was built with its probes
+            static bool                     IsEnabled();
+            static const char*              GetName(Operation p_operation);
+
+            // 1 times every call; threads pick up a new period after their current one runs out
+            static void                     SetSamplePeriod(Operation p_operation, uint32_t p_period);
+            static uint32_t                 GetSamplePeriod(Operation p_operation);
+
+            // Totals over every thread since the last Reset()
+            static InstrumentationSnapshot  Snapshot();
+            // Totals of the calling thread since the last Reset()
+            static InstrumentationSnapshot  SnapshotThread();
+            // Starts a new interval, counters of running threads are not written to
+            static void                     Reset();
+        };
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace Cryptography
+{
+    namespace Utils
+    {
+        /**
+         * Lock-free bounded multi-producer single-consumer queue.
+         * Producers claim cells with the same sequence number scheme as BoundedQueue;
+         * the single consumer owns the dequeue position and pops without a compare-exchange.
+         * Capacity is rounded up to a power of two.
+         */
+        template<typename T>
+        class MpscQueue
+        {
+        private:
+            struct Cell
+            {
+                std::atomic<uint64_t>   sequence;
+                T                       value;
+            };
+
+            // Producer and consumer positions live on separate cache lines
+            static const uint64_t CACHE_LINE_SIZE = 64;
+
+            std::unique_ptr<Cell[]>                         m_cells;
+            uint64_t                                        m_mask;
+            alignas(CACHE_LINE_SIZE) std::atomic<uint64_t>  m_enqueuePosition {0};
+            // Only the consumer writes, atomic so producers can read it for GetSize
+            alignas(CACHE_LINE_SIZE) std::atomic<uint64_t>  m_dequeuePosition {0};
+
+        public:
+            explicit MpscQueue(uint64_t p_capacity)
+            {
+                uint64_t capacity = 2;
+                while (capacity < p_capacity)
+                    capacity <<= 1;
+
+                m_cells = std::make_unique<Cell[]>(capacity);
+                m_mask = capacity - 1;
+                for (uint64_t i = 0; i < capacity; ++i)
+                    m_cells[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            ~MpscQueue() = default;
+
+            MpscQueue(const MpscQueue&) = delete;
+            MpscQueue& operator=(const MpscQueue&) = delete;
+
+            uint64_t GetCapacity() const { return m_mask + 1; }
+
+            // Exact when no push or pop is in flight
+            uint64_t GetSize() const
+            {
+                const uint64_t dequeued = m_dequeuePosition.load(std::memory_order_relaxed);
+                const uint64_t enqueued = m_enqueuePosition.load(std::memory_order_relaxed);
+                return enqueued > dequeued ? enqueued - dequeued : 0;
+            }
+
+            // Returns false when the queue is full, p_value is left untouched then
+            template<typename U>
+            bool TryPush(U&& p_value)
+            {
+                uint64_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+                for (;;)
+                {
+                    Cell& cell = m_cells[position & m_mask];
+                    const uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+                    const int64_t difference = static_cast<int64_t>(sequence - position);
+
+                    if (difference == 0)
+                    {
+                        if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                        {
+                            cell.value = std::forward<U>(p_value);
+                            cell.sequence.store(position + 1, std::memory_order_release);
+                            return true;
+                        }
+                    }
+                    else if (difference < 0)
+                        return false;
+                    else
+                        position = m_enqueuePosition.load(std::memory_order_relaxed);
+                }
+            }
+
+            // Consumer only, true when the next cell holds a finished push
+            bool HasPending() const
+            {
+                const uint64_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+                return m_cells[position & m_mask].sequence.load(std::memory_order_acquire) == position + 1;
+            }
+
+            // Consumer only, returns false when the queue is empty
+            bool TryPop(T& p_value)
+            {
+                const uint64_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+                Cell& cell = m_cells[position & m_mask];
+                if (cell.sequence.load(std::memory_order_acquire) != position + 1)
+                    return false;
+
+                p_value = std::move(cell.value);
+                cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+                m_dequeuePosition.store(position + 1, std::memory_order_relaxed);
+                return true;
+            }
+        };
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+#include "NGCrypto/export.h"
+
+namespace Cryptography
+{
+    namespace Utils
+    {
+        // Overwrites p_size bytes with zeros, the stores are never dropped as dead
+        NG_CRYPTO_API void SecureZero(void* p_data, uint64_t p_size);
+
+        /**
+         * Bump allocator over pages reserved once from the OS, for transient buffers and key material.
+         * The pages are locked in memory so secrets are never written to swap (best effort: when the
+         * lock limit is reached the arena still works, IsLocked() reports it) and left out of core dumps.
+         * Memory is handed back a whole operation at a time through a Scope, which zeroes every byte
+         * allocated since it was opened. An instance is not thread-safe, GetThreadInstance gives each thread its own.
+         */
+        class NG_CRYPTO_API SecureArena
+        {
+        public:
+            static const uint64_t DEFAULT_CAPACITY = 64 * 1024;
+
+            // Releases everything allocated from p_arena during its lifetime
+            class Scope
+            {
+            private:
+                SecureArena&    m_arena;
+                uint64_t        m_marker;
+
+            public:
+                explicit Scope(SecureArena& p_arena) : m_arena(p_arena), m_marker(p_arena.GetMarker()) {}
+                ~Scope() { m_arena.Release(m_marker); }
+
+                Scope(const Scope&) = delete;
+                Scope& operator=(const Scope&) = delete;
+            };
+
+        private:
+            uint8_t*    m_base;
+            uint64_t    m_capacity;
+            uint64_t    m_top;
+            bool        m_locked;
+
+        public:
+            // p_capacity is rounded up to whole pages, throws std::bad_alloc when the OS has none to give
+            explicit SecureArena(uint64_t p_capacity = DEFAULT_CAPACITY);
+            // Wipes, unlocks and returns the pages
+            ~SecureArena();
+
+            SecureArena(const SecureArena&) = delete;
+            SecureArena& operator=(const SecureArena&) = delete;
+
+            // Arena of DEFAULT_CAPACITY owned by the calling thread, created on first use
+            static SecureArena& GetThreadInstance();
+
+            // p_alignment must be a power of two, throws std::bad_alloc when the arena is full
+            void*       Allocate(uint64_t p_size, uint64_t p_alignment = 16);
+
+            // Uninitialized room for p_count objects, nothing is constructed or destroyed
+            template<typename T>
+            T*          Allocate(uint64_t p_count)
+            {
+                static_assert(std::is_trivially_destructible<T>::value, "Arena memory is released without running destructors");
+                return static_cast<T*>(Allocate(p_count * sizeof(T), alignof(T)));
+            }
+
+            uint64_t    GetMarker() const   { return m_top; }
+            // Zeroes everything allocated after p_marker and makes it available again
+            void        Release(uint64_t p_marker);
+
+            uint64_t    GetCapacity() const { return m_capacity; }
+            uint64_t    GetUsed() const     { return m_top; }
+            bool        IsLocked() const    { return m_locked; }
+        };
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "NGCrypto/export.h"
+
+#pragma warning(push)
+#pragma warning(disable: 4251)
+
+namespace Cryptography
+{
+    namespace Utils
+    {
+        /**
+         * Fixed set of worker threads, each owning a task deque.
+         * Workers pop their own tasks LIFO and steal the oldest tasks of
+         * other workers when idle, so uneven batches still keep every core busy.
+         * Threads are created once; submitting work never spawns a thread.
+         */
+        class NG_CRYPTO_API ThreadPool
+        {
+        public:
+            using Task = std::function<void()>;
+
+        private:
+            struct Worker
+            {
+                std::deque<Task>    tasks;
+                std::mutex          mutex;
+                std::thread         thread;
+            };
+
+            std::vector<std::unique_ptr<Worker>>    m_workers;
+            std::atomic<uint32_t>                   m_nextWorker {0};
+            std::atomic<uint64_t>                   m_pendingCount {0};
+            std::atomic<bool>                       m_stopping {false};
+            std::mutex                              m_sleepMutex;
+            std::condition_variable                 m_sleepCondition;
+
+            void WorkerLoop(uint32_t p_index);
+            bool TryPop(uint32_t p_index, Task& p_task);
+            bool TrySteal(uint32_t p_thief, Task& p_task);
+
+        public:
+            explicit ThreadPool(uint32_t p_threadCount = std::thread::hardware_concurrency());
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            // Process wide pool sized to the hardware concurrency, created on first use
+            static ThreadPool& GetDefault();
+
+            uint32_t GetThreadCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+            void Submit(Task p_task);
+
+            /**
+             * Runs a queued task on the calling thread if one is available.
+             * Lets a thread blocked on pool work help instead of sleeping.
+             */
+            bool RunPendingTask();
+
+            /**
+             * Splits [0, p_count) into chunks of p_grainSize and runs
+             * p_body(begin, end) for each chunk on the pool.
+             * The calling thread takes part and the call returns once every chunk is done.
+             */
+            void ParallelFor(uint64_t p_count, uint64_t p_grainSize, const std::function<void(uint64_t, uint64_t)>& p_body);
+        };
+    }
+}
+
+#pragma warning(pop)
@@ -1,7 +1,13 @@
 #pragma once
 
+#if defined(NG_CRYPTO_STATIC)
+#define NG_CRYPTO_API
+#elif defined(_WIN32)
 #ifdef NG_CRYPTO_EXPORT
 #define NG_CRYPTO_API __declspec(dllexport)
 #else
 #define NG_CRYPTO_API __declspec(dllimport)
-#endif
\ No newline at end of file
+#endif
+#else
+#define NG_CRYPTO_API __attribute__((visibility("default")))
+#endif
@@ -0,0 +1,300 @@
+#include "NGCrypto/Async/JobScheduler.h"
+#include "NGCrypto/Hash/HMAC.h"
+#include "NGCrypto/Hash/SHA256.h"
+#include <algorithm>
+
+namespace Cryptography
+{
+    namespace Async
+    {
+        namespace
+        {
+            using Clock = std::chrono::steady_clock;
+
+            // Producers are spread over the workers once, so a thread's jobs always meet in the same queue
+            std::atomic<uint32_t>       g_nextProducer {0};
+            thread_local uint32_t       t_producerSlot = UINT32_MAX;
+
+            uint32_t GetProducerSlot()
+            {
+                if (t_producerSlot == UINT32_MAX)
+                    t_producerSlot = g_nextProducer.fetch_add(1, std::memory_order_relaxed) & 0x7FFFFFFF;
+                return t_producerSlot;
+            }
+        }
+
+        Job Job::EncryptECB(const Encryption::AES& p_cipher, const unsigned char* p_data, uint8_t* p_out, uint64_t p_dataLength)
+        {
+            return Job{Algorithm::EncryptECB, &p_cipher, nullptr, 0, p_data, p_dataLength, p_out};
+        }
+
+        Job Job::DecryptECB(const Encryption::AES& p_cipher, const unsigned char* p_data, uint8_t* p_out, uint64_t p_dataLength)
+        {
+            return Job{Algorithm::DecryptECB, &p_cipher, nullptr, 0, p_data, p_dataLength, p_out};
+        }
+
+        Job Job::SHA256(const unsigned char* p_message, uint64_t p_size, uint8_t* p_digest)
+        {
+            return Job{Algorithm::SHA256, nullptr, nullptr, 0, p_message, p_size, p_digest};
+        }
+
+        Job Job::HMACSHA256(const unsigned char* p_key, uint64_t p_keyLength,
+                            const unsigned char* p_message, uint64_t p_size, uint8_t* p_mac)
+        {
+            return Job{Algorithm::HMACSHA256, nullptr, p_key, p_keyLength, p_message, p_size, p_mac};
+        }
+
+        JobScheduler::JobScheduler(uint32_t p_workerCount, std::chrono::microseconds p_latencyBudget, uint64_t p_queueCapacity) :
+            m_latencyBudget(p_latencyBudget)
+        {
+            const uint32_t workerCount = std::max<uint32_t>(p_workerCount, 1);
+
+            m_workers.reserve(workerCount);
+            for (uint32_t i = 0; i < workerCount; ++i)
+                m_workers.emplace_back(std::make_unique<Worker>(p_queueCapacity));
+
+            for (auto& worker : m_workers)
+                worker->thread = std::thread(&JobScheduler::WorkerLoop, this, std::ref(*worker));
+        }
+
+        JobScheduler::~JobScheduler()
+        {
+            m_stopping.store(true);
+            for (auto& worker : m_workers)
+            {
+                {
+                    std::lock_guard<std::mutex> lock(worker->mutex);
+                }
+                worker->condition.notify_one();
+            }
+
+            for (auto& worker : m_workers)
+                worker->thread.join();
+        }
+
+        void JobScheduler::Submit(const Job& p_job, Callback p_callback)
+        {
+            Worker& worker = *m_workers[GetProducerSlot() % m_workers.size()];
+            PendingJob pending{p_job, std::move(p_callback)};
+
+            if (!worker.queue.TryPush(std::move(pending)))
+            {
+                // The worker is behind, running here keeps the caller from blocking
+                m_inlineJobs.fetch_add(1, std::memory_order_relaxed);
+                RunBatch(p_job.algorithm, &pending, 1);
+                if (pending.callback)
+                    pending.callback();
+                return;
+            }
+
+            // Pairs with the fence in WorkerLoop: either the worker sees the job or we see it sleeping
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (worker.sleeping.load(std::memory_order_relaxed))
+            {
+                {
+                    std::lock_guard<std::mutex> lock(worker.mutex);
+                }
+                worker.condition.notify_one();
+            }
+        }
+
+        std::future<void> JobScheduler::Submit(const Job& p_job)
+        {
+            auto promise = std::make_shared<std::promise<void>>();
+            std::future<void> future = promise->get_future();
+            Submit(p_job, [promise] { promise->set_value(); });
+            return future;
+        }
+
+        JobScheduler::Statistics JobScheduler::GetStatistics() const
+        {
+            Statistics statistics{};
+            for (const auto& worker : m_workers)
+            {
+                statistics.completed += worker->completed.load(std::memory_order_relaxed);
+                statistics.batches += worker->batches.load(std::memory_order_relaxed);
+                statistics.timedFlushes += worker->timedFlushes.load(std::memory_order_relaxed);
+            }
+            statistics.inlineJobs = m_inlineJobs.load(std::memory_order_relaxed);
+            return statistics;
+        }
+
+        void JobScheduler::WorkerLoop(Worker& p_worker)
+        {
+            // Bounds one pass, so a steady stream of jobs cannot keep expired groups waiting
+            const uint64_t passLimit = p_worker.queue.GetCapacity();
+            PendingJob pending;
+            for (;;)
+            {
+                bool received = false;
+                for (uint64_t popped = 0; popped < passLimit && p_worker.queue.TryPop(pending); ++popped)
+                {
+                    received = true;
+                    AddToGroup(p_worker, pending);
+                }
+
+                if (m_stopping.load())
+                {
+                    // Producers are done once the destructor runs, one more drain finds everything
+                    while (p_worker.queue.TryPop(pending))
+                        AddToGroup(p_worker, pending);
+                    FlushAll(p_worker);
+                    return;
+                }
+
+                const TimePoint due = FlushExpired(p_worker, Clock::now(), m_latencyBudget);
+                if (received)
+                    continue;
+
+                std::unique_lock<std::mutex> lock(p_worker.mutex);
+                p_worker.sleeping.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!p_worker.queue.HasPending() && !m_stopping.load())
+                {
+                    if (due == TimePoint::max())
+                        p_worker.condition.wait(lock);
+                    else
+                        p_worker.condition.wait_until(lock, due);
+                }
+                p_worker.sleeping.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        uint32_t JobScheduler::GetSizeClass(const Job& p_job)
+        {
+            uint64_t blockCount;
+            switch (p_job.algorithm)
+            {
+            case Algorithm::EncryptECB:
+            case Algorithm::DecryptECB:
+                blockCount = (p_job.size + 15) / 16;
+                break;
+            case Algorithm::HMACSHA256:
+                blockCount = (p_job.size + 9 + 63) / 64 + 1;
+                break;
+            default:
+                blockCount = (p_job.size + 9 + 63) / 64;
+                break;
+            }
+
+            uint32_t sizeClass = 0;
+            while (sizeClass < SIZE_CLASS_COUNT - 1 && (uint64_t(1) << sizeClass) < blockCount)
+                ++sizeClass;
+            return sizeClass;
+        }
+
+        void JobScheduler::AddToGroup(Worker& p_worker, PendingJob& p_pending)
+        {
+            const Algorithm algorithm = p_pending.job.algorithm;
+            const uint32_t sizeClass = GetSizeClass(p_pending.job);
+            Group& group = p_worker.groups[static_cast<uint32_t>(algorithm)][sizeClass];
+
+            // Read when the group opens, the budget runs from its first job
+            if (group.count == 0)
+                group.oldest = Clock::now();
+            group.jobs[group.count++] = std::move(p_pending);
+
+            if (group.count == MAX_BATCH || sizeClass == SIZE_CLASS_COUNT - 1)
+                Dispatch(p_worker, algorithm, group);
+        }
+
+        JobScheduler::TimePoint JobScheduler::FlushExpired(Worker& p_worker, TimePoint p_now, std::chrono::nanoseconds p_budget)
+        {
+            TimePoint due = TimePoint::max();
+            for (uint32_t algorithm = 0; algorithm < static_cast<uint32_t>(Algorithm::Count); ++algorithm)
+            {
+                for (Group& group : p_worker.groups[algorithm])
+                {
+                    if (group.count == 0)
+                        continue;
+
+                    if (group.oldest + p_budget <= p_now)
+                    {
+                        Dispatch(p_worker, static_cast<Algorithm>(algorithm), group);
+                        p_worker.timedFlushes.store(p_worker.timedFlushes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+                    }
+                    else
+                        due = std::min(due, group.oldest + p_budget);
+                }
+            }
+            return due;
+        }
+
+        void JobScheduler::FlushAll(Worker& p_worker)
+        {
+            for (uint32_t algorithm = 0; algorithm < static_cast<uint32_t>(Algorithm::Count); ++algorithm)
+            {
+                for (Group& group : p_worker.groups[algorithm])
+                {
+                    if (group.count != 0)
+                        Dispatch(p_worker, static_cast<Algorithm>(algorithm), group);
+                }
+            }
+        }
+
+        void JobScheduler::Dispatch(Worker& p_worker, Algorithm p_algorithm, Group& p_group)
+        {
+            RunBatch(p_algorithm, p_group.jobs, p_group.count);
+
+            for (uint32_t i = 0; i < p_group.count; ++i)
+            {
+                Callback& callback = p_group.jobs[i].callback;
+                if (callback)
+                    callback();
+                // Drops whatever the completion captured
+                callback = nullptr;
+            }
+
+            p_worker.completed.store(p_worker.completed.load(std::memory_order_relaxed) + p_group.count, std::memory_order_relaxed);
+            p_worker.batches.store(p_worker.batches.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            p_group.count = 0;
+        }
+
+        void JobScheduler::RunBatch(Algorithm p_algorithm, const PendingJob* p_jobs, uint32_t p_count)
+        {
+            switch (p_algorithm)
+            {
+            case Algorithm::EncryptECB:
+            case Algorithm::DecryptECB:
+            {
+                Encryption::AES::ECBRequest requests[MAX_BATCH];
+                for (uint32_t i = 0; i < p_count; ++i)
+                {
+                    const Job& job = p_jobs[i].job;
+                    requests[i] = Encryption::AES::ECBRequest{job.cipher, job.input, job.output, job.size};
+                }
+
+                if (p_algorithm == Algorithm::EncryptECB)
+                    Encryption::AES::EncryptECBBatch(requests, p_count);
+                else
+                    Encryption::AES::DecryptECBBatch(requests, p_count);
+                break;
+            }
+            case Algorithm::SHA256:
+            {
+                Hash::SHA256::HashRequest requests[MAX_BATCH];
+                for (uint32_t i = 0; i < p_count; ++i)
+                {
+                    const Job& job = p_jobs[i].job;
+                    requests[i] = Hash::SHA256::HashRequest{job.input, job.size, job.output};
+                }
+                Hash::SHA256::HashBatch(requests, p_count);
+                break;
+            }
+            case Algorithm::HMACSHA256:
+            {
+                Hash::HMAC::Request requests[MAX_BATCH];
+                for (uint32_t i = 0; i < p_count; ++i)
+                {
+                    const Job& job = p_jobs[i].job;
+                    requests[i] = Hash::HMAC::Request{job.key, job.keyLength, job.input, job.size, job.output};
+                }
+                Hash::HMAC::HMAC_SHA256Batch(requests, p_count);
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+}
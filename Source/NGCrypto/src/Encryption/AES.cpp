@@ -1,107 +1,110 @@
 #include "NGCrypto/Encryption/AES.h"
-#include <cassert>
-#include <Windows.h>
+#include "NGCrypto/Utils/CpuFeatures.h"
+#include "NGCrypto/Utils/SecureArena.h"
+#include "../Utils/InstrumentationProbe.h"
+#include <cstring>
 
 namespace Cryptography
 { 
     namespace Encryption
     {
-        void AES::KeyAssist1(__m128i* p_temp1, __m128i* p_temp2)
+        namespace
         {
-            *p_temp2 = _mm_shuffle_epi32(*p_temp2, 0xff);
+            const unsigned char ROUND_CONSTANTS[7] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40};
 
-            __m128i temp4 = _mm_slli_si128(*p_temp1, 0x4);
-            *p_temp1 = _mm_xor_si128(*p_temp1, temp4);        
-            temp4 = _mm_slli_si128(*p_temp1, 0x4);
-            *p_temp1 = _mm_xor_si128(*p_temp1, temp4);
-            temp4 = _mm_slli_si128(*p_temp1, 0x4);
-            *p_temp1 = _mm_xor_si128(*p_temp1, temp4);
-
-            *p_temp1 = _mm_xor_si128(*p_temp1, *p_temp2);
-        }
+            // Chosen once, the first time an AES instance is used
+            bool UseAESNI()
+            {
+                static const bool aesni = Utils::CpuFeatures::Get().aesni;
+                return aesni;
+            }
 
-        void AES::KeyAssist2(__m128i* p_temp1, __m128i* p_temp3)
-        {
-            __m128i temp4 = _mm_aeskeygenassist_si128(*p_temp1, 0x0);
-            const __m128i temp2 = _mm_shuffle_epi32(temp4, 0xaa);
+            inline unsigned char XTime(unsigned char p_value)
+            {
+                return static_cast<unsigned char>((p_value << 1) ^ ((p_value >> 7) * 0x1b));
+            }
 
-            temp4 = _mm_slli_si128(*p_temp3, 0x4);
-            *p_temp3 = _mm_xor_si128(*p_temp3, temp4);
-            temp4 = _mm_slli_si128(*p_temp3, 0x4);
-            *p_temp3 = _mm_xor_si128(*p_temp3, temp4);
-            temp4 = _mm_slli_si128(*p_temp3, 0x4);
-            *p_temp3 = _mm_xor_si128(*p_temp3, temp4);
+            void MixColumns(unsigned char p_state[16])
+            {
+                for (int c = 0; c < 4; ++c)
+                {
+                    unsigned char* column = p_state + 4 * c;
+                    const unsigned char a0 = column[0], a1 = column[1], a2 = column[2], a3 = column[3];
+                    const unsigned char all = a0 ^ a1 ^ a2 ^ a3;
+                    column[0] ^= all ^ XTime(a0 ^ a1);
+                    column[1] ^= all ^ XTime(a1 ^ a2);
+                    column[2] ^= all ^ XTime(a2 ^ a3);
+                    column[3] ^= all ^ XTime(a3 ^ a0);
+                }
+            }
 
-            *p_temp3 = _mm_xor_si128(*p_temp3, temp2);
+            void InvMixColumns(unsigned char p_state[16])
+            {
+                // {0e, 0b, 0d, 09} = {02, 03, 01, 01} x {05, 00, 04, 00}
+                for (int c = 0; c < 4; ++c)
+                {
+                    unsigned char* column = p_state + 4 * c;
+                    const unsigned char u = XTime(XTime(column[0] ^ column[2]));
+                    const unsigned char v = XTime(XTime(column[1] ^ column[3]));
+                    column[0] ^= u;
+                    column[1] ^= v;
+                    column[2] ^= u;
+                    column[3] ^= v;
+                }
+                MixColumns(p_state);
+            }
 
+            inline void AddRoundKey(unsigned char p_state[16], const __m128i& p_roundKey)
+            {
+                const unsigned char* key = reinterpret_cast<const unsigned char*>(&p_roundKey);
+                for (int i = 0; i < 16; ++i)
+                    p_state[i] ^= key[i];
+            }
         }
 
         void AES::GenerateEncryptionRoundKeys()
         {
+            // FIPS-197 key expansion for Nk = 8, round keys are the words in memory order
+            unsigned char* words = reinterpret_cast<unsigned char*>(encryptionRoundKeys);
+            memcpy(words, cipherKey, 32);
+
+            for (int i = 8; i < 4 * (ROUND_COUNT + 1); ++i)
+            {
+                unsigned char temp[4];
+                memcpy(temp, words + 4 * (i - 1), 4);
+                if (i % 8 == 0)
+                {
+                    const unsigned char first = temp[0];
+                    temp[0] = sbox[temp[1]] ^ ROUND_CONSTANTS[i / 8 - 1];
+                    temp[1] = sbox[temp[2]];
+                    temp[2] = sbox[temp[3]];
+                    temp[3] = sbox[first];
+                }
+                else if (i % 8 == 4)
+                {
+                    for (int j = 0; j < 4; ++j)
+                        temp[j] = sbox[temp[j]];
+                }
 
-            __m128i temp1 = cipherKey[0];
-            __m128i temp3 = cipherKey[1];
-
-            encryptionRoundKeys[0] = temp1;
-            encryptionRoundKeys[1] = temp3;
-
-            __m128i temp2 = _mm_aeskeygenassist_si128(temp3, 0x01);
-            KeyAssist1(&temp1, &temp2);
-            encryptionRoundKeys[2] = temp1;
-            KeyAssist2(&temp1, &temp3);
-            encryptionRoundKeys[3] = temp3;
-
-            temp2 = _mm_aeskeygenassist_si128(temp3, 0x02);
-            KeyAssist1(&temp1, &temp2);
-            encryptionRoundKeys[4] = temp1;
-            KeyAssist2(&temp1, &temp3);
-            encryptionRoundKeys[5] = temp3;
-            
-            temp2 = _mm_aeskeygenassist_si128(temp3, 0x04);
-            KeyAssist1(&temp1, &temp2);
-            encryptionRoundKeys[6] = temp1;
-            KeyAssist2(&temp1, &temp3);
-            encryptionRoundKeys[7] = temp3;
-            
-            temp2 = _mm_aeskeygenassist_si128(temp3, 0x08);
-            KeyAssist1(&temp1, &temp2);
-            encryptionRoundKeys[8] = temp1;
-            KeyAssist2(&temp1, &temp3);
-            encryptionRoundKeys[9] = temp3;
-            
-            temp2 = _mm_aeskeygenassist_si128(temp3, 0x10);
-            KeyAssist1(&temp1, &temp2);
-            encryptionRoundKeys[10] = temp1;
-            KeyAssist2(&temp1, &temp3);
-            encryptionRoundKeys[11] = temp3;
-
-            
-            temp2 = _mm_aeskeygenassist_si128(temp3, 0x20);
-            KeyAssist1(&temp1, &temp2);
-            encryptionRoundKeys[12] = temp1;
-            KeyAssist2(&temp1, &temp3);
-            encryptionRoundKeys[13] = temp3;
-
-            
-            temp2 = _mm_aeskeygenassist_si128(temp3, 0x40);
-            KeyAssist1(&temp1, &temp2);
-            encryptionRoundKeys[14] = temp1;
+                for (int j = 0; j < 4; ++j)
+                    words[4 * i + j] = words[4 * (i - 8) + j] ^ temp[j];
+            }
         }
 
         void AES::GenerateDecryptionRoundKeys()
         {
+            // Equivalent inverse cipher, the layout aesdec expects
             decryptionRoundKeys[0] = encryptionRoundKeys[ROUND_COUNT];
             for (int i = 1; i < ROUND_COUNT; ++i)
             {
-                decryptionRoundKeys[i] = _mm_aesimc_si128(encryptionRoundKeys[ROUND_COUNT - i]);
+                decryptionRoundKeys[i] = encryptionRoundKeys[ROUND_COUNT - i];
+                InvMixColumns(reinterpret_cast<unsigned char*>(&decryptionRoundKeys[i]));
             }
             decryptionRoundKeys[ROUND_COUNT] = encryptionRoundKeys[0];
         }
 
         AES::AES(const unsigned char p_cipherKey[64])
         {
-            assert(IsProcessorFeaturePresent(PF_XMMI64_INSTRUCTIONS_AVAILABLE));
-
             cipherKey[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_cipherKey));
             cipherKey[1] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_cipherKey + 16));
 
@@ -110,49 +113,172 @@ namespace Cryptography
 
         }
 
+        AES::~AES()
+        {
+            Utils::SecureZero(cipherKey, sizeof(cipherKey));
+            Utils::SecureZero(encryptionRoundKeys, sizeof(encryptionRoundKeys));
+            Utils::SecureZero(decryptionRoundKeys, sizeof(decryptionRoundKeys));
+        }
+
+        void AES::EncryptBlock(const unsigned char* p_data, unsigned char* p_out) const
+        {
+            unsigned char state[16];
+            memcpy(state, p_data, 16);
+            AddRoundKey(state, encryptionRoundKeys[0]);
+
+            for (int round = 1; round <= ROUND_COUNT; ++round)
+            {
+                // SubBytes and ShiftRows, row r of column c comes from column c + r
+                unsigned char shifted[16];
+                for (int c = 0; c < 4; ++c)
+                    for (int r = 0; r < 4; ++r)
+                        shifted[4 * c + r] = sbox[state[4 * ((c + r) % 4) + r]];
+                memcpy(state, shifted, 16);
+
+                if (round != ROUND_COUNT)
+                    MixColumns(state);
+                AddRoundKey(state, encryptionRoundKeys[round]);
+            }
+            memcpy(p_out, state, 16);
+        }
+
+        void AES::DecryptBlock(const unsigned char* p_data, unsigned char* p_out) const
+        {
+            unsigned char state[16];
+            memcpy(state, p_data, 16);
+            AddRoundKey(state, decryptionRoundKeys[0]);
+
+            for (int round = 1; round <= ROUND_COUNT; ++round)
+            {
+                // InvSubBytes and InvShiftRows, row r of column c comes from column c - r
+                unsigned char shifted[16];
+                for (int c = 0; c < 4; ++c)
+                    for (int r = 0; r < 4; ++r)
+                        shifted[4 * c + r] = sboxinv[state[4 * ((c + 4 - r) % 4) + r]];
+                memcpy(state, shifted, 16);
+
+                if (round != ROUND_COUNT)
+                    InvMixColumns(state);
+                AddRoundKey(state, decryptionRoundKeys[round]);
+            }
+            memcpy(p_out, state, 16);
+        }
+
         void AES::EncryptECB(const unsigned char* p_data, unsigned char* p_out, uint64_t p_dataLength)
         {
+            NG_CRYPTO_PROBE(Utils::Operation::AESEncrypt, p_dataLength);
+
             if(p_dataLength % 16) 
                 p_dataLength = p_dataLength / 16 + 1; 
             else 
                 p_dataLength = p_dataLength / 16;
 
-            for(uint32_t i = 0; i < p_dataLength; ++i)
+            if (UseAESNI())
             {
-                __m128i temp = _mm_loadu_si128(&(reinterpret_cast<const __m128i*>(p_data))[i]);
-                temp = _mm_xor_si128(temp, encryptionRoundKeys[0]);
-
-                for(int j = 1; j < ROUND_COUNT; j++)
-                {
-                    temp = _mm_aesenc_si128(temp, encryptionRoundKeys[j]);
-                }
-
-                temp = _mm_aesenclast_si128(temp, encryptionRoundKeys[ROUND_COUNT]);
-
-                _mm_storeu_si128(&(reinterpret_cast<__m128i*>(p_out))[i], temp);
+                EncryptBlocksNI(encryptionRoundKeys, p_data, p_out, p_dataLength);
+                return;
             }
+
+            for(uint64_t i = 0; i < p_dataLength; ++i)
+                EncryptBlock(p_data + 16 * i, p_out + 16 * i);
         }
 
         void AES::DecryptECB(const unsigned char* p_data, unsigned char* p_out, uint64_t p_dataLength)
         {
+            NG_CRYPTO_PROBE(Utils::Operation::AESDecrypt, p_dataLength);
+
             if(p_dataLength % 16) 
                 p_dataLength = p_dataLength / 16 + 1; 
             else 
                 p_dataLength = p_dataLength / 16;
 
-            for(uint32_t i = 0; i < p_dataLength; ++i)
+            if (UseAESNI())
+            {
+                DecryptBlocksNI(decryptionRoundKeys, p_data, p_out, p_dataLength);
+                return;
+            }
+
+            for(uint64_t i = 0; i < p_dataLength; ++i)
+                DecryptBlock(p_data + 16 * i, p_out + 16 * i);
+        }
+
+        void AES::EncryptECBBatch(const ECBRequest* p_requests, uint64_t p_count)
+        {
+            uint64_t bytes = 0;
+            for (uint64_t i = 0; i < p_count; ++i)
+                bytes += p_requests[i].dataLength;
+            NG_CRYPTO_PROBE(Utils::Operation::AESEncrypt, bytes);
+            (void)bytes;
+
+            RunECBBatch(p_requests, p_count, false);
+        }
+
+        void AES::DecryptECBBatch(const ECBRequest* p_requests, uint64_t p_count)
+        {
+            uint64_t bytes = 0;
+            for (uint64_t i = 0; i < p_count; ++i)
+                bytes += p_requests[i].dataLength;
+            NG_CRYPTO_PROBE(Utils::Operation::AESDecrypt, bytes);
+            (void)bytes;
+
+            RunECBBatch(p_requests, p_count, true);
+        }
+
+        void AES::RunECBBatch(const ECBRequest* p_requests, uint64_t p_count, bool p_decrypt)
+        {
+            const bool aesni = UseAESNI();
+            const uint32_t GATHER_SIZE = 32;
+            BlockRef gathered[GATHER_SIZE];
+            uint32_t gatheredCount = 0;
+
+            for (uint64_t i = 0; i < p_count; ++i)
             {
-                __m128i temp = _mm_loadu_si128(&(reinterpret_cast<const __m128i*>(p_data))[i]);
-                temp = _mm_xor_si128(temp, decryptionRoundKeys[0]);
+                const ECBRequest& request = p_requests[i];
+                const AES& cipher = *request.cipher;
+                const uint64_t blockCount = (request.dataLength + 15) / 16;
 
-                for(int j = 1; j < ROUND_COUNT; j++)
+                if (!aesni)
                 {
-                    temp = _mm_aesdec_si128(temp, decryptionRoundKeys[j]);
+                    for (uint64_t block = 0; block < blockCount; ++block)
+                    {
+                        if (p_decrypt)
+                            cipher.DecryptBlock(request.data + 16 * block, request.out + 16 * block);
+                        else
+                            cipher.EncryptBlock(request.data + 16 * block, request.out + 16 * block);
+                    }
+                    continue;
                 }
 
-                temp = _mm_aesdeclast_si128(temp, decryptionRoundKeys[ROUND_COUNT]);
+                const __m128i* roundKeys = p_decrypt ? cipher.decryptionRoundKeys : cipher.encryptionRoundKeys;
+                const uint64_t wholeBlocks = blockCount & ~uint64_t(3);
+                if (wholeBlocks)
+                {
+                    if (p_decrypt)
+                        DecryptBlocksNI(roundKeys, request.data, request.out, wholeBlocks);
+                    else
+                        EncryptBlocksNI(roundKeys, request.data, request.out, wholeBlocks);
+                }
 
-                _mm_storeu_si128(&(reinterpret_cast<__m128i*>(p_out))[i], temp);
+                for (uint64_t block = wholeBlocks; block < blockCount; ++block)
+                {
+                    gathered[gatheredCount++] = BlockRef{roundKeys, request.data + 16 * block, request.out + 16 * block};
+                    if (gatheredCount == GATHER_SIZE)
+                    {
+                        if (p_decrypt)
+                            DecryptGatherNI(gathered, gatheredCount);
+                        else
+                            EncryptGatherNI(gathered, gatheredCount);
+                        gatheredCount = 0;
+                    }
+                }
+            }
+
+            if (gatheredCount)
+            {
+                if (p_decrypt)
+                    DecryptGatherNI(gathered, gatheredCount);
+                else
+                    EncryptGatherNI(gathered, gatheredCount);
             }
         }
 
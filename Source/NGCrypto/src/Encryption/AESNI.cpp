@@ -0,0 +1,153 @@
+#include "NGCrypto/Encryption/AES.h"
+#include <wmmintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("aes"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("aes")
+#endif
+
+namespace Cryptography
+{
+    namespace Encryption
+    {
+        // aesenc has a latency of several cycles but issues every cycle, four independent blocks keep the unit busy
+        void AES::EncryptBlocksNI(const __m128i* p_roundKeys, const unsigned char* p_data, unsigned char* p_out, uint64_t p_blockCount)
+        {
+            const __m128i* in = reinterpret_cast<const __m128i*>(p_data);
+            __m128i* out = reinterpret_cast<__m128i*>(p_out);
+
+            uint64_t i = 0;
+            for (; i + 4 <= p_blockCount; i += 4)
+            {
+                __m128i block0 = _mm_xor_si128(_mm_loadu_si128(in + i + 0), p_roundKeys[0]);
+                __m128i block1 = _mm_xor_si128(_mm_loadu_si128(in + i + 1), p_roundKeys[0]);
+                __m128i block2 = _mm_xor_si128(_mm_loadu_si128(in + i + 2), p_roundKeys[0]);
+                __m128i block3 = _mm_xor_si128(_mm_loadu_si128(in + i + 3), p_roundKeys[0]);
+
+                for (int j = 1; j < ROUND_COUNT; ++j)
+                {
+                    block0 = _mm_aesenc_si128(block0, p_roundKeys[j]);
+                    block1 = _mm_aesenc_si128(block1, p_roundKeys[j]);
+                    block2 = _mm_aesenc_si128(block2, p_roundKeys[j]);
+                    block3 = _mm_aesenc_si128(block3, p_roundKeys[j]);
+                }
+
+                _mm_storeu_si128(out + i + 0, _mm_aesenclast_si128(block0, p_roundKeys[ROUND_COUNT]));
+                _mm_storeu_si128(out + i + 1, _mm_aesenclast_si128(block1, p_roundKeys[ROUND_COUNT]));
+                _mm_storeu_si128(out + i + 2, _mm_aesenclast_si128(block2, p_roundKeys[ROUND_COUNT]));
+                _mm_storeu_si128(out + i + 3, _mm_aesenclast_si128(block3, p_roundKeys[ROUND_COUNT]));
+            }
+
+            for (; i < p_blockCount; ++i)
+            {
+                __m128i block = _mm_xor_si128(_mm_loadu_si128(in + i), p_roundKeys[0]);
+                for (int j = 1; j < ROUND_COUNT; ++j)
+                    block = _mm_aesenc_si128(block, p_roundKeys[j]);
+                _mm_storeu_si128(out + i, _mm_aesenclast_si128(block, p_roundKeys[ROUND_COUNT]));
+            }
+        }
+
+        void AES::DecryptBlocksNI(const __m128i* p_roundKeys, const unsigned char* p_data, unsigned char* p_out, uint64_t p_blockCount)
+        {
+            const __m128i* in = reinterpret_cast<const __m128i*>(p_data);
+            __m128i* out = reinterpret_cast<__m128i*>(p_out);
+
+            uint64_t i = 0;
+            for (; i + 4 <= p_blockCount; i += 4)
+            {
+                __m128i block0 = _mm_xor_si128(_mm_loadu_si128(in + i + 0), p_roundKeys[0]);
+                __m128i block1 = _mm_xor_si128(_mm_loadu_si128(in + i + 1), p_roundKeys[0]);
+                __m128i block2 = _mm_xor_si128(_mm_loadu_si128(in + i + 2), p_roundKeys[0]);
+                __m128i block3 = _mm_xor_si128(_mm_loadu_si128(in + i + 3), p_roundKeys[0]);
+
+                for (int j = 1; j < ROUND_COUNT; ++j)
+                {
+                    block0 = _mm_aesdec_si128(block0, p_roundKeys[j]);
+                    block1 = _mm_aesdec_si128(block1, p_roundKeys[j]);
+                    block2 = _mm_aesdec_si128(block2, p_roundKeys[j]);
+                    block3 = _mm_aesdec_si128(block3, p_roundKeys[j]);
+                }
+
+                _mm_storeu_si128(out + i + 0, _mm_aesdeclast_si128(block0, p_roundKeys[ROUND_COUNT]));
+                _mm_storeu_si128(out + i + 1, _mm_aesdeclast_si128(block1, p_roundKeys[ROUND_COUNT]));
+                _mm_storeu_si128(out + i + 2, _mm_aesdeclast_si128(block2, p_roundKeys[ROUND_COUNT]));
+                _mm_storeu_si128(out + i + 3, _mm_aesdeclast_si128(block3, p_roundKeys[ROUND_COUNT]));
+            }
+
+            for (; i < p_blockCount; ++i)
+            {
+                __m128i block = _mm_xor_si128(_mm_loadu_si128(in + i), p_roundKeys[0]);
+                for (int j = 1; j < ROUND_COUNT; ++j)
+                    block = _mm_aesdec_si128(block, p_roundKeys[j]);
+                _mm_storeu_si128(out + i, _mm_aesdeclast_si128(block, p_roundKeys[ROUND_COUNT]));
+            }
+        }
+
+        // Same interleave as EncryptBlocksNI, every block brings its own round keys
+        void AES::EncryptGatherNI(const BlockRef* p_blocks, uint64_t p_blockCount)
+        {
+            uint64_t i = 0;
+            for (; i + 4 <= p_blockCount; i += 4)
+            {
+                const BlockRef* blocks = p_blocks + i;
+                __m128i block0 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[0].data)), blocks[0].roundKeys[0]);
+                __m128i block1 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[1].data)), blocks[1].roundKeys[0]);
+                __m128i block2 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[2].data)), blocks[2].roundKeys[0]);
+                __m128i block3 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[3].data)), blocks[3].roundKeys[0]);
+
+                for (int j = 1; j < ROUND_COUNT; ++j)
+                {
+                    block0 = _mm_aesenc_si128(block0, blocks[0].roundKeys[j]);
+                    block1 = _mm_aesenc_si128(block1, blocks[1].roundKeys[j]);
+                    block2 = _mm_aesenc_si128(block2, blocks[2].roundKeys[j]);
+                    block3 = _mm_aesenc_si128(block3, blocks[3].roundKeys[j]);
+                }
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(blocks[0].out), _mm_aesenclast_si128(block0, blocks[0].roundKeys[ROUND_COUNT]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(blocks[1].out), _mm_aesenclast_si128(block1, blocks[1].roundKeys[ROUND_COUNT]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(blocks[2].out), _mm_aesenclast_si128(block2, blocks[2].roundKeys[ROUND_COUNT]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(blocks[3].out), _mm_aesenclast_si128(block3, blocks[3].roundKeys[ROUND_COUNT]));
+            }
+
+            for (; i < p_blockCount; ++i)
+                EncryptBlocksNI(p_blocks[i].roundKeys, p_blocks[i].data, p_blocks[i].out, 1);
+        }
+
+        void AES::DecryptGatherNI(const BlockRef* p_blocks, uint64_t p_blockCount)
+        {
+            uint64_t i = 0;
+            for (; i + 4 <= p_blockCount; i += 4)
+            {
+                const BlockRef* blocks = p_blocks + i;
+                __m128i block0 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[0].data)), blocks[0].roundKeys[0]);
+                __m128i block1 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[1].data)), blocks[1].roundKeys[0]);
+                __m128i block2 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[2].data)), blocks[2].roundKeys[0]);
+                __m128i block3 = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks[3].data)), blocks[3].roundKeys[0]);
+
+                for (int j = 1; j < ROUND_COUNT; ++j)
+                {
+                    block0 = _mm_aesdec_si128(block0, blocks[0].roundKeys[j]);
+                    block1 = _mm_aesdec_si128(block1, blocks[1].roundKeys[j]);
+                    block2 = _mm_aesdec_si128(block2, blocks[2].roundKeys[j]);
+                    block3 = _mm_aesdec_si128(block3, blocks[3].roundKeys[j]);
+                }
+
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(blocks[0].out), _mm_aesdeclast_si128(block0, blocks[0].roundKeys[ROUND_COUNT]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(blocks[1].out), _mm_aesdeclast_si128(block1, blocks[1].roundKeys[ROUND_COUNT]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(blocks[2].out), _mm_aesdeclast_si128(block2, blocks[2].roundKeys[ROUND_COUNT]));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(blocks[3].out), _mm_aesdeclast_si128(block3, blocks[3].roundKeys[ROUND_COUNT]));
+            }
+
+            for (; i < p_blockCount; ++i)
+                DecryptBlocksNI(p_blocks[i].roundKeys, p_blocks[i].data, p_blocks[i].out, 1);
+        }
+    }
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
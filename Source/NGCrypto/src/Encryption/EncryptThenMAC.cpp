@@ -0,0 +1,110 @@
+#include "NGCrypto/Encryption/EncryptThenMAC.h"
+#include "NGCrypto/Hash/HMAC.h"
+#include "NGCrypto/Random/CtrDrbg.h"
+#include "NGCrypto/Utils/SecureArena.h"
+#include <cstring>
+
+namespace Cryptography
+{
+    namespace Encryption
+    {
+        namespace
+        {
+            // Runs over every byte whatever the contents, so timing says nothing about where tags differ
+            bool ConstantTimeEquals(const uint8_t* p_a, const uint8_t* p_b, uint32_t p_size)
+            {
+                volatile uint8_t difference = 0;
+                for (uint32_t i = 0; i < p_size; ++i)
+                    difference = difference | (p_a[i] ^ p_b[i]);
+                return difference == 0;
+            }
+        }
+
+        EncryptThenMAC::EncryptThenMAC(const unsigned char p_encryptionKey[KEY_SIZE], const unsigned char p_macKey[KEY_SIZE]) :
+            m_cipher(p_encryptionKey)
+        {
+            memcpy(m_macKey, p_macKey, KEY_SIZE);
+        }
+
+        EncryptThenMAC::~EncryptThenMAC()
+        {
+            Utils::SecureZero(m_macKey, KEY_SIZE);
+        }
+
+        void EncryptThenMAC::ApplyKeystream(const uint8_t* p_nonce, const unsigned char* p_in, unsigned char* p_out, uint64_t p_size)
+        {
+            // Counter blocks are encrypted a chunk at a time so the AES-NI kernel gets four blocks per round
+            const uint32_t CHUNK_BLOCKS = 16;
+            uint8_t keystream[CHUNK_BLOCKS * 16];
+            uint32_t counter = 0;
+
+            for (uint64_t offset = 0; offset < p_size; offset += sizeof(keystream))
+            {
+                const uint64_t size = (p_size - offset < sizeof(keystream)) ? p_size - offset : sizeof(keystream);
+                const uint32_t blockCount = static_cast<uint32_t>((size + 15) / 16);
+                for (uint32_t i = 0; i < blockCount; ++i, ++counter)
+                {
+                    uint8_t* block = keystream + i * 16;
+                    memcpy(block, p_nonce, NONCE_SIZE);
+                    block[12] = static_cast<uint8_t>(counter >> 24);
+                    block[13] = static_cast<uint8_t>(counter >> 16);
+                    block[14] = static_cast<uint8_t>(counter >> 8);
+                    block[15] = static_cast<uint8_t>(counter);
+                }
+                m_cipher.EncryptECB(keystream, keystream, blockCount * 16);
+
+                for (uint64_t i = 0; i < size; ++i)
+                    p_out[offset + i] = p_in[offset + i] ^ keystream[i];
+            }
+
+            Utils::SecureZero(keystream, sizeof(keystream));
+        }
+
+        uint64_t EncryptThenMAC::Seal(unsigned char* p_out, const unsigned char* p_plaintext, uint64_t p_size)
+        {
+            if (p_size > MAX_PLAINTEXT)
+                return 0;
+
+            // The plaintext may live at the payload offset, so it is encrypted before anything overwrites it
+            uint8_t nonce[NONCE_SIZE];
+            Random::CtrDrbg::Fill(nonce, NONCE_SIZE);
+            ApplyKeystream(nonce, p_plaintext, p_out + PAYLOAD_OFFSET, p_size);
+
+            p_out[0] = VERSION;
+            p_out[1] = 0;
+            p_out[2] = 0;
+            p_out[3] = 0;
+            p_out[4] = static_cast<uint8_t>(p_size >> 24);
+            p_out[5] = static_cast<uint8_t>(p_size >> 16);
+            p_out[6] = static_cast<uint8_t>(p_size >> 8);
+            p_out[7] = static_cast<uint8_t>(p_size);
+            memcpy(p_out + HEADER_SIZE, nonce, NONCE_SIZE);
+
+            const auto tag = Hash::HMAC::HMAC_SHA256(m_macKey, KEY_SIZE, p_out, PAYLOAD_OFFSET + p_size);
+            memcpy(p_out + PAYLOAD_OFFSET + p_size, tag.data(), TAG_SIZE);
+            return GetFrameSize(p_size);
+        }
+
+        bool EncryptThenMAC::Open(unsigned char* p_out, const unsigned char* p_frame, uint64_t p_frameLength)
+        {
+            if (p_frameLength < OVERHEAD || p_frameLength - OVERHEAD > MAX_PLAINTEXT)
+                return false;
+
+            const uint64_t size = p_frameLength - OVERHEAD;
+            const uint64_t encodedSize = (uint64_t(p_frame[4]) << 24) | (uint64_t(p_frame[5]) << 16) |
+                                         (uint64_t(p_frame[6]) << 8) | uint64_t(p_frame[7]);
+            if (p_frame[0] != VERSION || p_frame[1] || p_frame[2] || p_frame[3] || encodedSize != size)
+                return false;
+
+            const auto tag = Hash::HMAC::HMAC_SHA256(m_macKey, KEY_SIZE, p_frame, PAYLOAD_OFFSET + size);
+            if (!ConstantTimeEquals(tag.data(), p_frame + PAYLOAD_OFFSET + size, TAG_SIZE))
+                return false;
+
+            // p_out may start anywhere up to the ciphertext, the nonce is kept aside before decrypting over it
+            uint8_t nonce[NONCE_SIZE];
+            memcpy(nonce, p_frame + HEADER_SIZE, NONCE_SIZE);
+            ApplyKeystream(nonce, p_frame + PAYLOAD_OFFSET, p_out, size);
+            return true;
+        }
+    }
+}
@@ -1,73 +1,97 @@
 #include "NGCrypto/Hash/HMAC.h"
 #include "NGCrypto/Hash/SHA256.h"
-#include <vector>
+#include "NGCrypto/Utils/SecureArena.h"
+#include "../Utils/InstrumentationProbe.h"
+#include <cstring>
 
 namespace Cryptography
 {
     namespace Hash
     {
+        void HMAC::LoadKey(const unsigned char* p_key, uint64_t p_keyLength, uint8_t* p_block)
+        {
+            memset(p_block, 0, SHA256::BLOCK_SIZE);
+            if(p_keyLength > SHA256::BLOCK_SIZE)
+            {
+                auto hashedKey = SHA256().Hash(p_key, p_keyLength);
+                memcpy(p_block, hashedKey.data(), SHA256::OUTPUT_SIZE);
+                Utils::SecureZero(hashedKey.data(), SHA256::OUTPUT_SIZE);
+            }
+            else
+                memcpy(p_block, p_key, static_cast<size_t>(p_keyLength));
+        }
+
         std::array<uint8_t,32> HMAC::HMAC_SHA256(const uint8_t* p_key, uint64_t p_keyLength, 
                                     const uint8_t* p_message, uint64_t p_messageLength)
         {
-            uint8_t key[SHA256::BLOCK_SIZE] = {0};
+            NG_CRYPTO_PROBE(Utils::Operation::HMACSHA256, p_messageLength);
 
-            if(p_keyLength > SHA256::BLOCK_SIZE)
-                memcpy(key, &(SHA256().Hash(p_key, p_keyLength)[0]), SHA256::OUTPUT_SIZE);
-            else
-                memcpy(key, p_key, static_cast<size_t>(p_keyLength));
+            // Key blocks live in the thread's locked arena and are zeroed when the scope closes
+            Utils::SecureArena& arena = Utils::SecureArena::GetThreadInstance();
+            const Utils::SecureArena::Scope scope(arena);
+            uint8_t* key = arena.Allocate<uint8_t>(SHA256::BLOCK_SIZE);
+            uint8_t* padKey = arena.Allocate<uint8_t>(SHA256::BLOCK_SIZE);
+            LoadKey(p_key, p_keyLength, key);
 
-            uint8_t iPadKey [SHA256::BLOCK_SIZE];
-            uint8_t oPadKey [SHA256::BLOCK_SIZE];
-            memset(iPadKey, 0x36, SHA256::BLOCK_SIZE);
-            memset(oPadKey, 0x5c, SHA256::BLOCK_SIZE);
-            
-            for(uint8_t i = 0; i < 4; ++i)
+            SHA256 sha;
+            for(uint32_t i = 0; i < SHA256::BLOCK_SIZE; ++i)
+                padKey[i] = key[i] ^ 0x36;
+            sha.Update(padKey, SHA256::BLOCK_SIZE);
+            sha.Update(p_message, p_messageLength);
+            auto shaIPad = sha.Final();
+
+            for(uint32_t i = 0; i < SHA256::BLOCK_SIZE; ++i)
+                padKey[i] = key[i] ^ 0x5c;
+            sha.Update(padKey, SHA256::BLOCK_SIZE);
+            sha.Update(shaIPad.data(), SHA256::OUTPUT_SIZE);
+            Utils::SecureZero(shaIPad.data(), SHA256::OUTPUT_SIZE);
+            return sha.Final();
+        }
+
+        void HMAC::HMAC_SHA256Batch(const Request* p_requests, uint64_t p_count)
+        {
+            uint64_t bytes = 0;
+            for (uint64_t i = 0; i < p_count; ++i)
+                bytes += p_requests[i].messageLength;
+            NG_CRYPTO_PROBE(Utils::Operation::HMACSHA256, bytes);
+            (void)bytes;
+
+            const uint32_t CHUNK = 16;
+            SHA256::Lane lanes[CHUNK];
+            Utils::SecureArena& arena = Utils::SecureArena::GetThreadInstance();
+
+            for (uint64_t first = 0; first < p_count; first += CHUNK)
             {
-                iPadKey[i * 16 + 0]  ^= key[i * 16 + 0];
-                iPadKey[i * 16 + 1]  ^= key[i * 16 + 1];
-                iPadKey[i * 16 + 2]  ^= key[i * 16 + 2];
-                iPadKey[i * 16 + 3]  ^= key[i * 16 + 3];
-                iPadKey[i * 16 + 4]  ^= key[i * 16 + 4];
-                iPadKey[i * 16 + 5]  ^= key[i * 16 + 5];
-                iPadKey[i * 16 + 6]  ^= key[i * 16 + 6];
-                iPadKey[i * 16 + 7]  ^= key[i * 16 + 7];            
-                iPadKey[i * 16 + 8]  ^= key[i * 16 + 8];
-                iPadKey[i * 16 + 9]  ^= key[i * 16 + 9];
-                iPadKey[i * 16 + 10] ^= key[i * 16 + 10];
-                iPadKey[i * 16 + 11] ^= key[i * 16 + 11];
-                iPadKey[i * 16 + 12] ^= key[i * 16 + 12];
-                iPadKey[i * 16 + 13] ^= key[i * 16 + 13];
-                iPadKey[i * 16 + 14] ^= key[i * 16 + 14];
-                iPadKey[i * 16 + 15] ^= key[i * 16 + 15];
-                           
-                oPadKey[i * 16 + 0]  ^= key[i * 16 + 0];
-                oPadKey[i * 16 + 1]  ^= key[i * 16 + 1];
-                oPadKey[i * 16 + 2]  ^= key[i * 16 + 2];
-                oPadKey[i * 16 + 3]  ^= key[i * 16 + 3];
-                oPadKey[i * 16 + 4]  ^= key[i * 16 + 4];
-                oPadKey[i * 16 + 5]  ^= key[i * 16 + 5];
-                oPadKey[i * 16 + 6]  ^= key[i * 16 + 6];
-                oPadKey[i * 16 + 7]  ^= key[i * 16 + 7];
-                oPadKey[i * 16 + 8]  ^= key[i * 16 + 8];
-                oPadKey[i * 16 + 9]  ^= key[i * 16 + 9];
-                oPadKey[i * 16 + 10] ^= key[i * 16 + 10];
-                oPadKey[i * 16 + 11] ^= key[i * 16 + 11];
-                oPadKey[i * 16 + 12] ^= key[i * 16 + 12];
-                oPadKey[i * 16 + 13] ^= key[i * 16 + 13];
-                oPadKey[i * 16 + 14] ^= key[i * 16 + 14];
-                oPadKey[i * 16 + 15] ^= key[i * 16 + 15];
-            }
+                const uint64_t count = (p_count - first < CHUNK) ? p_count - first : CHUNK;
+                const Utils::SecureArena::Scope scope(arena);
+                uint8_t* key = arena.Allocate<uint8_t>(SHA256::BLOCK_SIZE);
+                // Inner and outer pad of each request, then the inner digests
+                uint8_t* pads = arena.Allocate<uint8_t>(count * 2 * SHA256::BLOCK_SIZE);
+                uint8_t* inner = arena.Allocate<uint8_t>(count * SHA256::OUTPUT_SIZE);
 
-            std::vector<uint8_t>sha;
-            sha.resize(static_cast<size_t>(p_messageLength + SHA256::BLOCK_SIZE), 0);
-            memcpy(&sha[0],                  iPadKey, SHA256::BLOCK_SIZE);
-            memcpy(&sha[SHA256::BLOCK_SIZE], p_message, static_cast<size_t>(p_messageLength));
+                for (uint64_t i = 0; i < count; ++i)
+                {
+                    const Request& request = p_requests[first + i];
+                    uint8_t* iPadKey = pads + i * 2 * SHA256::BLOCK_SIZE;
+                    uint8_t* oPadKey = iPadKey + SHA256::BLOCK_SIZE;
 
-            auto shaIPad = SHA256().Hash(&sha[0], SHA256::BLOCK_SIZE + p_messageLength);
-            uint8_t hmac[96];
-            memcpy(hmac, oPadKey, SHA256::BLOCK_SIZE);
-            memcpy(hmac + SHA256::BLOCK_SIZE, shaIPad.data(), SHA256::OUTPUT_SIZE);
-            return SHA256().Hash(reinterpret_cast<unsigned char*>(hmac), SHA256::BLOCK_SIZE + SHA256::OUTPUT_SIZE);
+                    LoadKey(request.key, request.keyLength, key);
+                    for (uint32_t j = 0; j < SHA256::BLOCK_SIZE; ++j)
+                    {
+                        iPadKey[j] = key[j] ^ 0x36;
+                        oPadKey[j] = key[j] ^ 0x5c;
+                    }
+                    lanes[i] = SHA256::Lane{iPadKey, request.message, request.messageLength, inner + i * SHA256::OUTPUT_SIZE};
+                }
+                SHA256::HashLanes(lanes, count);
+
+                for (uint64_t i = 0; i < count; ++i)
+                {
+                    const uint8_t* oPadKey = pads + i * 2 * SHA256::BLOCK_SIZE + SHA256::BLOCK_SIZE;
+                    lanes[i] = SHA256::Lane{oPadKey, inner + i * SHA256::OUTPUT_SIZE, SHA256::OUTPUT_SIZE, p_requests[first + i].mac};
+                }
+                SHA256::HashLanes(lanes, count);
+            }
         }
     }
 }
@@ -1,7 +1,16 @@
 #include "NGCrypto/Hash/SHA256.h"
-#include <vector>
+#include "NGCrypto/Utils/CpuFeatures.h"
+#include "NGCrypto/Utils/SecureArena.h"
+#include "../Utils/InstrumentationProbe.h"
+#include <cstring>
 
+#if defined(_MSC_VER)
+#include <stdlib.h>
 #pragma intrinsic(_byteswap_ulong)
+#define BYTE_SWAP_32(x) _byteswap_ulong(x)
+#else
+#define BYTE_SWAP_32(x) __builtin_bswap32(x)
+#endif
 
 namespace Cryptography
 {
@@ -11,6 +20,13 @@ namespace Cryptography
         #define ROTR(x,n) ((x >> n) | (x << ((sizeof(WORD) * 8) - n)))
         #define ADD_MOD(x,n) ((x + n) % 0x100000000)
 
+        // Chosen once, the first time a hash is computed
+        static bool UseSHANI()
+        {
+            static const bool shani = Utils::CpuFeatures::Get().sha && Utils::CpuFeatures::Get().sse41;
+            return shani;
+        }
+
         const uint32_t SHA256::SHA256_H[8] = {
             0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
             0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
@@ -31,76 +47,257 @@ namespace Cryptography
             memcpy(m_h, SHA256_H, 32);
         }
 
+        SHA256::~SHA256()
+        {
+            Utils::SecureZero(m_h, sizeof(m_h));
+            Utils::SecureZero(m_buffer, sizeof(m_buffer));
+        }
+
+        void SHA256::Reset()
+        {
+            memcpy(m_h, SHA256_H, 32);
+            m_length = 0;
+        }
+
+        void SHA256::Update(const unsigned char* p_data, uint64_t p_size)
+        {
+            uint32_t buffered = static_cast<uint32_t>(m_length % BLOCK_SIZE);
+            m_length += p_size;
+
+            if (buffered)
+            {
+                const uint32_t take = (p_size < BLOCK_SIZE - buffered) ? static_cast<uint32_t>(p_size) : BLOCK_SIZE - buffered;
+                memcpy(m_buffer + buffered, p_data, take);
+                p_data += take;
+                p_size -= take;
+                buffered += take;
+                if (buffered < BLOCK_SIZE)
+                    return;
+                CompressBlocks(m_buffer, 1);
+            }
+
+            const uint64_t blockCount = p_size / BLOCK_SIZE;
+            CompressBlocks(p_data, blockCount);
+            memcpy(m_buffer, p_data + blockCount * BLOCK_SIZE, static_cast<size_t>(p_size % BLOCK_SIZE));
+        }
+
+        std::array<uint8_t, SHA256::OUTPUT_SIZE> SHA256::Final()
+        {
+            const uint64_t bitLength = m_length * 8;
+            uint32_t buffered = static_cast<uint32_t>(m_length % BLOCK_SIZE);
+
+            m_buffer[buffered++] = 0x80;
+            if (buffered > BLOCK_SIZE - 8)
+            {
+                memset(m_buffer + buffered, 0, BLOCK_SIZE - buffered);
+                CompressBlocks(m_buffer, 1);
+                buffered = 0;
+            }
+            memset(m_buffer + buffered, 0, BLOCK_SIZE - 8 - buffered);
+            for (uint32_t i = 0; i < 8; ++i)
+                m_buffer[BLOCK_SIZE - 1 - i] = static_cast<uint8_t>(bitLength >> (i * 8));
+            CompressBlocks(m_buffer, 1);
+
+            std::array<uint8_t, OUTPUT_SIZE> digest;
+            for (uint32_t i = 0; i < 8; ++i)
+            {
+                const uint32_t word = BYTE_SWAP_32(m_h[i]);
+                memcpy(&digest[i * 4], &word, 4);
+            }
+
+            Reset();
+            return digest;
+        }
 
         std::array<uint8_t, SHA256::OUTPUT_SIZE> SHA256::Hash(const unsigned char* p_message, const uint64_t& p_size)
         {
-            uint32_t k = (BLOCK_SIZE * 8) - (((p_size * 8) + 65) % (BLOCK_SIZE * 8));
-            const uint32_t blockCount = static_cast<uint32_t>((p_size * 8) + 65 + k) / (BLOCK_SIZE * 8);
-            int64_t bytesLeft = p_size;
+            NG_CRYPTO_PROBE(Utils::Operation::SHA256, p_size);
 
-            std::vector<SHA256_Block> blocks;
-            blocks.resize(blockCount);
+            Reset();
+            Update(p_message, p_size);
+            return Final();
+        }
+
+        void SHA256::CompressBlocks(const uint8_t* p_data, uint64_t p_blockCount)
+        {
+            // Words are loaded into a fixed stack batch, big enough for the SHA-NI kernel to stay busy
+            const uint32_t BATCH = 16;
+            SHA256_Block blocks[BATCH];
+            const uint64_t used = (p_blockCount < BATCH) ? p_blockCount : BATCH;
 
-            for (uint32_t i = 0; i < blockCount; ++i)
+            while (p_blockCount)
             {
-                if(bytesLeft >= 0)
+                const uint32_t count = (p_blockCount < BATCH) ? static_cast<uint32_t>(p_blockCount) : BATCH;
+                memcpy(blocks, p_data, static_cast<size_t>(count) * BLOCK_SIZE);
+                for (uint32_t i = 0; i < count; ++i)
+                {
+                    for (uint32_t j = 0; j < WORDS_PER_BLOCK; ++j)
+                        blocks[i].words[j] = BYTE_SWAP_32(blocks[i].words[j]);
+                }
+
+                if (UseSHANI())
+                {
+                    CompressBlocksNI(m_h, blocks, count);
+                }
+                else
                 {
-                    memcpy(blocks[i].words, p_message, (bytesLeft < BLOCK_SIZE) ? static_cast<size_t>(bytesLeft) : BLOCK_SIZE);
-                    if (bytesLeft < BLOCK_SIZE)
+                    for (uint32_t i = 0; i < count; ++i)
+                        CompressBlock(blocks[i]);
+                }
+
+                p_data += static_cast<size_t>(count) * BLOCK_SIZE;
+                p_blockCount -= count;
+            }
+
+            Utils::SecureZero(blocks, used * sizeof(SHA256_Block));
+        }
+
+        void SHA256::HashBatch(const HashRequest* p_requests, uint64_t p_count)
+        {
+            uint64_t bytes = 0;
+            for (uint64_t i = 0; i < p_count; ++i)
+                bytes += p_requests[i].size;
+            NG_CRYPTO_PROBE(Utils::Operation::SHA256, bytes);
+            (void)bytes;
+
+            const uint32_t CHUNK = 16;
+            Lane lanes[CHUNK];
+            for (uint64_t first = 0; first < p_count; first += CHUNK)
+            {
+                const uint64_t count = (p_count - first < CHUNK) ? p_count - first : CHUNK;
+                for (uint64_t i = 0; i < count; ++i)
+                    lanes[i] = Lane{nullptr, p_requests[first + i].message, p_requests[first + i].size, p_requests[first + i].digest};
+                HashLanes(lanes, count);
+            }
+        }
+
+        uint64_t SHA256::GetBlockCount(const Lane& p_lane)
+        {
+            const uint64_t length = (p_lane.prefix ? BLOCK_SIZE : 0) + p_lane.size;
+            return (length + 9 + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        }
+
+        void SHA256::LoadBlock(const Lane& p_lane, uint64_t p_index, SHA256_Block& p_block)
+        {
+            const uint64_t prefixSize = p_lane.prefix ? BLOCK_SIZE : 0;
+            if (p_lane.prefix && p_index == 0)
+            {
+                memcpy(p_block.words, p_lane.prefix, BLOCK_SIZE);
+            }
+            else
+            {
+                const uint64_t offset = p_index * BLOCK_SIZE - prefixSize;
+                if (offset + BLOCK_SIZE <= p_lane.size)
+                {
+                    memcpy(p_block.words, p_lane.data + offset, BLOCK_SIZE);
+                }
+                else
+                {
+                    // Rest of the message, the 0x80 marker, zeros, and the bit length in the last block
+                    uint8_t* bytes = reinterpret_cast<uint8_t*>(p_block.words);
+                    const uint64_t remaining = offset < p_lane.size ? p_lane.size - offset : 0;
+                    if (remaining)
+                        memcpy(bytes, p_lane.data + offset, static_cast<size_t>(remaining));
+                    memset(bytes + remaining, 0, static_cast<size_t>(BLOCK_SIZE - remaining));
+                    if (offset <= p_lane.size)
+                        bytes[remaining] = 0x80;
+
+                    if (p_index == GetBlockCount(p_lane) - 1)
                     {
-                        memset(reinterpret_cast<unsigned char*>(blocks[i].words) + bytesLeft, 0, static_cast<size_t>(BLOCK_SIZE - bytesLeft));
-                        *(reinterpret_cast<unsigned char*>(blocks[i].words) + bytesLeft) = 0x80;
-                        bytesLeft = 0;
+                        const uint64_t bitLength = (prefixSize + p_lane.size) * 8;
+                        for (uint32_t i = 0; i < 8; ++i)
+                            bytes[BLOCK_SIZE - 1 - i] = static_cast<uint8_t>(bitLength >> (i * 8));
                     }
-                    bytesLeft -= BLOCK_SIZE;
                 }
+            }
+
+            for (uint32_t i = 0; i < WORDS_PER_BLOCK; ++i)
+                p_block.words[i] = BYTE_SWAP_32(p_block.words[i]);
+        }
+
+        void SHA256::HashLanes(const Lane* p_lanes, uint64_t p_count)
+        {
+            if (!UseSHANI())
+            {
+                SHA256 sha;
+                for (uint64_t i = 0; i < p_count; ++i)
+                {
+                    if (p_lanes[i].prefix)
+                        sha.Update(p_lanes[i].prefix, BLOCK_SIZE);
+                    sha.Update(p_lanes[i].data, p_lanes[i].size);
+                    const auto digest = sha.Final();
+                    memcpy(p_lanes[i].digest, digest.data(), OUTPUT_SIZE);
+                }
+                return;
+            }
+
+            const uint32_t CHUNK = 8;
+            SHA256_Block blocks0[CHUNK];
+            SHA256_Block blocks1[CHUNK];
+            uint32_t state0[8];
+            uint32_t state1[8];
+
+            // Compresses blocks [p_begin, p_end) of a single lane
+            auto compressRest = [&](const Lane& p_lane, uint32_t p_state[8], uint64_t p_begin, uint64_t p_end)
+            {
+                for (uint64_t block = p_begin; block < p_end; block += CHUNK)
+                {
+                    const uint64_t count = (p_end - block < CHUNK) ? p_end - block : CHUNK;
+                    for (uint64_t i = 0; i < count; ++i)
+                        LoadBlock(p_lane, block + i, blocks0[i]);
+                    CompressBlocksNI(p_state, blocks0, count);
+                }
+            };
 
-                if(i == blockCount -1)
-                    blocks[i].words[WORDS_PER_BLOCK - 1] = _byteswap_ulong(static_cast<unsigned long>(p_size * 8));
-                p_message += BLOCK_SIZE;
-
-                blocks[i].words[0]  = _byteswap_ulong(blocks[i].words[0]);
-                blocks[i].words[1]  = _byteswap_ulong(blocks[i].words[1]);
-                blocks[i].words[2]  = _byteswap_ulong(blocks[i].words[2]);
-                blocks[i].words[3]  = _byteswap_ulong(blocks[i].words[3]);
-                blocks[i].words[4]  = _byteswap_ulong(blocks[i].words[4]);
-                blocks[i].words[5]  = _byteswap_ulong(blocks[i].words[5]);
-                blocks[i].words[6]  = _byteswap_ulong(blocks[i].words[6]);
-                blocks[i].words[7]  = _byteswap_ulong(blocks[i].words[7]);
-                blocks[i].words[8]  = _byteswap_ulong(blocks[i].words[8]);
-                blocks[i].words[9]  = _byteswap_ulong(blocks[i].words[9]);
-                blocks[i].words[10] = _byteswap_ulong(blocks[i].words[10]);
-                blocks[i].words[11] = _byteswap_ulong(blocks[i].words[11]);
-                blocks[i].words[12] = _byteswap_ulong(blocks[i].words[12]);
-                blocks[i].words[13] = _byteswap_ulong(blocks[i].words[13]);
-                blocks[i].words[14] = _byteswap_ulong(blocks[i].words[14]);
-                blocks[i].words[15] = _byteswap_ulong(blocks[i].words[15]);
+            auto storeDigest = [](const uint32_t p_state[8], uint8_t* p_digest)
+            {
+                for (uint32_t i = 0; i < 8; ++i)
+                {
+                    const uint32_t word = BYTE_SWAP_32(p_state[i]);
+                    memcpy(p_digest + i * 4, &word, 4);
+                }
+            };
+
+            uint64_t lane = 0;
+            for (; lane + 1 < p_count; lane += 2)
+            {
+                const Lane& lane0 = p_lanes[lane];
+                const Lane& lane1 = p_lanes[lane + 1];
+                const uint64_t count0 = GetBlockCount(lane0);
+                const uint64_t count1 = GetBlockCount(lane1);
+                const uint64_t common = (count0 < count1) ? count0 : count1;
+
+                memcpy(state0, SHA256_H, 32);
+                memcpy(state1, SHA256_H, 32);
+                for (uint64_t block = 0; block < common; block += CHUNK)
+                {
+                    const uint64_t count = (common - block < CHUNK) ? common - block : CHUNK;
+                    for (uint64_t i = 0; i < count; ++i)
+                    {
+                        LoadBlock(lane0, block + i, blocks0[i]);
+                        LoadBlock(lane1, block + i, blocks1[i]);
+                    }
+                    CompressBlocksNIx2(state0, state1, blocks0, blocks1, count);
+                }
+                compressRest(lane0, state0, common, count0);
+                compressRest(lane1, state1, common, count1);
 
+                storeDigest(state0, lane0.digest);
+                storeDigest(state1, lane1.digest);
             }
 
-            for (SHA256_Block& block : blocks)
+            if (lane < p_count)
             {
-                CompressBlock(block);
+                memcpy(state0, SHA256_H, 32);
+                compressRest(p_lanes[lane], state0, 0, GetBlockCount(p_lanes[lane]));
+                storeDigest(state0, p_lanes[lane].digest);
             }
 
-            m_h[0]  = _byteswap_ulong(m_h[0]);
-            m_h[1]  = _byteswap_ulong(m_h[1]);
-            m_h[2]  = _byteswap_ulong(m_h[2]);
-            m_h[3]  = _byteswap_ulong(m_h[3]);
-            m_h[4]  = _byteswap_ulong(m_h[4]);
-            m_h[5]  = _byteswap_ulong(m_h[5]);
-            m_h[6]  = _byteswap_ulong(m_h[6]);
-            m_h[7]  = _byteswap_ulong(m_h[7]);
-
-            uint8_t* charH = reinterpret_cast<uint8_t*>(m_h);
-            return std::array<uint8_t,OUTPUT_SIZE> { charH[0],  charH[1],  charH[2],  charH[3],
-                                                     charH[4],  charH[5],  charH[6],  charH[7],
-                                                     charH[8],  charH[9],  charH[10], charH[11],
-                                                     charH[12], charH[13], charH[14], charH[15],
-                                                     charH[16], charH[17], charH[18], charH[19],
-                                                     charH[20], charH[21], charH[22], charH[23],
-                                                     charH[24], charH[25], charH[26], charH[27],
-                                                     charH[28], charH[29], charH[30], charH[31] };
+            // Lanes may carry key pads
+            Utils::SecureZero(blocks0, sizeof(blocks0));
+            Utils::SecureZero(blocks1, sizeof(blocks1));
+            Utils::SecureZero(state0, sizeof(state0));
+            Utils::SecureZero(state1, sizeof(state1));
         }
 
         void SHA256::CompressBlock(SHA256_Block& p_block)
@@ -0,0 +1,129 @@
+#include "NGCrypto/Hash/SHA256.h"
+#include <immintrin.h>
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sha,sse4.1"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sha,sse4.1")
+#endif
+
+namespace Cryptography
+{
+    namespace Hash
+    {
+        namespace
+        {
+            // One message stream, sha256rnds2 keeps the state as ABEF and CDGH
+            struct Stream
+            {
+                __m128i abef;
+                __m128i cdgh;
+                __m128i abefSave;
+                __m128i cdghSave;
+                __m128i messages[4];
+            };
+
+            inline void LoadState(Stream& p_stream, const uint32_t p_state[8])
+            {
+                const __m128i temp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p_state)), 0xB1);
+                const __m128i cdgh = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p_state + 4)), 0x1B);
+                p_stream.abef = _mm_alignr_epi8(temp, cdgh, 8);
+                p_stream.cdgh = _mm_blend_epi16(cdgh, temp, 0xF0);
+            }
+
+            inline void StoreState(const Stream& p_stream, uint32_t p_state[8])
+            {
+                const __m128i temp = _mm_shuffle_epi32(p_stream.abef, 0x1B);
+                const __m128i cdgh = _mm_shuffle_epi32(p_stream.cdgh, 0xB1);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(p_state), _mm_blend_epi16(temp, cdgh, 0xF0));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(p_state + 4), _mm_alignr_epi8(cdgh, temp, 8));
+            }
+
+            // Four rounds of p_group with a rolling four-vector schedule, words are already in host order
+            inline void RoundGroup(Stream& p_stream, const uint32_t* p_words, const uint32_t* p_constants, int p_group)
+            {
+                __m128i* messages = p_stream.messages;
+                if (p_group < 4)
+                    messages[p_group] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_words + 4 * p_group));
+
+                const __m128i current = messages[p_group % 4];
+                __m128i message = _mm_add_epi32(current, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_constants + 4 * p_group)));
+                p_stream.cdgh = _mm_sha256rnds2_epu32(p_stream.cdgh, p_stream.abef, message);
+
+                if (p_group >= 3 && p_group <= 14)
+                {
+                    __m128i& next = messages[(p_group + 1) % 4];
+                    next = _mm_add_epi32(next, _mm_alignr_epi8(current, messages[(p_group + 3) % 4], 4));
+                    next = _mm_sha256msg2_epu32(next, current);
+                }
+
+                message = _mm_shuffle_epi32(message, 0x0E);
+                p_stream.abef = _mm_sha256rnds2_epu32(p_stream.abef, p_stream.cdgh, message);
+
+                if (p_group >= 1 && p_group <= 12)
+                    messages[(p_group + 3) % 4] = _mm_sha256msg1_epu32(messages[(p_group + 3) % 4], current);
+            }
+
+            inline void BeginBlock(Stream& p_stream)
+            {
+                p_stream.abefSave = p_stream.abef;
+                p_stream.cdghSave = p_stream.cdgh;
+            }
+
+            inline void EndBlock(Stream& p_stream)
+            {
+                p_stream.abef = _mm_add_epi32(p_stream.abef, p_stream.abefSave);
+                p_stream.cdgh = _mm_add_epi32(p_stream.cdgh, p_stream.cdghSave);
+            }
+        }
+
+        void SHA256::CompressBlocksNI(uint32_t p_state[8], const SHA256_Block* p_blocks, uint64_t p_blockCount)
+        {
+            Stream stream;
+            LoadState(stream, p_state);
+
+            for (uint64_t block = 0; block < p_blockCount; ++block)
+            {
+                BeginBlock(stream);
+                for (int group = 0; group < 16; ++group)
+                    RoundGroup(stream, p_blocks[block].words, SHA256_K, group);
+                EndBlock(stream);
+            }
+
+            StoreState(stream, p_state);
+        }
+
+        // sha256rnds2 waits on its previous result, a second independent stream fills the gaps
+        void SHA256::CompressBlocksNIx2(uint32_t p_state0[8], uint32_t p_state1[8],
+                                        const SHA256_Block* p_blocks0, const SHA256_Block* p_blocks1, uint64_t p_blockCount)
+        {
+            Stream stream0;
+            Stream stream1;
+            LoadState(stream0, p_state0);
+            LoadState(stream1, p_state1);
+
+            for (uint64_t block = 0; block < p_blockCount; ++block)
+            {
+                BeginBlock(stream0);
+                BeginBlock(stream1);
+                for (int group = 0; group < 16; ++group)
+                {
+                    RoundGroup(stream0, p_blocks0[block].words, SHA256_K, group);
+                    RoundGroup(stream1, p_blocks1[block].words, SHA256_K, group);
+                }
+                EndBlock(stream0);
+                EndBlock(stream1);
+            }
+
+            StoreState(stream0, p_state0);
+            StoreState(stream1, p_state1);
+        }
+    }
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
@@ -1,65 +1,211 @@
 #include "NGCrypto/KeyExchange/DiffieHellman.h"
+#include "NGCrypto/Random/CtrDrbg.h"
+#include "../Utils/InstrumentationProbe.h"
+#include "MontgomeryLanes.h"
+#include <stdexcept>
+#include <vector>
 
 namespace Cryptography
 {
     namespace KeyExchange
     {
-    #if PUBLIC_KEY_SIZE == 2048
-        const uint32_t DiffieHellman::PRIME_ARRAY[64] = {
-            0xFFFFFFFF, 0xFFFFFFFF, 0xC90FDAA2, 0x2168C234,
-            0xC4C6628B, 0x80DC1CD1, 0x29024E08, 0x8A67CC74,
-            0x020BBEA6, 0x3B139B22, 0x514A0879, 0x8E3404DD,
-            0xEF9519B3, 0xCD3A431B, 0x302B0A6D, 0xF25F1437,
-            0x4FE1356D, 0x6D51C245, 0xE485B576, 0x625E7EC6,
-            0xF44C42E9, 0xA637ED6B, 0x0BFF5CB6, 0xF406B7ED,
-            0xEE386BFB, 0x5A899FA5, 0xAE9F2411, 0x7C4B1FE6,
-            0x49286651, 0xECE45B3D, 0xC2007CB8, 0xA163BF05,
-            0x98DA4836, 0x1C55D39A, 0x69163FA8, 0xFD24CF5F,
-            0x83655D23, 0xDCA3AD96, 0x1C62F356, 0x208552BB,
-            0x9ED52907, 0x7096966D, 0x670C354E, 0x4ABC9804,
-            0xF1746C08, 0xCA18217C, 0x32905E46, 0x2E36CE3B,
-            0xE39E772C, 0x180E8603, 0x9B2783A2, 0xEC07A28F,
-            0xB5C55DF0, 0x6F4C52C9, 0xDE2BCBF6, 0x95581718,
-            0x3995497C, 0xEA956AE5, 0x15D22618, 0x98FA0510,
-            0x15728E5A, 0x8AACAA68, 0xFFFFFFFF, 0xFFFFFFFF};
-
-        const NGMP<2048> DiffieHellman::PRIME(PRIME_ARRAY, 64);
-    #elif  PUBLIC_KEY_SIZE == 1536
-        const uint32_t DiffieHellman::PRIME_ARRAY[48] = {
-            0xFFFFFFFF, 0xFFFFFFFF, 0xC90FDAA2, 0x2168C234, 0xC4C6628B, 0x80DC1CD1,
-            0x29024E08, 0x8A67CC74, 0x020BBEA6, 0x3B139B22, 0x514A0879, 0x8E3404DD,
-            0xEF9519B3, 0xCD3A431B, 0x302B0A6D, 0xF25F1437, 0x4FE1356D, 0x6D51C245,
-            0xE485B576, 0x625E7EC6, 0xF44C42E9, 0xA637ED6B, 0x0BFF5CB6, 0xF406B7ED,
-            0xEE386BFB, 0x5A899FA5, 0xAE9F2411, 0x7C4B1FE6, 0x49286651, 0xECE45B3D,
-            0xC2007CB8, 0xA163BF05, 0x98DA4836, 0x1C55D39A, 0x69163FA8, 0xFD24CF5F,
-            0x83655D23, 0xDCA3AD96, 0x1C62F356, 0x208552BB, 0x9ED52907, 0x7096966D,
-            0x670C354E, 0x4ABC9804, 0xF1746C08, 0xCA237327, 0xFFFFFFFF, 0xFFFFFFFF};
-        const NGMP<1536> DiffieHellman::PRIME(PRIME_ARRAY, 48);
-    #elif  PUBLIC_KEY_SIZE == 1024
-        const uint32_t DiffieHellman::PRIME_ARRAY[32] = {
-            0xFFFFFFFF, 0xFFFFFFFF, 0xC90FDAA2, 0x2168C234,
-            0xC4C6628B, 0x80DC1CD1, 0x29024E08, 0x8A67CC74, 
-            0x020BBEA6, 0x3B139B22, 0x514A0879, 0x8E3404DD,
-            0xEF9519B3, 0xCD3A431B, 0x302B0A6D, 0xF25F1437, 
-            0x4FE1356D, 0x6D51C245, 0xE485B576, 0x625E7EC6,
-            0xF44C42E9, 0xA637ED6B, 0x0BFF5CB6, 0xF406B7ED,
-            0xEE386BFB, 0x5A899FA5, 0xAE9F2411, 0x7C4B1FE6,
-            0x49286651, 0xECE65381, 0xFFFFFFFF, 0xFFFFFFFF};
-        const NGMP<1024> DiffieHellman::PRIME(PRIME_ARRAY, 32);
-    #endif
-
-        void DiffieHellman::GenerateKeyPair(PrivateKey& p_privateKey, PublicKey& p_publicKey)
+        namespace
         {
-            p_privateKey = NGMP<PRIVATE_KEY_SIZE>::Random();
+            /**
+             * p_results[i] = p_bases[i * p_baseStride] ^ p_exponents[i] mod prime through the vector kernels,
+             * for the p_count items listed in p_items, or the first p_count items when p_items is null.
+             * A stride of 0 uses p_bases[0] for every item. One lane group runs per pool task.
+             */
+            void PowModLanes(const MontgomeryLanes& p_lanes, const DiffieHellmanGroup& p_group,
+                             const PublicKey* p_bases, uint64_t p_baseStride, const PrivateKey* p_exponents,
+                             PublicKey* p_results, const uint64_t* p_items, uint64_t p_count, Utils::ThreadPool& p_pool)
+            {
+                const uint32_t laneCount = p_lanes.GetLaneCount();
+                const uint32_t limbCount = (p_group.GetBitCount() + 63) / 64;
+                const uint64_t groupCount = (p_count + laneCount - 1) / laneCount;
+                p_pool.ParallelFor(groupCount, 1, [&](uint64_t p_begin, uint64_t p_end)
+                {
+                    for (uint64_t group = p_begin; group < p_end; ++group)
+                    {
+                        const uint64_t first = group * laneCount;
+                        const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(laneCount, p_count - first));
 
-            // Public Key = GENERATOR ^ PrivateKey mod PRIME
-            p_publicKey = NGMP<OVERFLOW_SAFE_SIZE>::PowMod(GENERATOR, p_privateKey, PRIME);
+                        const uint64_t* bases[MontgomeryLanes::MAX_LANES];
+                        const uint64_t* exponents[MontgomeryLanes::MAX_LANES];
+                        uint64_t*       results[MontgomeryLanes::MAX_LANES];
+                        for (uint32_t lane = 0; lane < count; ++lane)
+                        {
+                            const uint64_t i = p_items ? p_items[first + lane] : first + lane;
+                            // Limbs above the group size stay zero
+                            p_results[i] = PublicKey();
+                            bases[lane] = p_bases[i * p_baseStride].Get64BitArray();
+                            exponents[lane] = p_exponents[i].Get64BitArray();
+                            results[lane] = p_results[i].Get64BitArray();
+                        }
+
+                        p_lanes.PowMod(bases, exponents, PRIVATE_KEY_SIZE, results, limbCount, count);
+                    }
+                });
+            }
+        }
+
+        void DiffieHellman::GenerateKeyPair(PrivateKey& p_privateKey, PublicKey& p_publicKey, const DiffieHellmanGroup& p_group)
+        {
+            NG_CRYPTO_PROBE(Utils::Operation::DHKeyPair, p_group.GetByteCount());
+
+            p_privateKey = NGMP<PRIVATE_KEY_SIZE>::Random(Random::CtrDrbg::GetThreadInstance());
+
+            // Public Key = Generator ^ PrivateKey mod Prime
+            p_publicKey = p_group.PowGenerator(p_privateKey);
+        }
+
+        void DiffieHellman::GenerateKeyPairs(PrivateKey* p_privateKeys, PublicKey* p_publicKeys, uint64_t p_count,
+                                             const DiffieHellmanGroup& p_group, Utils::ThreadPool& p_pool)
+        {
+            Random::CtrDrbg& drbg = Random::CtrDrbg::GetThreadInstance();
+            for (uint64_t i = 0; i < p_count; ++i)
+                p_privateKeys[i] = NGMP<PRIVATE_KEY_SIZE>::Random(drbg);
+
+            const MontgomeryLanes* lanes = p_group.GetLanes();
+            if (!lanes || lanes->GetLaneCount() == 0)
+            {
+                p_pool.ParallelFor(p_count, 1, [=, &p_group](uint64_t p_begin, uint64_t p_end)
+                {
+                    for (uint64_t i = p_begin; i < p_end; ++i)
+                        p_publicKeys[i] = p_group.PowGenerator(p_privateKeys[i]);
+                });
+                return;
+            }
+
+            // The vector kernels beat the fixed-base table. The generator is every lane's base and needs no validation
+            const PublicKey generator(p_group.GetGenerator());
+            PowModLanes(*lanes, p_group, &generator, 0, p_privateKeys, p_publicKeys, nullptr, p_count, p_pool);
+        }
+
+        SharedKey DiffieHellman::GenerateSharedKey(const PublicKey& p_otherPublic, const PrivateKey& p_privateKey,
+                                                   const DiffieHellmanGroup& p_group)
+        {
+            NG_CRYPTO_PROBE(Utils::Operation::DHSharedKey, p_group.GetByteCount());
+
+            if (!ValidatePublicKey(p_otherPublic, p_group))
+                throw std::invalid_argument("Public key is not in the prime order subgroup");
+
+            // Shared Key = PublicKey ^ PrivateKey mod Prime, over every private key bit so timing is independent of the key
+            return PublicKey::PowMod(p_otherPublic, p_privateKey, PRIVATE_KEY_SIZE, p_group.GetMontgomeryContext());
+        }
+
+        ExponentiationTask DiffieHellman::StartKeyPair(PrivateKey& p_privateKey, const DiffieHellmanGroup& p_group)
+        {
+            p_privateKey = NGMP<PRIVATE_KEY_SIZE>::Random(Random::CtrDrbg::GetThreadInstance());
+            return ExponentiationTask(PublicKey(p_group.GetGenerator()), p_privateKey, p_group.GetMontgomeryContext());
+        }
+
+        ExponentiationTask DiffieHellman::StartSharedKey(const PublicKey& p_otherPublic, const PrivateKey& p_privateKey,
+                                                         const DiffieHellmanGroup& p_group)
+        {
+            if (!ValidatePublicKey(p_otherPublic, p_group))
+                throw std::invalid_argument("Public key is not in the prime order subgroup");
+
+            return ExponentiationTask(p_otherPublic, p_privateKey, p_group.GetMontgomeryContext());
         }
 
-        SharedKey DiffieHellman::GenerateSharedKey(const PublicKey& p_otherPublic, const PrivateKey& p_privateKey)
+        void DiffieHellman::EncodeKey(const PublicKey& p_key, uint8_t* p_out, const DiffieHellmanGroup& p_group)
         {
-            // Shared Key = PublicKey ^ PrivateKey mod PRIME
-            return NGMP<OVERFLOW_SAFE_SIZE>::PowMod(p_otherPublic, p_privateKey, PRIME);
+            p_key.ToBigEndian(p_out, p_group.GetByteCount());
+        }
+
+        bool DiffieHellman::DecodePublicKey(const uint8_t* p_in, PublicKey& p_publicKey, const DiffieHellmanGroup& p_group)
+        {
+            // 1 < y < prime - 1 on the wire bytes
+            const NGMPView<MAX_PUBLIC_KEY_SIZE> view(p_in, p_group.GetByteCount());
+            if (view.Compare(PublicKey(1)) <= 0 || view.Compare(p_group.GetPrime() - 1) >= 0)
+                return false;
+
+            const PublicKey publicKey = view.ToNGMP();
+            if (!ValidatePublicKey(publicKey, p_group))
+                return false;
+
+            p_publicKey = publicKey;
+            return true;
+        }
+
+        bool DiffieHellman::IsPublicKeyInRange(const PublicKey& p_publicKey, const DiffieHellmanGroup& p_group)
+        {
+            if (p_publicKey.Compare(PublicKey(1)) <= 0)
+                return false;
+
+            return p_publicKey.Compare(p_group.GetPrime() - 1) < 0;
+        }
+
+        bool DiffieHellman::ValidatePublicKey(const PublicKey& p_publicKey, const DiffieHellmanGroup& p_group, ValidationMode p_mode)
+        {
+            if (!IsPublicKeyInRange(p_publicKey, p_group))
+                return false;
+
+            if (p_mode == ValidationMode::Full)
+                return PublicKey::PowMod(p_publicKey, p_group.GetSubgroupOrder(), p_group.GetContext()) == 1;
+
+            return p_publicKey.Jacobi(p_group.GetPrime()) == 1;
+        }
+
+        void DiffieHellman::GenerateSharedKeys(const PublicKey* p_otherPublics, const PrivateKey* p_privateKeys,
+                                               SharedKey* p_sharedKeys, KeyStatus* p_status, uint64_t p_count,
+                                               const DiffieHellmanGroup& p_group, Utils::ThreadPool& p_pool)
+        {
+            const MontgomeryLanes* lanes = p_group.GetLanes();
+            const uint32_t laneCount = lanes ? lanes->GetLaneCount() : 0;
+
+            if (laneCount == 0)
+            {
+                // One exponentiation per chunk keeps stealing fine grained, task overhead is negligible next to it
+                p_pool.ParallelFor(p_count, 1, [=, &p_group](uint64_t p_begin, uint64_t p_end)
+                {
+                    for (uint64_t i = p_begin; i < p_end; ++i)
+                    {
+                        if (!ValidatePublicKey(p_otherPublics[i], p_group))
+                        {
+                            p_sharedKeys[i] = SharedKey();
+                            p_status[i] = KeyStatus::InvalidPublicKey;
+                            continue;
+                        }
+
+                        try
+                        {
+                            p_sharedKeys[i] = SharedKey::PowMod(p_otherPublics[i], p_privateKeys[i], PRIVATE_KEY_SIZE,
+                                                                p_group.GetMontgomeryContext());
+                            p_status[i] = KeyStatus::Success;
+                        }
+                        catch (...)
+                        {
+                            p_sharedKeys[i] = SharedKey();
+                            p_status[i] = KeyStatus::Failure;
+                        }
+                    }
+                });
+                return;
+            }
+
+            // Vector path: validation is as costly as a vector exponentiation, so it runs on the pool too
+            p_pool.ParallelFor(p_count, 8, [=, &p_group](uint64_t p_begin, uint64_t p_end)
+            {
+                for (uint64_t i = p_begin; i < p_end; ++i)
+                    p_status[i] = ValidatePublicKey(p_otherPublics[i], p_group) ? KeyStatus::Success : KeyStatus::InvalidPublicKey;
+            });
+
+            // Valid items are packed so every lane group is full except the last
+            std::vector<uint64_t> valid;
+            valid.reserve(p_count);
+            for (uint64_t i = 0; i < p_count; ++i)
+            {
+                if (p_status[i] == KeyStatus::Success)
+                {
+                    valid.push_back(i);
+                    continue;
+                }
+                p_sharedKeys[i] = SharedKey();
+            }
+
+            PowModLanes(*lanes, p_group, p_otherPublics, 1, p_privateKeys, p_sharedKeys, valid.data(), valid.size(), p_pool);
         }
     }
-}
\ No newline at end of file
+}
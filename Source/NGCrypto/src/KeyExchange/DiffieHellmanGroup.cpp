@@ -0,0 +1,240 @@
+#include "NGCrypto/KeyExchange/DiffieHellmanGroup.h"
+#include "NGCrypto/Random/PrimeGenerator.h"
+#include "MontgomeryLanes.h"
+#include <stdexcept>
+
+namespace Cryptography
+{
+    namespace KeyExchange
+    {
+        // Words most significant first
+        static constexpr uint32_t MODP_1024[32] = {
+            0xFFFFFFFF, 0xFFFFFFFF, 0xC90FDAA2, 0x2168C234,
+            0xC4C6628B, 0x80DC1CD1, 0x29024E08, 0x8A67CC74, 
+            0x020BBEA6, 0x3B139B22, 0x514A0879, 0x8E3404DD,
+            0xEF9519B3, 0xCD3A431B, 0x302B0A6D, 0xF25F1437, 
+            0x4FE1356D, 0x6D51C245, 0xE485B576, 0x625E7EC6,
+            0xF44C42E9, 0xA637ED6B, 0x0BFF5CB6, 0xF406B7ED,
+            0xEE386BFB, 0x5A899FA5, 0xAE9F2411, 0x7C4B1FE6,
+            0x49286651, 0xECE65381, 0xFFFFFFFF, 0xFFFFFFFF};
+
+        static constexpr uint32_t MODP_1536[48] = {
+            0xFFFFFFFF, 0xFFFFFFFF, 0xC90FDAA2, 0x2168C234, 0xC4C6628B, 0x80DC1CD1,
+            0x29024E08, 0x8A67CC74, 0x020BBEA6, 0x3B139B22, 0x514A0879, 0x8E3404DD,
+            0xEF9519B3, 0xCD3A431B, 0x302B0A6D, 0xF25F1437, 0x4FE1356D, 0x6D51C245,
+            0xE485B576, 0x625E7EC6, 0xF44C42E9, 0xA637ED6B, 0x0BFF5CB6, 0xF406B7ED,
+            0xEE386BFB, 0x5A899FA5, 0xAE9F2411, 0x7C4B1FE6, 0x49286651, 0xECE45B3D,
+            0xC2007CB8, 0xA163BF05, 0x98DA4836, 0x1C55D39A, 0x69163FA8, 0xFD24CF5F,
+            0x83655D23, 0xDCA3AD96, 0x1C62F356, 0x208552BB, 0x9ED52907, 0x7096966D,
+            0x670C354E, 0x4ABC9804, 0xF1746C08, 0xCA237327, 0xFFFFFFFF, 0xFFFFFFFF};
+
+        static constexpr uint32_t MODP_2048[64] = {
+            0xFFFFFFFF, 0xFFFFFFFF, 0xC90FDAA2, 0x2168C234,
+            0xC4C6628B, 0x80DC1CD1, 0x29024E08, 0x8A67CC74,
+            0x020BBEA6, 0x3B139B22, 0x514A0879, 0x8E3404DD,
+            0xEF9519B3, 0xCD3A431B, 0x302B0A6D, 0xF25F1437,
+            0x4FE1356D, 0x6D51C245, 0xE485B576, 0x625E7EC6,
+            0xF44C42E9, 0xA637ED6B, 0x0BFF5CB6, 0xF406B7ED,
+            0xEE386BFB, 0x5A899FA5, 0xAE9F2411, 0x7C4B1FE6,
+            0x49286651, 0xECE45B3D, 0xC2007CB8, 0xA163BF05,
+            0x98DA4836, 0x1C55D39A, 0x69163FA8, 0xFD24CF5F,
+            0x83655D23, 0xDCA3AD96, 0x1C62F356, 0x208552BB,
+            0x9ED52907, 0x7096966D, 0x670C354E, 0x4ABC9804,
+            0xF1746C08, 0xCA18217C, 0x32905E46, 0x2E36CE3B,
+            0xE39E772C, 0x180E8603, 0x9B2783A2, 0xEC07A28F,
+            0xB5C55DF0, 0x6F4C52C9, 0xDE2BCBF6, 0x95581718,
+            0x3995497C, 0xEA956AE5, 0x15D22618, 0x98FA0510,
+            0x15728E5A, 0x8AACAA68, 0xFFFFFFFF, 0xFFFFFFFF};
+
+        static constexpr uint32_t MODP_3072[96] = {
+            0xFFFFFFFF, 0xFFFFFFFF, 0xC90FDAA2, 0x2168C234,
+            0xC4C6628B, 0x80DC1CD1, 0x29024E08, 0x8A67CC74,
+            0x020BBEA6, 0x3B139B22, 0x514A0879, 0x8E3404DD,
+            0xEF9519B3, 0xCD3A431B, 0x302B0A6D, 0xF25F1437,
+            0x4FE1356D, 0x6D51C245, 0xE485B576, 0x625E7EC6,
+            0xF44C42E9, 0xA637ED6B, 0x0BFF5CB6, 0xF406B7ED,
+            0xEE386BFB, 0x5A899FA5, 0xAE9F2411, 0x7C4B1FE6,
+            0x49286651, 0xECE45B3D, 0xC2007CB8, 0xA163BF05,
+            0x98DA4836, 0x1C55D39A, 0x69163FA8, 0xFD24CF5F,
+            0x83655D23, 0xDCA3AD96, 0x1C62F356, 0x208552BB,
+            0x9ED52907, 0x7096966D, 0x670C354E, 0x4ABC9804,
+            0xF1746C08, 0xCA18217C, 0x32905E46, 0x2E36CE3B,
+            0xE39E772C, 0x180E8603, 0x9B2783A2, 0xEC07A28F,
+            0xB5C55DF0, 0x6F4C52C9, 0xDE2BCBF6, 0x95581718,
+            0x3995497C, 0xEA956AE5, 0x15D22618, 0x98FA0510,
+            0x15728E5A, 0x8AAAC42D, 0xAD33170D, 0x04507A33,
+            0xA85521AB, 0xDF1CBA64, 0xECFB8504, 0x58DBEF0A,
+            0x8AEA7157, 0x5D060C7D, 0xB3970F85, 0xA6E1E4C7,
+            0xABF5AE8C, 0xDB0933D7, 0x1E8C94E0, 0x4A25619D,
+            0xCEE3D226, 0x1AD2EE6B, 0xF12FFA06, 0xD98A0864,
+            0xD8760273, 0x3EC86A64, 0x521F2B18, 0x177B200C,
+            0xBBE11757, 0x7A615D6C, 0x770988C0, 0xBAD946E2,
+            0x08E24FA0, 0x74E5AB31, 0x43DB5BFC, 0xE0FD108E,
+            0x4B82D120, 0xA93AD2CA, 0xFFFFFFFF, 0xFFFFFFFF};
+
+        static constexpr uint32_t MODP_4096[128] = {
+            0xFFFFFFFF, 0xFFFFFFFF, 0xC90FDAA2, 0x2168C234,
+            0xC4C6628B, 0x80DC1CD1, 0x29024E08, 0x8A67CC74,
+            0x020BBEA6, 0x3B139B22, 0x514A0879, 0x8E3404DD,
+            0xEF9519B3, 0xCD3A431B, 0x302B0A6D, 0xF25F1437,
+            0x4FE1356D, 0x6D51C245, 0xE485B576, 0x625E7EC6,
+            0xF44C42E9, 0xA637ED6B, 0x0BFF5CB6, 0xF406B7ED,
+            0xEE386BFB, 0x5A899FA5, 0xAE9F2411, 0x7C4B1FE6,
+            0x49286651, 0xECE45B3D, 0xC2007CB8, 0xA163BF05,
+            0x98DA4836, 0x1C55D39A, 0x69163FA8, 0xFD24CF5F,
+            0x83655D23, 0xDCA3AD96, 0x1C62F356, 0x208552BB,
+            0x9ED52907, 0x7096966D, 0x670C354E, 0x4ABC9804,
+            0xF1746C08, 0xCA18217C, 0x32905E46, 0x2E36CE3B,
+            0xE39E772C, 0x180E8603, 0x9B2783A2, 0xEC07A28F,
+            0xB5C55DF0, 0x6F4C52C9, 0xDE2BCBF6, 0x95581718,
+            0x3995497C, 0xEA956AE5, 0x15D22618, 0x98FA0510,
+            0x15728E5A, 0x8AAAC42D, 0xAD33170D, 0x04507A33,
+            0xA85521AB, 0xDF1CBA64, 0xECFB8504, 0x58DBEF0A,
+            0x8AEA7157, 0x5D060C7D, 0xB3970F85, 0xA6E1E4C7,
+            0xABF5AE8C, 0xDB0933D7, 0x1E8C94E0, 0x4A25619D,
+            0xCEE3D226, 0x1AD2EE6B, 0xF12FFA06, 0xD98A0864,
+            0xD8760273, 0x3EC86A64, 0x521F2B18, 0x177B200C,
+            0xBBE11757, 0x7A615D6C, 0x770988C0, 0xBAD946E2,
+            0x08E24FA0, 0x74E5AB31, 0x43DB5BFC, 0xE0FD108E,
+            0x4B82D120, 0xA9210801, 0x1A723C12, 0xA787E6D7,
+            0x88719A10, 0xBDBA5B26, 0x99C32718, 0x6AF4E23C,
+            0x1A946834, 0xB6150BDA, 0x2583E9CA, 0x2AD44CE8,
+            0xDBBBC2DB, 0x04DE8EF9, 0x2E8EFC14, 0x1FBECAA6,
+            0x287C5947, 0x4E6BC05D, 0x99B2964F, 0xA090C3A2,
+            0x233BA186, 0x515BE7ED, 0x1F612970, 0xCEE2D7AF,
+            0xB81BDD76, 0x2170481C, 0xD0069127, 0xD5B05AA9,
+            0x93B4EA98, 0x8D8FDDC1, 0x86FFB7DC, 0x90A6C08F,
+            0x4DF435C9, 0x34063199, 0xFFFFFFFF, 0xFFFFFFFF};
+
+        // Primes and their Barrett constants are evaluated at compile time, no static initializer runs for them
+        static constexpr BarrettContext<MAX_PUBLIC_KEY_SIZE> MODP_1024_CONTEXT(PublicKey(MODP_1024, 32));
+        static constexpr BarrettContext<MAX_PUBLIC_KEY_SIZE> MODP_1536_CONTEXT(PublicKey(MODP_1536, 48));
+        static constexpr BarrettContext<MAX_PUBLIC_KEY_SIZE> MODP_2048_CONTEXT(PublicKey(MODP_2048, 64));
+        static constexpr BarrettContext<MAX_PUBLIC_KEY_SIZE> MODP_3072_CONTEXT(PublicKey(MODP_3072, 96));
+        static constexpr BarrettContext<MAX_PUBLIC_KEY_SIZE> MODP_4096_CONTEXT(PublicKey(MODP_4096, 128));
+
+        DiffieHellmanGroup::DiffieHellmanGroup(const PublicKey& p_prime, uint8_t p_generator) :
+            DiffieHellmanGroup(nullptr, std::unique_ptr<const BarrettContext<MAX_PUBLIC_KEY_SIZE>>(new BarrettContext<MAX_PUBLIC_KEY_SIZE>(p_prime)), p_generator)
+        {
+        }
+
+        DiffieHellmanGroup::DiffieHellmanGroup(const BarrettContext<MAX_PUBLIC_KEY_SIZE>* p_context,
+                                               std::unique_ptr<const BarrettContext<MAX_PUBLIC_KEY_SIZE>> p_ownedContext, uint8_t p_generator) :
+            m_ownedContext(std::move(p_ownedContext)),
+            m_context(m_ownedContext ? *m_ownedContext : *p_context),
+            m_subgroupOrder((m_context.GetModulus() - 1).RightShift()),
+            m_generator(p_generator),
+            m_bitCount(static_cast<uint32_t>(m_context.GetModulus().FindHighestBit())),
+            m_limbCount(m_context.GetModulus().FindUsedLimbCount()),
+            m_montgomeryContext(m_context.GetModulus())
+        {
+            const PublicKey& prime = m_context.GetModulus();
+
+            // Peer key validation relies on the subgroup being exactly the quadratic residues
+            if (!prime.IsOdd() || PublicKey(p_generator).Jacobi(prime) != 1)
+                throw std::invalid_argument("Generator must be a quadratic residue modulo an odd prime");
+
+            if (m_bitCount <= MontgomeryLanes::MAX_MODULUS_BITS)
+                m_lanes.reset(new MontgomeryLanes(MontgomeryLanes::Modulus(prime)));
+
+            BuildGeneratorTable();
+        }
+
+        // Out of line so MontgomeryLanes is complete where the unique_ptr is destroyed
+        DiffieHellmanGroup::~DiffieHellmanGroup() = default;
+
+        void DiffieHellmanGroup::BuildGeneratorTable()
+        {
+            m_generatorTable.resize(WINDOW_COUNT * WINDOW_SIZE * m_limbCount);
+
+            // Each window starts from generator ^ (2^(WINDOW_BITS * window)), which is the previous window's base ^ WINDOW_SIZE
+            PublicKey base(m_generator);
+            PublicKey power;
+            for (uint32_t window = 0; window < WINDOW_COUNT; ++window)
+            {
+                uint64_t* entries = m_generatorTable.data() + window * WINDOW_SIZE * m_limbCount;
+                power = 1;
+                for (uint32_t digit = 0; digit < WINDOW_SIZE; ++digit)
+                {
+                    memcpy(entries + digit * m_limbCount, m_montgomeryContext.ToMontgomery(power).Get64BitArray(), m_limbCount * 8);
+                    PublicKey::MulMod(power, power, base, m_context);
+                }
+                base = power;
+            }
+        }
+
+        PublicKey DiffieHellmanGroup::PowGenerator(const PrivateKey& p_exponent) const
+        {
+            const uint64_t* exponent = p_exponent.Get64BitArray();
+            PublicKey result = m_montgomeryContext.ToMontgomery(PublicKey(1));
+            PublicKey entry;
+            uint64_t* selected = entry.Get64BitArray();
+
+            for (uint32_t window = 0; window < WINDOW_COUNT; ++window)
+            {
+                const uint32_t bit = window * WINDOW_BITS;
+                const uint64_t digit = (exponent[bit / 64] >> (bit % 64)) & (WINDOW_SIZE - 1);
+
+                // Every entry of the window is read so the access pattern does not depend on the private key
+                const uint64_t* entries = m_generatorTable.data() + window * WINDOW_SIZE * m_limbCount;
+                memset(selected, 0, m_limbCount * 8);
+                for (uint64_t candidate = 0; candidate < WINDOW_SIZE; ++candidate)
+                {
+                    const uint64_t mask = 0 - static_cast<uint64_t>(candidate == digit);
+                    for (uint32_t i = 0; i < m_limbCount; ++i)
+                        selected[i] |= entries[candidate * m_limbCount + i] & mask;
+                }
+
+                // Montgomery products have no data dependent final reduction, unlike Barrett
+                result = m_montgomeryContext.Multiply(result, entry);
+            }
+            return m_montgomeryContext.FromMontgomery(result);
+        }
+
+        std::unique_ptr<DiffieHellmanGroup> DiffieHellmanGroup::Generate(uint32_t p_bitCount, Utils::ThreadPool& p_pool)
+        {
+            const PublicKey prime = Random::PrimeGenerator::GenerateSafePrime(p_bitCount, p_pool);
+
+            // 2 is a quadratic residue exactly when prime = +-1 mod 8, a safe prime is 3 mod 4 so that means 7 mod 8
+            const uint8_t generator = (prime.Get64BitArray()[0] & 7) == 7 ? 2 : 4;
+            return std::unique_ptr<DiffieHellmanGroup>(new DiffieHellmanGroup(prime, generator));
+        }
+
+        const DiffieHellmanGroup& DiffieHellmanGroup::Get(GroupId p_id)
+        {
+            // The runtime tables of each group are built on first use, function statics make that thread-safe
+            switch (p_id)
+            {
+            case GroupId::Modp1024:
+            {
+                static const DiffieHellmanGroup group(&MODP_1024_CONTEXT, nullptr, 2);
+                return group;
+            }
+            case GroupId::Modp1536:
+            {
+                static const DiffieHellmanGroup group(&MODP_1536_CONTEXT, nullptr, 2);
+                return group;
+            }
+            case GroupId::Modp3072:
+            {
+                static const DiffieHellmanGroup group(&MODP_3072_CONTEXT, nullptr, 2);
+                return group;
+            }
+            case GroupId::Modp4096:
+            {
+                static const DiffieHellmanGroup group(&MODP_4096_CONTEXT, nullptr, 2);
+                return group;
+            }
+            case GroupId::Modp2048:
+            default:
+                return GetDefault();
+            }
+        }
+
+        const DiffieHellmanGroup& DiffieHellmanGroup::GetDefault()
+        {
+            static const DiffieHellmanGroup group(&MODP_2048_CONTEXT, nullptr, 2);
+            return group;
+        }
+    }
+}
@@ -0,0 +1,138 @@
+#include "NGCrypto/KeyExchange/KeyPairPool.h"
+#include "NGCrypto/Utils/SecureArena.h"
+#include <algorithm>
+#include <vector>
+
+namespace Cryptography
+{
+    namespace KeyExchange
+    {
+        KeyPairPool::KeyPairPool(uint64_t p_lowWatermark, uint64_t p_highWatermark, uint64_t p_batchSize,
+                                 const DiffieHellmanGroup& p_group, Utils::ThreadPool& p_pool) :
+            m_pairs(std::max<uint64_t>(p_highWatermark, 1)),
+            m_lowWatermark(std::min(p_lowWatermark, p_highWatermark)),
+            m_highWatermark(std::max<uint64_t>(p_highWatermark, 1)),
+            m_batchSize(std::max<uint64_t>(p_batchSize, 1)),
+            m_group(p_group),
+            m_pool(p_pool)
+        {
+            m_refillThread = std::thread(&KeyPairPool::RefillLoop, this);
+            RequestRefill();
+        }
+
+        KeyPairPool::~KeyPairPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_refillMutex);
+                m_stopping = true;
+            }
+            m_refillCondition.notify_one();
+            m_refillThread.join();
+        }
+
+        void KeyPairPool::Acquire(PrivateKey& p_privateKey, PublicKey& p_publicKey)
+        {
+            KeyPair pair;
+            if (m_pairs.TryPop(pair))
+            {
+                m_hits.fetch_add(1, std::memory_order_relaxed);
+                p_privateKey = pair.privateKey;
+                p_publicKey = pair.publicKey;
+                Utils::SecureZero(&pair, sizeof(pair));
+            }
+            else
+            {
+                m_misses.fetch_add(1, std::memory_order_relaxed);
+                DiffieHellman::GenerateKeyPair(p_privateKey, p_publicKey, m_group);
+            }
+
+            if (m_pairs.GetSize() < m_lowWatermark)
+                RequestRefill();
+        }
+
+        KeyPairPool::Statistics KeyPairPool::GetStatistics() const
+        {
+            Statistics statistics;
+            statistics.hits = m_hits.load(std::memory_order_relaxed);
+            statistics.misses = m_misses.load(std::memory_order_relaxed);
+            statistics.refilled = m_refilled.load(std::memory_order_relaxed);
+            statistics.available = m_pairs.GetSize();
+
+            const uint64_t nanoseconds = m_refillNanoseconds.load(std::memory_order_relaxed);
+            statistics.refillRate = nanoseconds ? statistics.refilled * 1e9 / nanoseconds : 0.0;
+            return statistics;
+        }
+
+        void KeyPairPool::RequestRefill()
+        {
+            // Only the first request after a refill round pays for the mutex
+            if (m_refillRequested.exchange(true, std::memory_order_acq_rel))
+                return;
+
+            {
+                std::lock_guard<std::mutex> lock(m_refillMutex);
+            }
+            m_refillCondition.notify_one();
+        }
+
+        void KeyPairPool::RefillLoop()
+        {
+            std::vector<PrivateKey> privateKeys(m_batchSize);
+            std::vector<PublicKey>  publicKeys(m_batchSize);
+
+            for (;;)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(m_refillMutex);
+                    m_refillCondition.wait(lock, [this] { return m_stopping || m_refillRequested.load(std::memory_order_acquire); });
+                    if (m_stopping)
+                        break;
+                }
+
+                uint64_t available = m_pairs.GetSize();
+                while (available < m_highWatermark)
+                {
+                    const auto start = std::chrono::steady_clock::now();
+                    const uint64_t count = std::min(m_batchSize, m_highWatermark - available);
+                    DiffieHellman::GenerateKeyPairs(privateKeys.data(), publicKeys.data(), count, m_group, m_pool);
+
+                    uint64_t added = 0;
+                    for (uint64_t i = 0; i < count; ++i)
+                    {
+                        KeyPair pair {privateKeys[i], publicKeys[i]};
+                        const bool pushed = m_pairs.TryPush(pair);
+                        Utils::SecureZero(&pair, sizeof(pair));
+                        Utils::SecureZero(&privateKeys[i], sizeof(PrivateKey));
+
+                        // Consumers only take pairs out, so a full queue means the watermark was met
+                        if (!pushed)
+                            break;
+                        ++added;
+                    }
+                    // Keys left over when the queue filled up
+                    if (added < count)
+                        Utils::SecureZero(privateKeys.data() + added, (count - added) * sizeof(PrivateKey));
+
+                    // Counted per batch so statistics stay live during a long refill
+                    const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+                    m_refilled.fetch_add(added, std::memory_order_relaxed);
+                    m_refillNanoseconds.fetch_add(elapsed.count(), std::memory_order_relaxed);
+
+                    {
+                        std::lock_guard<std::mutex> lock(m_refillMutex);
+                        if (m_stopping)
+                            break;
+                    }
+                    available = m_pairs.GetSize();
+                }
+
+                // Clear the flag before looking at the size: a request racing with this either sees the cleared
+                // flag and raises it again, or its pop is visible through the acquire below
+                m_refillRequested.exchange(false, std::memory_order_acq_rel);
+                // Pops during this round may have left the pool below the low watermark again
+                if (m_pairs.GetSize() < m_lowWatermark)
+                    RequestRefill();
+            }
+        }
+    }
+}
@@ -0,0 +1,132 @@
+#include "MontgomeryLanes.h"
+#include "NGCrypto/Utils/CpuFeatures.h"
+
+namespace Cryptography
+{
+    namespace KeyExchange
+    {
+        // Splits p_limbCount 64-bit limbs into p_digitCount digits of p_digitBits, written every p_stride entries
+        static void ToDigits(const uint64_t* p_limbs, uint32_t p_limbCount, uint32_t p_digitBits, uint32_t p_digitCount,
+                             uint64_t* p_digits, uint32_t p_stride)
+        {
+            const uint64_t mask = (uint64_t(1) << p_digitBits) - 1;
+            for (uint32_t i = 0; i < p_digitCount; ++i)
+            {
+                const uint32_t bit = i * p_digitBits;
+                const uint32_t limb = bit / 64;
+                const uint32_t shift = bit % 64;
+
+                uint64_t digit = limb < p_limbCount ? p_limbs[limb] >> shift : 0;
+                if (shift + p_digitBits > 64 && limb + 1 < p_limbCount)
+                    digit |= p_limbs[limb + 1] << (64 - shift);
+                p_digits[i * p_stride] = digit & mask;
+            }
+        }
+
+        // Inverse of ToDigits, digits must be normalized
+        static void FromDigits(const uint64_t* p_digits, uint32_t p_stride, uint32_t p_digitBits, uint32_t p_digitCount,
+                               uint64_t* p_limbs, uint32_t p_limbCount)
+        {
+            memset(p_limbs, 0, p_limbCount * 8);
+            for (uint32_t i = 0; i < p_digitCount; ++i)
+            {
+                const uint64_t digit = p_digits[i * p_stride];
+                const uint32_t bit = i * p_digitBits;
+                const uint32_t limb = bit / 64;
+                const uint32_t shift = bit % 64;
+
+                if (limb < p_limbCount)
+                    p_limbs[limb] |= digit << shift;
+                if (shift + p_digitBits > 64 && limb + 1 < p_limbCount)
+                    p_limbs[limb + 1] |= digit >> (64 - shift);
+            }
+        }
+
+        MontgomeryLanes::Radix MontgomeryLanes::BuildRadix(const Modulus& p_modulus, uint32_t p_digitBits)
+        {
+            Radix radix;
+            radix.digitBits = p_digitBits;
+            // Two spare bits give R > 4 * modulus
+            radix.digitCount = static_cast<uint32_t>((p_modulus.FindHighestBit() + 2 + p_digitBits - 1) / p_digitBits);
+
+            const uint64_t* limbs = p_modulus.Get64BitArray();
+            ToDigits(limbs, MAX_MODULUS_BITS / 64, p_digitBits, radix.digitCount, radix.modulus, 1);
+
+            // Newton iteration doubles the correct low bits of the inverse each step, 1 -> 64 bits
+            uint64_t inverse = 1;
+            for (int i = 0; i < 6; ++i)
+                inverse *= 2 - limbs[0] * inverse;
+            radix.n0 = (0 - inverse) & ((uint64_t(1) << p_digitBits) - 1);
+
+            NGMP<MAX_MODULUS_BITS * 2 + 128> rSquared(1);
+            rSquared.LeftShift(2 * uint64_t(p_digitBits) * radix.digitCount);
+            rSquared %= p_modulus;
+            ToDigits(rSquared.Get64BitArray(), MAX_MODULUS_BITS / 64, p_digitBits, radix.digitCount, radix.rSquared, 1);
+
+            return radix;
+        }
+
+        MontgomeryLanes::MontgomeryLanes(const Modulus& p_modulus) : m_modulus(p_modulus)
+        {
+            if (!p_modulus.IsOdd())
+                return;
+
+            m_radix28 = BuildRadix(p_modulus, 28);
+            m_radix52 = BuildRadix(p_modulus, 52);
+
+        #if defined(__x86_64__) || defined(_M_X64)
+            const Utils::CpuFeatures& features = Utils::CpuFeatures::Get();
+            if (features.avx512ifma)
+                m_laneCount = 8;
+            else if (features.avx2)
+                m_laneCount = 4;
+        #endif
+        }
+
+        void MontgomeryLanes::PowMod(const uint64_t* const p_bases[], const uint64_t* const p_exponents[], uint32_t p_exponentBits,
+                                     uint64_t* const p_results[], uint32_t p_limbCount, uint32_t p_count) const
+        {
+            assert(p_count <= m_laneCount);
+            assert(p_limbCount <= MAX_MODULUS_BITS / 64);
+
+            const Radix& radix = m_laneCount == 8 ? m_radix52 : m_radix28;
+
+            // Padding lanes compute 1 ^ 0
+            static const uint64_t zeroExponent[(MAX_MODULUS_BITS / 64)] = {0};
+            const uint64_t* exponents[MAX_LANES];
+            uint64_t bases[MAX_DIGITS * MAX_LANES] = {0};
+            for (uint32_t lane = 0; lane < m_laneCount; ++lane)
+            {
+                if (lane < p_count)
+                {
+                    ToDigits(p_bases[lane], p_limbCount, radix.digitBits, radix.digitCount, bases + lane, m_laneCount);
+                    exponents[lane] = p_exponents[lane];
+                }
+                else
+                {
+                    bases[lane] = 1;
+                    exponents[lane] = zeroExponent;
+                }
+            }
+            assert(p_exponentBits <= sizeof(zeroExponent) * 8);
+
+            uint64_t results[MAX_DIGITS * MAX_LANES];
+        #if defined(__x86_64__) || defined(_M_X64)
+            if (m_laneCount == 8)
+                PowModLanesIFMA(radix, bases, exponents, p_exponentBits, results);
+            else
+                PowModLanesAVX2(radix, bases, exponents, p_exponentBits, results);
+        #endif
+
+            for (uint32_t lane = 0; lane < p_count; ++lane)
+            {
+                // Almost Montgomery form ends at or below the modulus, only equality needs a correction
+                Modulus result;
+                FromDigits(results + lane, m_laneCount, radix.digitBits, radix.digitCount, result.Get64BitArray(), MAX_MODULUS_BITS / 64);
+                if (result.Compare(m_modulus) >= 0)
+                    result -= m_modulus;
+                memcpy(p_results[lane], result.Get64BitArray(), p_limbCount * 8);
+            }
+        }
+    }
+}
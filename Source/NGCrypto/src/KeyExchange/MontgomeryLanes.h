@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+#include "NGMP.h"
+
+namespace Cryptography
+{
+    namespace KeyExchange
+    {
+        /**
+         * Runs several independent modular exponentiations sharing one odd modulus in lockstep,
+         * one exponentiation per SIMD lane.
+         *
+         * Values are held in a redundant radix so a whole Montgomery product accumulates
+         * without carry propagation: 2^28 digits in 64-bit lanes for AVX2 (4 lanes),
+         * 2^52 digits for AVX-512 IFMA (8 lanes). R exceeds 4 * modulus, so intermediate
+         * values stay below 2 * modulus and no conditional subtraction is needed
+         * until the very end. Exponents are consumed in fixed 4-bit windows with a
+         * constant-time table select, independent of their value.
+         */
+        class MontgomeryLanes
+        {
+        public:
+            static const uint32_t MAX_MODULUS_BITS  = 3072;
+            static const uint32_t MAX_DIGITS        = (MAX_MODULUS_BITS + 2 + 27) / 28;
+            static const uint32_t MAX_LANES         = 8;
+            static const uint32_t WINDOW_BITS       = 4;
+            static const uint32_t WINDOW_SIZE       = 1 << WINDOW_BITS;
+
+            using Modulus = NGMP<MAX_MODULUS_BITS>;
+
+            // Modulus data for one digit size
+            struct Radix
+            {
+                uint32_t digitBits  = 0;
+                uint32_t digitCount = 0;
+                // -modulus^-1 mod 2^digitBits
+                uint64_t n0         = 0;
+                uint64_t modulus[MAX_DIGITS]    = {0};
+                // R^2 mod modulus with R = 2^(digitBits * digitCount)
+                uint64_t rSquared[MAX_DIGITS]   = {0};
+            };
+
+        private:
+            Modulus     m_modulus;
+            Radix       m_radix28;
+            Radix       m_radix52;
+            uint32_t    m_laneCount = 0;
+
+            static Radix BuildRadix(const Modulus& p_modulus, uint32_t p_digitBits);
+
+        public:
+            // Lanes are only used when the CPU supports one of the kernels and the modulus is odd
+            explicit MontgomeryLanes(const Modulus& p_modulus);
+            ~MontgomeryLanes() = default;
+
+            // Number of exponentiations run per call, 0 when no vector kernel is usable
+            uint32_t GetLaneCount() const { return m_laneCount; }
+
+            /**
+             * Computes p_results[i] = p_bases[i] ^ p_exponents[i] mod modulus for i < p_count.
+             * \param p_bases values below the modulus, p_limbCount limbs each
+             * \param p_exponents p_exponentBits bits each
+             * \param p_results p_limbCount limbs each
+             * \param p_count at most GetLaneCount(), missing lanes are padded
+             */
+            void PowMod(const uint64_t* const p_bases[], const uint64_t* const p_exponents[], uint32_t p_exponentBits,
+                        uint64_t* const p_results[], uint32_t p_limbCount, uint32_t p_count) const;
+        };
+
+        // Vector kernels, p_bases and p_results interleaved as [digit][lane]
+        void PowModLanesAVX2(const MontgomeryLanes::Radix& p_radix, const uint64_t* p_bases,
+                             const uint64_t* const p_exponents[], uint32_t p_exponentBits, uint64_t* p_results);
+        void PowModLanesIFMA(const MontgomeryLanes::Radix& p_radix, const uint64_t* p_bases,
+                             const uint64_t* const p_exponents[], uint32_t p_exponentBits, uint64_t* p_results);
+    }
+}
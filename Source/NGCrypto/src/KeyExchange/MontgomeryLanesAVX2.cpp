@@ -0,0 +1,157 @@
+#include "MontgomeryLanes.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+
+// Only the kernels below are built for AVX2, NGMP code instantiated from the header keeps the baseline target
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace Cryptography
+{
+    namespace KeyExchange
+    {
+        namespace
+        {
+            const uint32_t LANES = 4;
+            const uint32_t DIGIT_BITS = 28;
+            const uint32_t MAX_DIGITS = (MontgomeryLanes::MAX_MODULUS_BITS + 2 + DIGIT_BITS - 1) / DIGIT_BITS;
+
+            // 2^28 digits keep each 56-bit partial product 8 bits clear of the 64-bit lane,
+            // so the 2 * digitCount products landing on one column never overflow
+            static_assert(2 * MAX_DIGITS < 256, "Column accumulators would overflow");
+
+            struct Modulus
+            {
+                __m256i  digits[MAX_DIGITS];
+                __m256i  n0;
+                __m256i  mask;
+                uint32_t digitCount;
+            };
+
+            // p_out = p_a * p_b / R mod modulus, inputs normalized and below 2 * modulus.
+            // p_out may alias either input.
+            void MontMul(__m256i* p_out, const __m256i* p_a, const __m256i* p_b, const Modulus& p_modulus)
+            {
+                const uint32_t d = p_modulus.digitCount;
+                __m256i t[2 * MAX_DIGITS];
+                for (uint32_t i = 0; i < 2 * d; ++i)
+                    t[i] = _mm256_setzero_si256();
+
+                for (uint32_t i = 0; i < d; ++i)
+                {
+                    const __m256i a = p_a[i];
+                    t[i] = _mm256_add_epi64(t[i], _mm256_mul_epu32(a, p_b[0]));
+                    // Only t[i] mod 2^28 matters, which the low 32 bits used by mul_epu32 contain
+                    const __m256i m = _mm256_and_si256(_mm256_mul_epu32(t[i], p_modulus.n0), p_modulus.mask);
+                    t[i] = _mm256_add_epi64(t[i], _mm256_mul_epu32(m, p_modulus.digits[0]));
+
+                    for (uint32_t j = 1; j < d; ++j)
+                    {
+                        const __m256i sum = _mm256_add_epi64(_mm256_mul_epu32(a, p_b[j]), _mm256_mul_epu32(m, p_modulus.digits[j]));
+                        t[i + j] = _mm256_add_epi64(t[i + j], sum);
+                    }
+
+                    // Low digit is now zero, carry the rest up
+                    t[i + 1] = _mm256_add_epi64(t[i + 1], _mm256_srli_epi64(t[i], DIGIT_BITS));
+                }
+
+                __m256i carry = _mm256_setzero_si256();
+                for (uint32_t i = 0; i < d; ++i)
+                {
+                    const __m256i value = _mm256_add_epi64(t[d + i], carry);
+                    p_out[i] = _mm256_and_si256(value, p_modulus.mask);
+                    carry = _mm256_srli_epi64(value, DIGIT_BITS);
+                }
+            }
+
+            // Constant-time per-lane table lookup
+            void Select(__m256i* p_out, const __m256i (*p_table)[MAX_DIGITS], __m256i p_index, uint32_t p_digitCount)
+            {
+                for (uint32_t i = 0; i < p_digitCount; ++i)
+                    p_out[i] = _mm256_setzero_si256();
+
+                for (uint32_t entry = 0; entry < MontgomeryLanes::WINDOW_SIZE; ++entry)
+                {
+                    const __m256i mask = _mm256_cmpeq_epi64(p_index, _mm256_set1_epi64x(entry));
+                    for (uint32_t i = 0; i < p_digitCount; ++i)
+                        p_out[i] = _mm256_or_si256(p_out[i], _mm256_and_si256(p_table[entry][i], mask));
+                }
+            }
+
+            __m256i WindowIndex(const uint64_t* const p_exponents[], uint32_t p_bit)
+            {
+                const uint32_t limb = p_bit / 64;
+                const uint32_t shift = p_bit % 64;
+                const uint64_t mask = MontgomeryLanes::WINDOW_SIZE - 1;
+                return _mm256_set_epi64x((p_exponents[3][limb] >> shift) & mask, (p_exponents[2][limb] >> shift) & mask,
+                                         (p_exponents[1][limb] >> shift) & mask, (p_exponents[0][limb] >> shift) & mask);
+            }
+        }
+
+        void PowModLanesAVX2(const MontgomeryLanes::Radix& p_radix, const uint64_t* p_bases,
+                             const uint64_t* const p_exponents[], uint32_t p_exponentBits, uint64_t* p_results)
+        {
+            assert(p_radix.digitBits == DIGIT_BITS);
+            const uint32_t d = p_radix.digitCount;
+
+            // x ^ 0 = 1, the ladder below needs at least one window and one digit
+            if (p_exponentBits == 0 || d == 0)
+            {
+                for (uint32_t i = 0; i < d * LANES; ++i)
+                    p_results[i] = i < LANES;
+                return;
+            }
+
+            Modulus modulus;
+            modulus.digitCount = d;
+            modulus.n0 = _mm256_set1_epi64x(p_radix.n0);
+            modulus.mask = _mm256_set1_epi64x((uint64_t(1) << DIGIT_BITS) - 1);
+
+            __m256i rSquared[MAX_DIGITS], one[MAX_DIGITS], base[MAX_DIGITS];
+            for (uint32_t i = 0; i < d; ++i)
+            {
+                modulus.digits[i] = _mm256_set1_epi64x(p_radix.modulus[i]);
+                rSquared[i] = _mm256_set1_epi64x(p_radix.rSquared[i]);
+                one[i] = _mm256_set1_epi64x(i == 0);
+                base[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p_bases + i * LANES));
+            }
+
+            // table[k] = base^k in Montgomery form
+            __m256i table[MontgomeryLanes::WINDOW_SIZE][MAX_DIGITS];
+            MontMul(table[0], rSquared, one, modulus);
+            MontMul(table[1], base, rSquared, modulus);
+            for (uint32_t k = 2; k < MontgomeryLanes::WINDOW_SIZE; ++k)
+                MontMul(table[k], table[k - 1], table[1], modulus);
+
+            const uint32_t windowCount = (p_exponentBits + MontgomeryLanes::WINDOW_BITS - 1) / MontgomeryLanes::WINDOW_BITS;
+            __m256i accumulator[MAX_DIGITS], factor[MAX_DIGITS];
+            Select(accumulator, table, WindowIndex(p_exponents, (windowCount - 1) * MontgomeryLanes::WINDOW_BITS), d);
+
+            for (int window = windowCount - 2; window >= 0; --window)
+            {
+                for (uint32_t i = 0; i < MontgomeryLanes::WINDOW_BITS; ++i)
+                    MontMul(accumulator, accumulator, accumulator, modulus);
+
+                Select(factor, table, WindowIndex(p_exponents, window * MontgomeryLanes::WINDOW_BITS), d);
+                MontMul(accumulator, accumulator, factor, modulus);
+            }
+
+            // Leave Montgomery form
+            MontMul(accumulator, accumulator, one, modulus);
+            for (uint32_t i = 0; i < d; ++i)
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(p_results + i * LANES), accumulator[i]);
+        }
+    }
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif
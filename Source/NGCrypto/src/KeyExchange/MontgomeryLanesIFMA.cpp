@@ -0,0 +1,168 @@
+#include "MontgomeryLanes.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+
+// Only the kernels below are built for AVX-512 IFMA, NGMP code instantiated from the header keeps the baseline target
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,avx512ifma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512ifma")
+#endif
+
+namespace Cryptography
+{
+    namespace KeyExchange
+    {
+        namespace
+        {
+            const uint32_t LANES = 8;
+            const uint32_t DIGIT_BITS = 52;
+            const uint32_t MAX_DIGITS = (MontgomeryLanes::MAX_MODULUS_BITS + 2 + DIGIT_BITS - 1) / DIGIT_BITS;
+
+            // Each column collects at most 4 * digitCount 52-bit halves of products
+            static_assert(4 * MAX_DIGITS < 4096, "Column accumulators would overflow");
+
+            struct Modulus
+            {
+                __m512i  digits[MAX_DIGITS];
+                __m512i  n0;
+                __m512i  mask;
+                uint32_t digitCount;
+            };
+
+            // Carry out of each digit. The zero-masking form compiles to the same vpsrlq, the plain intrinsic
+            // passes an undefined vector through that GCC 12 reports as maybe uninitialized
+            __m512i ShiftDigit(__m512i p_value)
+            {
+                return _mm512_maskz_srli_epi64(0xFF, p_value, DIGIT_BITS);
+            }
+
+            // p_out = p_a * p_b / R mod modulus, inputs normalized and below 2 * modulus.
+            // p_out may alias either input.
+            void MontMul(__m512i* p_out, const __m512i* p_a, const __m512i* p_b, const Modulus& p_modulus)
+            {
+                const uint32_t d = p_modulus.digitCount;
+                __m512i t[2 * MAX_DIGITS + 1];
+                for (uint32_t i = 0; i <= 2 * d; ++i)
+                    t[i] = _mm512_setzero_si512();
+
+                for (uint32_t i = 0; i < d; ++i)
+                {
+                    const __m512i a = p_a[i];
+                    t[i] = _mm512_madd52lo_epu64(t[i], a, p_b[0]);
+                    // madd52 only reads the low 52 bits of t[i], which is all m depends on
+                    const __m512i m = _mm512_and_si512(_mm512_madd52lo_epu64(_mm512_setzero_si512(), t[i], p_modulus.n0), p_modulus.mask);
+                    t[i] = _mm512_madd52lo_epu64(t[i], m, p_modulus.digits[0]);
+                    t[i + 1] = _mm512_madd52hi_epu64(t[i + 1], a, p_b[0]);
+                    t[i + 1] = _mm512_madd52hi_epu64(t[i + 1], m, p_modulus.digits[0]);
+
+                    for (uint32_t j = 1; j < d; ++j)
+                    {
+                        t[i + j] = _mm512_madd52lo_epu64(_mm512_madd52lo_epu64(t[i + j], a, p_b[j]), m, p_modulus.digits[j]);
+                        t[i + j + 1] = _mm512_madd52hi_epu64(_mm512_madd52hi_epu64(t[i + j + 1], a, p_b[j]), m, p_modulus.digits[j]);
+                    }
+
+                    // Low digit is now zero, carry the rest up
+                    t[i + 1] = _mm512_add_epi64(t[i + 1], ShiftDigit(t[i]));
+                }
+
+                // The result is below 2 * modulus < R, so t[2d] and the final carry are zero
+                __m512i carry = _mm512_setzero_si512();
+                for (uint32_t i = 0; i < d; ++i)
+                {
+                    const __m512i value = _mm512_add_epi64(t[d + i], carry);
+                    p_out[i] = _mm512_and_si512(value, p_modulus.mask);
+                    carry = ShiftDigit(value);
+                }
+            }
+
+            // Constant-time per-lane table lookup
+            void Select(__m512i* p_out, const __m512i (*p_table)[MAX_DIGITS], __m512i p_index, uint32_t p_digitCount)
+            {
+                for (uint32_t i = 0; i < p_digitCount; ++i)
+                    p_out[i] = _mm512_setzero_si512();
+
+                for (uint32_t entry = 0; entry < MontgomeryLanes::WINDOW_SIZE; ++entry)
+                {
+                    const __mmask8 mask = _mm512_cmpeq_epi64_mask(p_index, _mm512_set1_epi64(entry));
+                    for (uint32_t i = 0; i < p_digitCount; ++i)
+                        p_out[i] = _mm512_mask_mov_epi64(p_out[i], mask, p_table[entry][i]);
+                }
+            }
+
+            __m512i WindowIndex(const uint64_t* const p_exponents[], uint32_t p_bit)
+            {
+                const uint32_t limb = p_bit / 64;
+                const uint32_t shift = p_bit % 64;
+                const uint64_t mask = MontgomeryLanes::WINDOW_SIZE - 1;
+                return _mm512_set_epi64((p_exponents[7][limb] >> shift) & mask, (p_exponents[6][limb] >> shift) & mask,
+                                        (p_exponents[5][limb] >> shift) & mask, (p_exponents[4][limb] >> shift) & mask,
+                                        (p_exponents[3][limb] >> shift) & mask, (p_exponents[2][limb] >> shift) & mask,
+                                        (p_exponents[1][limb] >> shift) & mask, (p_exponents[0][limb] >> shift) & mask);
+            }
+        }
+
+        void PowModLanesIFMA(const MontgomeryLanes::Radix& p_radix, const uint64_t* p_bases,
+                             const uint64_t* const p_exponents[], uint32_t p_exponentBits, uint64_t* p_results)
+        {
+            assert(p_radix.digitBits == DIGIT_BITS);
+            const uint32_t d = p_radix.digitCount;
+
+            // x ^ 0 = 1, the ladder below needs at least one window and one digit
+            if (p_exponentBits == 0 || d == 0)
+            {
+                for (uint32_t i = 0; i < d * LANES; ++i)
+                    p_results[i] = i < LANES;
+                return;
+            }
+
+            Modulus modulus;
+            modulus.digitCount = d;
+            modulus.n0 = _mm512_set1_epi64(p_radix.n0);
+            modulus.mask = _mm512_set1_epi64((uint64_t(1) << DIGIT_BITS) - 1);
+
+            __m512i rSquared[MAX_DIGITS], one[MAX_DIGITS], base[MAX_DIGITS];
+            for (uint32_t i = 0; i < d; ++i)
+            {
+                modulus.digits[i] = _mm512_set1_epi64(p_radix.modulus[i]);
+                rSquared[i] = _mm512_set1_epi64(p_radix.rSquared[i]);
+                one[i] = _mm512_set1_epi64(i == 0);
+                base[i] = _mm512_loadu_si512(reinterpret_cast<const __m512i*>(p_bases + i * LANES));
+            }
+
+            // table[k] = base^k in Montgomery form
+            __m512i table[MontgomeryLanes::WINDOW_SIZE][MAX_DIGITS];
+            MontMul(table[0], rSquared, one, modulus);
+            MontMul(table[1], base, rSquared, modulus);
+            for (uint32_t k = 2; k < MontgomeryLanes::WINDOW_SIZE; ++k)
+                MontMul(table[k], table[k - 1], table[1], modulus);
+
+            const uint32_t windowCount = (p_exponentBits + MontgomeryLanes::WINDOW_BITS - 1) / MontgomeryLanes::WINDOW_BITS;
+            __m512i accumulator[MAX_DIGITS], factor[MAX_DIGITS];
+            Select(accumulator, table, WindowIndex(p_exponents, (windowCount - 1) * MontgomeryLanes::WINDOW_BITS), d);
+
+            for (int window = windowCount - 2; window >= 0; --window)
+            {
+                for (uint32_t i = 0; i < MontgomeryLanes::WINDOW_BITS; ++i)
+                    MontMul(accumulator, accumulator, accumulator, modulus);
+
+                Select(factor, table, WindowIndex(p_exponents, window * MontgomeryLanes::WINDOW_BITS), d);
+                MontMul(accumulator, accumulator, factor, modulus);
+            }
+
+            // Leave Montgomery form
+            MontMul(accumulator, accumulator, one, modulus);
+            for (uint32_t i = 0; i < d; ++i)
+                _mm512_storeu_si512(reinterpret_cast<__m512i*>(p_results + i * LANES), accumulator[i]);
+        }
+    }
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif
@@ -0,0 +1,382 @@
+#include "NGCrypto/KeyExchange/X25519.h"
+#include "NGCrypto/Random/CtrDrbg.h"
+#include "NGCrypto/Utils/SecureArena.h"
+#include <stdexcept>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace Cryptography
+{
+    namespace KeyExchange
+    {
+        namespace
+        {
+            const uint64_t MASK_51 = (uint64_t(1) << 51) - 1;
+
+            // 128-bit accumulator, MSVC has no native 128-bit integer
+        #if defined(_MSC_VER) && !defined(__clang__)
+            struct Wide
+            {
+                uint64_t low;
+                uint64_t high;
+            };
+
+            inline Wide Mul(uint64_t p_a, uint64_t p_b)
+            {
+                Wide result;
+                result.low = _umul128(p_a, p_b, &result.high);
+                return result;
+            }
+
+            inline Wide operator+(Wide p_a, Wide p_b)
+            {
+                Wide result;
+                const unsigned char carry = _addcarry_u64(0, p_a.low, p_b.low, &result.low);
+                _addcarry_u64(carry, p_a.high, p_b.high, &result.high);
+                return result;
+            }
+
+            inline Wide operator+(Wide p_a, uint64_t p_b)
+            {
+                Wide result;
+                const unsigned char carry = _addcarry_u64(0, p_a.low, p_b, &result.low);
+                result.high = p_a.high + carry;
+                return result;
+            }
+
+            inline uint64_t Low51(Wide p_value)
+            {
+                return p_value.low & MASK_51;
+            }
+
+            inline uint64_t Shift51(Wide p_value)
+            {
+                return __shiftright128(p_value.low, p_value.high, 51);
+            }
+        #else
+            using Wide = unsigned __int128;
+
+            inline Wide Mul(uint64_t p_a, uint64_t p_b)
+            {
+                return static_cast<Wide>(p_a) * p_b;
+            }
+
+            inline uint64_t Low51(Wide p_value)
+            {
+                return static_cast<uint64_t>(p_value) & MASK_51;
+            }
+
+            inline uint64_t Shift51(Wide p_value)
+            {
+                return static_cast<uint64_t>(p_value >> 51);
+            }
+        #endif
+
+            // Element of GF(2^255 - 19) as sum of limb[i] * 2^(51 * i).
+            // Limbs may exceed 51 bits between operations, only ToBytes produces the canonical value.
+            struct FieldElement
+            {
+                uint64_t limb[5];
+            };
+
+            // Out = the five column sums after carrying, reduced below 2^52 per limb
+            inline void Carry(FieldElement& p_out, Wide p_r0, Wide p_r1, Wide p_r2, Wide p_r3, Wide p_r4)
+            {
+                uint64_t carry;
+                p_out.limb[0] = Low51(p_r0); carry = Shift51(p_r0);
+                p_r1 = p_r1 + carry;
+                p_out.limb[1] = Low51(p_r1); carry = Shift51(p_r1);
+                p_r2 = p_r2 + carry;
+                p_out.limb[2] = Low51(p_r2); carry = Shift51(p_r2);
+                p_r3 = p_r3 + carry;
+                p_out.limb[3] = Low51(p_r3); carry = Shift51(p_r3);
+                p_r4 = p_r4 + carry;
+                p_out.limb[4] = Low51(p_r4); carry = Shift51(p_r4);
+
+                // 2^255 = 19 mod p
+                p_out.limb[0] += carry * 19;
+                p_out.limb[1] += p_out.limb[0] >> 51;
+                p_out.limb[0] &= MASK_51;
+            }
+
+            inline void Add(FieldElement& p_out, const FieldElement& p_a, const FieldElement& p_b)
+            {
+                for (int i = 0; i < 5; ++i)
+                    p_out.limb[i] = p_a.limb[i] + p_b.limb[i];
+            }
+
+            // Adds 2p first so no limb goes negative, p_b limbs must be below 2^52
+            inline void Sub(FieldElement& p_out, const FieldElement& p_a, const FieldElement& p_b)
+            {
+                p_out.limb[0] = p_a.limb[0] + 0xFFFFFFFFFFFDA - p_b.limb[0];
+                for (int i = 1; i < 5; ++i)
+                    p_out.limb[i] = p_a.limb[i] + 0xFFFFFFFFFFFFE - p_b.limb[i];
+            }
+
+            void Mul(FieldElement& p_out, const FieldElement& p_a, const FieldElement& p_b)
+            {
+                const uint64_t* a = p_a.limb;
+                const uint64_t* b = p_b.limb;
+
+                // Columns past limb 4 wrap around multiplied by 19
+                const uint64_t b1 = b[1] * 19, b2 = b[2] * 19, b3 = b[3] * 19, b4 = b[4] * 19;
+
+                const Wide r0 = Mul(a[0], b[0]) + Mul(a[1], b4) + Mul(a[2], b3) + Mul(a[3], b2) + Mul(a[4], b1);
+                const Wide r1 = Mul(a[0], b[1]) + Mul(a[1], b[0]) + Mul(a[2], b4) + Mul(a[3], b3) + Mul(a[4], b2);
+                const Wide r2 = Mul(a[0], b[2]) + Mul(a[1], b[1]) + Mul(a[2], b[0]) + Mul(a[3], b4) + Mul(a[4], b3);
+                const Wide r3 = Mul(a[0], b[3]) + Mul(a[1], b[2]) + Mul(a[2], b[1]) + Mul(a[3], b[0]) + Mul(a[4], b4);
+                const Wide r4 = Mul(a[0], b[4]) + Mul(a[1], b[3]) + Mul(a[2], b[2]) + Mul(a[3], b[1]) + Mul(a[4], b[0]);
+
+                Carry(p_out, r0, r1, r2, r3, r4);
+            }
+
+            // Symmetric products are computed once and doubled, 15 multiplications instead of 25
+            void Square(FieldElement& p_out, const FieldElement& p_a)
+            {
+                const uint64_t* a = p_a.limb;
+                const uint64_t a0x2 = a[0] * 2, a1x2 = a[1] * 2, a2x2 = a[2] * 2, a3x2 = a[3] * 2;
+                const uint64_t a3x19 = a[3] * 19, a4x19 = a[4] * 19;
+
+                const Wide r0 = Mul(a[0], a[0]) + Mul(a1x2, a4x19) + Mul(a2x2, a3x19);
+                const Wide r1 = Mul(a0x2, a[1]) + Mul(a2x2, a4x19) + Mul(a[3], a3x19);
+                const Wide r2 = Mul(a0x2, a[2]) + Mul(a[1], a[1]) + Mul(a3x2, a4x19);
+                const Wide r3 = Mul(a0x2, a[3]) + Mul(a1x2, a[2]) + Mul(a[4], a4x19);
+                const Wide r4 = Mul(a0x2, a[4]) + Mul(a1x2, a[3]) + Mul(a[2], a[2]);
+
+                Carry(p_out, r0, r1, r2, r3, r4);
+            }
+
+            void SquareTimes(FieldElement& p_out, const FieldElement& p_a, uint32_t p_count)
+            {
+                Square(p_out, p_a);
+                for (uint32_t i = 1; i < p_count; ++i)
+                    Square(p_out, p_out);
+            }
+
+            void MulSmall(FieldElement& p_out, const FieldElement& p_a, uint64_t p_factor)
+            {
+                Carry(p_out, Mul(p_a.limb[0], p_factor), Mul(p_a.limb[1], p_factor), Mul(p_a.limb[2], p_factor),
+                      Mul(p_a.limb[3], p_factor), Mul(p_a.limb[4], p_factor));
+            }
+
+            // p_a ^ (p - 2) = p_a ^ -1, fixed addition chain of 254 squarings and 11 multiplications
+            void Invert(FieldElement& p_out, const FieldElement& p_a)
+            {
+                FieldElement z2, z9, z11, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0, t;
+
+                Square(z2, p_a);
+                SquareTimes(t, z2, 2);
+                Mul(z9, t, p_a);
+                Mul(z11, z9, z2);
+                Square(t, z11);
+                Mul(z2_5_0, t, z9);
+
+                SquareTimes(t, z2_5_0, 5);
+                Mul(z2_10_0, t, z2_5_0);
+                SquareTimes(t, z2_10_0, 10);
+                Mul(z2_20_0, t, z2_10_0);
+                SquareTimes(t, z2_20_0, 20);
+                Mul(t, t, z2_20_0);
+                SquareTimes(t, t, 10);
+                Mul(z2_50_0, t, z2_10_0);
+                SquareTimes(t, z2_50_0, 50);
+                Mul(z2_100_0, t, z2_50_0);
+                SquareTimes(t, z2_100_0, 100);
+                Mul(t, t, z2_100_0);
+                SquareTimes(t, t, 50);
+                Mul(t, t, z2_50_0);
+                SquareTimes(t, t, 5);
+                Mul(p_out, t, z11);
+            }
+
+            // Swaps p_a and p_b when p_swap is 1, without a branch
+            inline void ConditionalSwap(FieldElement& p_a, FieldElement& p_b, uint64_t p_swap)
+            {
+                const uint64_t mask = 0 - p_swap;
+                for (int i = 0; i < 5; ++i)
+                {
+                    const uint64_t x = (p_a.limb[i] ^ p_b.limb[i]) & mask;
+                    p_a.limb[i] ^= x;
+                    p_b.limb[i] ^= x;
+                }
+            }
+
+            inline uint64_t Load64(const uint8_t* p_in)
+            {
+                uint64_t value = 0;
+                for (int i = 7; i >= 0; --i)
+                    value = (value << 8) | p_in[i];
+                return value;
+            }
+
+            inline void Store64(uint8_t* p_out, uint64_t p_value)
+            {
+                for (int i = 0; i < 8; ++i)
+                    p_out[i] = static_cast<uint8_t>(p_value >> (8 * i));
+            }
+
+            // Ignores the most significant bit, as RFC 7748 requires for u-coordinates
+            void FromBytes(FieldElement& p_out, const uint8_t p_in[X25519::KEY_SIZE])
+            {
+                const uint64_t w0 = Load64(p_in), w1 = Load64(p_in + 8), w2 = Load64(p_in + 16), w3 = Load64(p_in + 24);
+                p_out.limb[0] = w0 & MASK_51;
+                p_out.limb[1] = ((w0 >> 51) | (w1 << 13)) & MASK_51;
+                p_out.limb[2] = ((w1 >> 38) | (w2 << 26)) & MASK_51;
+                p_out.limb[3] = ((w2 >> 25) | (w3 << 39)) & MASK_51;
+                p_out.limb[4] = (w3 >> 12) & MASK_51;
+            }
+
+            // Canonical encoding, fully reduced mod p
+            void ToBytes(uint8_t p_out[X25519::KEY_SIZE], const FieldElement& p_a)
+            {
+                uint64_t h[5] = {p_a.limb[0], p_a.limb[1], p_a.limb[2], p_a.limb[3], p_a.limb[4]};
+
+                // Two carry passes leave every limb below 2^51 and the value below 2p
+                for (int pass = 0; pass < 2; ++pass)
+                {
+                    for (int i = 0; i < 4; ++i)
+                    {
+                        h[i + 1] += h[i] >> 51;
+                        h[i] &= MASK_51;
+                    }
+                    h[0] += (h[4] >> 51) * 19;
+                    h[4] &= MASK_51;
+                }
+
+                // q = 1 exactly when h >= p, found from the carry out of h + 19
+                uint64_t q = (h[0] + 19) >> 51;
+                for (int i = 1; i < 5; ++i)
+                    q = (h[i] + q) >> 51;
+
+                // h - q * p = h + 19q - q * 2^255, the last term drops out with the top bit
+                h[0] += 19 * q;
+                for (int i = 0; i < 4; ++i)
+                {
+                    h[i + 1] += h[i] >> 51;
+                    h[i] &= MASK_51;
+                }
+                h[4] &= MASK_51;
+
+                Store64(p_out,      h[0] | (h[1] << 51));
+                Store64(p_out + 8,  (h[1] >> 13) | (h[2] << 38));
+                Store64(p_out + 16, (h[2] >> 26) | (h[3] << 25));
+                Store64(p_out + 24, (h[3] >> 39) | (h[4] << 12));
+            }
+
+            const uint8_t BASE_POINT[X25519::KEY_SIZE] = {9};
+            // (A - 2) / 4 for curve25519, A = 486662
+            const uint64_t A24 = 121665;
+        }
+
+        void X25519::ScalarMult(uint8_t p_out[KEY_SIZE], const uint8_t p_scalar[KEY_SIZE], const uint8_t p_point[KEY_SIZE])
+        {
+            uint8_t scalar[KEY_SIZE];
+            for (uint32_t i = 0; i < KEY_SIZE; ++i)
+                scalar[i] = p_scalar[i];
+            scalar[0] &= 248;
+            scalar[31] &= 127;
+            scalar[31] |= 64;
+
+            FieldElement x1, x2 = {{1}}, z2 = {{0}}, x3, z3 = {{1}};
+            FieldElement a, aa, b, bb, e, c, d, da, cb;
+            FromBytes(x1, p_point);
+            x3 = x1;
+
+            // RFC 7748 ladder, one step per scalar bit from bit 254 down
+            uint64_t swap = 0;
+            for (int t = 254; t >= 0; --t)
+            {
+                const uint64_t bit = (scalar[t >> 3] >> (t & 7)) & 1;
+                swap ^= bit;
+                ConditionalSwap(x2, x3, swap);
+                ConditionalSwap(z2, z3, swap);
+                swap = bit;
+
+                Add(a, x2, z2);
+                Square(aa, a);
+                Sub(b, x2, z2);
+                Square(bb, b);
+                Sub(e, aa, bb);
+                Add(c, x3, z3);
+                Sub(d, x3, z3);
+                Mul(da, d, a);
+                Mul(cb, c, b);
+
+                Add(x3, da, cb);
+                Square(x3, x3);
+                Sub(z3, da, cb);
+                Square(z3, z3);
+                Mul(z3, z3, x1);
+
+                Mul(x2, aa, bb);
+                MulSmall(z2, e, A24);
+                Add(z2, z2, aa);
+                Mul(z2, z2, e);
+            }
+            ConditionalSwap(x2, x3, swap);
+            ConditionalSwap(z2, z3, swap);
+
+            Invert(z2, z2);
+            Mul(x2, x2, z2);
+            ToBytes(p_out, x2);
+
+            Utils::SecureZero(scalar, KEY_SIZE);
+        }
+
+        void X25519::GenerateKeyPair(PrivateKey& p_privateKey, PublicKey& p_publicKey)
+        {
+            Random::CtrDrbg::Fill(p_privateKey.data(), KEY_SIZE);
+            ScalarMult(p_publicKey.data(), p_privateKey.data(), BASE_POINT);
+        }
+
+        void X25519::GenerateKeyPairs(PrivateKey* p_privateKeys, PublicKey* p_publicKeys, uint64_t p_count,
+                                      Utils::ThreadPool& p_pool)
+        {
+            Random::CtrDrbg& drbg = Random::CtrDrbg::GetThreadInstance();
+            for (uint64_t i = 0; i < p_count; ++i)
+                drbg.Generate(p_privateKeys[i].data(), KEY_SIZE);
+
+            // A ladder is a few tens of microseconds, chunks of 16 keep task overhead small
+            p_pool.ParallelFor(p_count, 16, [=](uint64_t p_begin, uint64_t p_end)
+            {
+                for (uint64_t i = p_begin; i < p_end; ++i)
+                    ScalarMult(p_publicKeys[i].data(), p_privateKeys[i].data(), BASE_POINT);
+            });
+        }
+
+        X25519::SharedKey X25519::GenerateSharedKey(const PublicKey& p_otherPublic, const PrivateKey& p_privateKey)
+        {
+            SharedKey sharedKey;
+            ScalarMult(sharedKey.data(), p_privateKey.data(), p_otherPublic.data());
+
+            // RFC 7748 section 6.1, an all zero result means the peer sent a low order point
+            uint8_t accumulator = 0;
+            for (uint32_t i = 0; i < KEY_SIZE; ++i)
+                accumulator |= sharedKey[i];
+            if (accumulator == 0)
+                throw std::invalid_argument("Public key is a low order point");
+
+            return sharedKey;
+        }
+
+        void X25519::GenerateSharedKeys(const PublicKey* p_otherPublics, const PrivateKey* p_privateKeys,
+                                        SharedKey* p_sharedKeys, KeyStatus* p_status, uint64_t p_count,
+                                        Utils::ThreadPool& p_pool)
+        {
+            p_pool.ParallelFor(p_count, 16, [=](uint64_t p_begin, uint64_t p_end)
+            {
+                for (uint64_t i = p_begin; i < p_end; ++i)
+                {
+                    ScalarMult(p_sharedKeys[i].data(), p_privateKeys[i].data(), p_otherPublics[i].data());
+
+                    uint8_t accumulator = 0;
+                    for (uint32_t j = 0; j < KEY_SIZE; ++j)
+                        accumulator |= p_sharedKeys[i][j];
+                    p_status[i] = accumulator ? KeyStatus::Success : KeyStatus::InvalidPublicKey;
+                }
+            });
+        }
+    }
+}
@@ -0,0 +1,200 @@
+#include "NGCrypto/Random/CtrDrbg.h"
+#include "NGCrypto/Utils/SecureArena.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#include <bcrypt.h>
+#pragma comment(lib, "bcrypt.lib")
+#else
+#include <atomic>
+#include <cerrno>
+#include <pthread.h>
+#include <sys/random.h>
+#endif
+
+namespace Cryptography
+{
+    namespace Random
+    {
+        static const uint8_t ZERO_KEY[CtrDrbg::KEY_SIZE] = {0};
+        // Fork generation of instances that only ever ran on a caller's seed
+        static const uint64_t UNTRACKED_GENERATION = UINT64_MAX;
+
+        namespace
+        {
+        #if !defined(_WIN32)
+            // Bumped in the child of every fork, so copies of a parent's state know to reseed
+            std::atomic<uint64_t> g_forkGeneration {0};
+
+            void OnForkChild()
+            {
+                g_forkGeneration.fetch_add(1, std::memory_order_relaxed);
+            }
+        #endif
+
+            uint64_t GetForkGeneration()
+            {
+            #if defined(_WIN32)
+                // No fork, processes never share a state
+                return 0;
+            #else
+                static const bool registered = pthread_atfork(nullptr, nullptr, OnForkChild) == 0;
+                if (!registered)
+                    throw std::runtime_error("pthread_atfork failed");
+                return g_forkGeneration.load(std::memory_order_relaxed);
+            #endif
+            }
+        }
+
+        CtrDrbg::CtrDrbg() : m_key{0}, m_v{0}, m_cipher(ZERO_KEY), m_position(BUFFER_SIZE), m_reseedCounter(0),
+            m_forkGeneration(UNTRACKED_GENERATION)
+        {
+            Reseed();
+        }
+
+        CtrDrbg::CtrDrbg(const uint8_t p_seed[SEED_SIZE]) : m_key{0}, m_v{0}, m_cipher(ZERO_KEY), m_position(BUFFER_SIZE), m_reseedCounter(0),
+            m_forkGeneration(UNTRACKED_GENERATION)
+        {
+            Reseed(p_seed);
+        }
+
+        CtrDrbg::~CtrDrbg()
+        {
+            // Served bytes are already wiped, the cipher wipes its own key schedule
+            Utils::SecureZero(m_key, KEY_SIZE);
+            Utils::SecureZero(m_v, BLOCK_SIZE);
+            Utils::SecureZero(m_buffer + m_position, BUFFER_SIZE - m_position);
+        }
+
+        void CtrDrbg::GetEntropy(uint8_t* p_out, uint64_t p_size)
+        {
+        #if defined(_WIN32)
+            while (p_size)
+            {
+                const ULONG chunk = static_cast<ULONG>(std::min<uint64_t>(p_size, 0x7FFFFFFF));
+                if (!BCRYPT_SUCCESS(BCryptGenRandom(nullptr, p_out, chunk, BCRYPT_USE_SYSTEM_PREFERRED_RNG)))
+                    throw std::runtime_error("BCryptGenRandom failed");
+                p_out += chunk;
+                p_size -= chunk;
+            }
+        #else
+            while (p_size)
+            {
+                const ssize_t read = getrandom(p_out, static_cast<size_t>(std::min<uint64_t>(p_size, 256)), 0);
+                if (read < 0)
+                {
+                    if (errno == EINTR)
+                        continue;
+                    throw std::runtime_error("getrandom failed");
+                }
+                p_out += read;
+                p_size -= read;
+            }
+        #endif
+        }
+
+        void CtrDrbg::IncrementCounter()
+        {
+            // V is a big-endian 128-bit counter
+            for (int i = BLOCK_SIZE - 1; i >= 0; --i)
+            {
+                if (++m_v[i] != 0)
+                    break;
+            }
+        }
+
+        void CtrDrbg::Update(const uint8_t p_data[SEED_SIZE])
+        {
+            uint8_t temp[SEED_SIZE];
+            for (uint32_t offset = 0; offset < SEED_SIZE; offset += BLOCK_SIZE)
+            {
+                IncrementCounter();
+                memcpy(temp + offset, m_v, BLOCK_SIZE);
+            }
+            m_cipher.EncryptECB(temp, temp, SEED_SIZE);
+
+            for (uint32_t i = 0; i < SEED_SIZE; ++i)
+                temp[i] ^= p_data[i];
+
+            memcpy(m_key, temp, KEY_SIZE);
+            memcpy(m_v, temp + KEY_SIZE, BLOCK_SIZE);
+            m_cipher = Encryption::AES(m_key);
+
+            Utils::SecureZero(temp, SEED_SIZE);
+        }
+
+        void CtrDrbg::Reseed()
+        {
+            m_forkGeneration = GetForkGeneration();
+
+            uint8_t seed[SEED_SIZE];
+            GetEntropy(seed, SEED_SIZE);
+            Reseed(seed);
+
+            Utils::SecureZero(seed, SEED_SIZE);
+        }
+
+        void CtrDrbg::Reseed(const uint8_t p_seed[SEED_SIZE])
+        {
+            Update(p_seed);
+            m_reseedCounter = 1;
+            // Keystream derived from the previous state must not be served after a reseed
+            Utils::SecureZero(m_buffer, BUFFER_SIZE);
+            m_position = BUFFER_SIZE;
+        }
+
+        void CtrDrbg::Refill()
+        {
+            if (m_reseedCounter > RESEED_INTERVAL)
+                Reseed();
+
+            // One SP 800-90A generate request of BUFFER_SIZE bytes, counter blocks encrypted in a single pass
+            for (uint32_t offset = 0; offset < BUFFER_SIZE; offset += BLOCK_SIZE)
+            {
+                IncrementCounter();
+                memcpy(m_buffer + offset, m_v, BLOCK_SIZE);
+            }
+            m_cipher.EncryptECB(m_buffer, m_buffer, BUFFER_SIZE);
+
+            static const uint8_t zeroes[SEED_SIZE] = {0};
+            Update(zeroes);
+            ++m_reseedCounter;
+            m_position = 0;
+        }
+
+        void CtrDrbg::Generate(uint8_t* p_out, uint64_t p_size)
+        {
+            // A forked child holds a copy of the parent's key and buffer, serving it would repeat the parent's output
+            if (m_forkGeneration != UNTRACKED_GENERATION && m_forkGeneration != GetForkGeneration())
+                Reseed();
+
+            while (p_size)
+            {
+                if (m_position == BUFFER_SIZE)
+                    Refill();
+
+                const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(p_size, BUFFER_SIZE - m_position));
+                memcpy(p_out, m_buffer + m_position, count);
+                memset(m_buffer + m_position, 0, count);
+
+                m_position += count;
+                p_out += count;
+                p_size -= count;
+            }
+        }
+
+        CtrDrbg& CtrDrbg::GetThreadInstance()
+        {
+            static thread_local CtrDrbg instance;
+            return instance;
+        }
+
+        void CtrDrbg::Fill(uint8_t* p_out, uint64_t p_size)
+        {
+            GetThreadInstance().Generate(p_out, p_size);
+        }
+    }
+}
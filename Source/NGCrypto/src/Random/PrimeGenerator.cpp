@@ -0,0 +1,59 @@
+#include "NGCrypto/Random/PrimeGenerator.h"
+#include "NGCrypto/Random/CtrDrbg.h"
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+
+namespace Cryptography
+{
+    namespace Random
+    {
+        bool PrimeGenerator::Generate(Prime& p_prime, uint32_t p_bitCount, bool p_safe, const std::atomic<bool>* p_cancel,
+                                      uint32_t p_rounds, Utils::ThreadPool& p_pool)
+        {
+            if (p_bitCount < 32 || p_bitCount > MAX_BIT_COUNT)
+                throw std::invalid_argument("Prime size must be between 32 and 4096 bits");
+
+            std::atomic<bool> found(false);
+            std::mutex resultMutex;
+            const auto cancelled = [&found, p_cancel]
+            {
+                return found.load(std::memory_order_relaxed) || (p_cancel && p_cancel->load(std::memory_order_relaxed));
+            };
+
+            const uint64_t searchCount = std::max<uint32_t>(p_pool.GetThreadCount(), 1);
+            p_pool.ParallelFor(searchCount, 1, [&](uint64_t p_begin, uint64_t p_end)
+            {
+                for (uint64_t i = p_begin; i < p_end; ++i)
+                {
+                    Prime prime;
+                    if (!Prime::GeneratePrime(prime, p_bitCount, CtrDrbg::GetThreadInstance(), p_safe, p_rounds, cancelled))
+                        continue;
+
+                    // Several searches can finish together, the first one wins
+                    std::lock_guard<std::mutex> lock(resultMutex);
+                    if (!found.load(std::memory_order_relaxed))
+                    {
+                        p_prime = prime;
+                        found.store(true, std::memory_order_relaxed);
+                    }
+                }
+            });
+            return found.load();
+        }
+
+        PrimeGenerator::Prime PrimeGenerator::GeneratePrime(uint32_t p_bitCount, Utils::ThreadPool& p_pool)
+        {
+            Prime prime;
+            Generate(prime, p_bitCount, false, nullptr, DEFAULT_ROUNDS, p_pool);
+            return prime;
+        }
+
+        PrimeGenerator::Prime PrimeGenerator::GenerateSafePrime(uint32_t p_bitCount, Utils::ThreadPool& p_pool)
+        {
+            Prime prime;
+            Generate(prime, p_bitCount, true, nullptr, DEFAULT_ROUNDS, p_pool);
+            return prime;
+        }
+    }
+}
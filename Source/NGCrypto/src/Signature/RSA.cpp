@@ -0,0 +1,190 @@
+#include "NGCrypto/Signature/RSA.h"
+#include "NGCrypto/Hash/SHA256.h"
+#include "NGCrypto/Random/CtrDrbg.h"
+#include "NGCrypto/Random/PrimeGenerator.h"
+#include "NGCrypto/Utils/SecureArena.h"
+#include <stdexcept>
+
+namespace Cryptography
+{
+    namespace Signature
+    {
+        namespace
+        {
+            // DER encoded DigestInfo header for SHA-256, RFC 8017 section 9.2
+            const uint8_t SHA256_DIGEST_INFO[19] = {
+                0x30, 0x31, 0x30, 0x0D, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01,
+                0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20};
+
+            // EMSA-PKCS1-v1_5 with SHA-256: 00 01 FF .. FF 00 DigestInfo Hash
+            void EncodeSHA256(const uint8_t* p_message, uint64_t p_size, uint8_t* p_encoded, uint32_t p_encodedSize)
+            {
+                const uint32_t digestSize = sizeof(SHA256_DIGEST_INFO) + Hash::SHA256::OUTPUT_SIZE;
+                if (p_encodedSize < digestSize + 11)
+                    throw std::invalid_argument("RSA modulus too short for a SHA-256 signature");
+
+                const auto hash = Hash::SHA256().Hash(p_message, p_size);
+                const uint32_t padding = p_encodedSize - digestSize - 3;
+
+                p_encoded[0] = 0x00;
+                p_encoded[1] = 0x01;
+                memset(p_encoded + 2, 0xFF, padding);
+                p_encoded[2 + padding] = 0x00;
+                memcpy(p_encoded + 3 + padding, SHA256_DIGEST_INFO, sizeof(SHA256_DIGEST_INFO));
+                memcpy(p_encoded + 3 + padding + sizeof(SHA256_DIGEST_INFO), hash.data(), hash.size());
+            }
+        }
+
+        RSAPublicKey::RSAPublicKey(const Modulus& p_modulus, const Modulus& p_exponent) :
+            m_modulus(p_modulus),
+            m_exponent(p_exponent),
+            m_bitCount(static_cast<uint32_t>(p_modulus.FindHighestBit())),
+            m_context(p_modulus)
+        {
+            if (!p_exponent.IsOdd() || p_exponent.Compare(Modulus(3)) < 0)
+                throw std::invalid_argument("RSA public exponent must be odd and at least 3");
+        }
+
+        RSAPublicKey::Modulus RSAPublicKey::Encrypt(const Modulus& p_value) const
+        {
+            if (p_value.Compare(m_modulus) >= 0)
+                throw std::invalid_argument("RSA input must be below the modulus");
+
+            if (!(m_exponent == DEFAULT_EXPONENT))
+                return Modulus::PowMod(p_value, m_exponent, m_context);
+
+            // x ^ (2^16 + 1): 16 squarings and one multiplication instead of a windowed exponentiation
+            const Modulus x = m_context.ToMontgomery(p_value);
+            Modulus y = x;
+            for (int i = 0; i < 16; ++i)
+                y = m_context.Multiply(y, y);
+            y = m_context.Multiply(y, x);
+            return m_context.FromMontgomery(y);
+        }
+
+        bool RSAPublicKey::VerifySHA256(const uint8_t* p_message, uint64_t p_size, const uint8_t* p_signature) const
+        {
+            const uint32_t size = GetByteCount();
+            const Modulus signature = Modulus::FromBigEndian(p_signature, size);
+            if (signature.Compare(m_modulus) >= 0)
+                return false;
+
+            uint8_t expected[MAX_MODULUS_SIZE / 8];
+            uint8_t recovered[MAX_MODULUS_SIZE / 8];
+            EncodeSHA256(p_message, p_size, expected, size);
+            Encrypt(signature).ToBigEndian(recovered, size);
+            return memcmp(expected, recovered, size) == 0;
+        }
+
+        RSAPrivateKey::RSAPrivateKey(const Prime& p_p, const Prime& p_q, const Modulus& p_exponent) :
+            m_p(p_p.Compare(p_q) > 0 ? p_p : p_q),
+            m_q(p_p.Compare(p_q) > 0 ? p_q : p_p),
+            m_pContext(m_p),
+            m_qContext(m_q),
+            m_publicKey(Modulus(Modulus(m_p) * Modulus(m_q)), p_exponent)
+        {
+            if (m_p == m_q)
+                throw std::invalid_argument("RSA primes must differ");
+
+            // d mod (p - 1) is the inverse of e mod (p - 1), likewise for q
+            m_dP = p_exponent.ModInverse(m_p - 1);
+            m_dQ = p_exponent.ModInverse(m_q - 1);
+            if (m_dP.IsZero() || m_dQ.IsZero())
+                throw std::invalid_argument("RSA public exponent is not invertible modulo p - 1 and q - 1");
+
+            const Prime qInv = m_q.ModInverseConstantTime(m_p);
+            m_qInv = m_pContext.ToMontgomery(qInv);
+        }
+
+        RSAPrivateKey RSAPrivateKey::Generate(uint32_t p_bitCount, const Modulus& p_exponent, Utils::ThreadPool& p_pool)
+        {
+            if (p_bitCount % 2 || p_bitCount < 512 || p_bitCount > RSAPublicKey::MAX_MODULUS_SIZE)
+                throw std::invalid_argument("RSA modulus size must be even and between 512 and 4096 bits");
+
+            // e must be invertible modulo p - 1 and q - 1
+            const auto generate = [&]
+            {
+                while (true)
+                {
+                    const Random::PrimeGenerator::Prime prime = Random::PrimeGenerator::GeneratePrime(p_bitCount / 2, p_pool);
+                    if (!p_exponent.ModInverse(Modulus(prime - 1)).IsZero())
+                        return Prime(prime);
+                }
+            };
+
+            const Prime p = generate();
+            Prime q = generate();
+            // Fermat factoring needs |p - q| small, keep them apart in the top 100 bits (FIPS 186-5 A.1.3)
+            while ((p.Compare(q) > 0 ? p - q : q - p).FindHighestBit() <= p_bitCount / 2 - 100)
+                q = generate();
+
+            return RSAPrivateKey(p, q, p_exponent);
+        }
+
+        RSAPrivateKey::~RSAPrivateKey()
+        {
+            Prime* secrets[] = {&m_p, &m_q, &m_dP, &m_dQ, &m_qInv};
+            for (Prime* secret : secrets)
+                Utils::SecureZero(secret, sizeof(Prime));
+            // The contexts hold p and q and constants derived from them
+            Utils::SecureZero(&m_pContext, sizeof(m_pContext));
+            Utils::SecureZero(&m_qContext, sizeof(m_qContext));
+        }
+
+        RSAPrivateKey::Modulus RSAPrivateKey::Decrypt(const Modulus& p_value) const
+        {
+            const Modulus& modulus = m_publicKey.GetModulus();
+            if (p_value.Compare(modulus) >= 0)
+                throw std::invalid_argument("RSA input must be below the modulus");
+
+            // r must be invertible mod n, anything else would reveal a factor anyway
+            const MontgomeryContext<RSAPublicKey::MAX_MODULUS_SIZE>& context = m_publicKey.GetContext();
+            Modulus r;
+            Modulus rInverse;
+            do
+            {
+                r = Modulus::Random(Random::CtrDrbg::GetThreadInstance()) % modulus;
+                rInverse = r.ModInverse(modulus);
+            } while (rInverse.IsZero());
+
+            // Blinded input c * r^e mod n, a Montgomery product of one operand in Montgomery form is a plain product
+            const Modulus blinded = context.Multiply(context.ToMontgomery(p_value), m_publicKey.Encrypt(r));
+
+            // m1 = c ^ dP mod p, m2 = c ^ dQ mod q
+            Prime m1 = Prime::PowMod(Prime(blinded % m_p), m_dP, m_pContext);
+            Prime m2 = Prime::PowMod(Prime(blinded % m_q), m_dQ, m_qContext);
+
+            // h = qInv * (m1 - m2) mod p, m2 < q < p so one correction is enough
+            Prime difference = m1 - m2;
+            if (m1.Compare(m2) < 0)
+                difference += m_p;
+            Prime h = m_pContext.Multiply(m_qInv, difference);
+
+            // m * r = m2 + h * q < p * q, then m = (m * r) * r^-1 mod n
+            Modulus unblinded;
+            Modulus::MulAdd(unblinded, Modulus(h), Modulus(m_q), Modulus(m2));
+            const Modulus result = context.Multiply(context.ToMontgomery(unblinded), rInverse);
+
+            // The CRT intermediates reveal p or q and r would undo the blinding
+            Utils::SecureZero(&m1, sizeof(m1));
+            Utils::SecureZero(&m2, sizeof(m2));
+            Utils::SecureZero(&difference, sizeof(difference));
+            Utils::SecureZero(&h, sizeof(h));
+            Utils::SecureZero(&unblinded, sizeof(unblinded));
+            Utils::SecureZero(&r, sizeof(r));
+            Utils::SecureZero(&rInverse, sizeof(rInverse));
+
+            if (!(m_publicKey.Encrypt(result) == p_value))
+                throw std::runtime_error("RSA private operation failed its consistency check");
+            return result;
+        }
+
+        void RSAPrivateKey::SignSHA256(const uint8_t* p_message, uint64_t p_size, uint8_t* p_signature) const
+        {
+            const uint32_t size = m_publicKey.GetByteCount();
+            uint8_t encoded[RSAPublicKey::MAX_MODULUS_SIZE / 8];
+            EncodeSHA256(p_message, p_size, encoded, size);
+            Decrypt(Modulus::FromBigEndian(encoded, size)).ToBigEndian(p_signature, size);
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#include "NGCrypto/Utils/CpuFeatures.h"
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+namespace Cryptography
+{
+    namespace Utils
+    {
+        static void QueryCpuid(uint32_t p_leaf, uint32_t p_subLeaf, uint32_t p_registers[4])
+        {
+        #if defined(_MSC_VER)
+            int registers[4];
+            __cpuidex(registers, static_cast<int>(p_leaf), static_cast<int>(p_subLeaf));
+            for (int i = 0; i < 4; ++i)
+                p_registers[i] = static_cast<uint32_t>(registers[i]);
+        #elif defined(__x86_64__) || defined(__i386__)
+            __cpuid_count(p_leaf, p_subLeaf, p_registers[0], p_registers[1], p_registers[2], p_registers[3]);
+        #else
+            p_registers[0] = p_registers[1] = p_registers[2] = p_registers[3] = 0;
+        #endif
+        }
+
+        static uint64_t QueryEnabledStates()
+        {
+        #if defined(_MSC_VER)
+            return _xgetbv(0);
+        #elif defined(__x86_64__) || defined(__i386__)
+            uint32_t low, high;
+            __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+            return (static_cast<uint64_t>(high) << 32) | low;
+        #else
+            return 0;
+        #endif
+        }
+
+        static CpuFeatures DetectFeatures()
+        {
+            CpuFeatures features;
+
+            uint32_t registers[4];
+            QueryCpuid(0, 0, registers);
+            const uint32_t maxLeaf = registers[0];
+            if (maxLeaf < 1)
+                return features;
+
+            QueryCpuid(1, 0, registers);
+            features.sse41 = (registers[2] >> 19) & 1;
+            features.aesni = (registers[2] >> 25) & 1;
+            const bool osxsave = (registers[2] >> 27) & 1;
+
+            // XMM|YMM state for AVX, plus opmask and ZMM state for AVX-512
+            const uint64_t states = osxsave ? QueryEnabledStates() : 0;
+            const bool avxState = (states & 0x6) == 0x6;
+            const bool avx512State = (states & 0xE6) == 0xE6;
+
+            if (maxLeaf < 7)
+                return features;
+
+            QueryCpuid(7, 0, registers);
+            features.bmi2       = (registers[1] >> 8) & 1;
+            features.adx        = (registers[1] >> 19) & 1;
+            features.sha        = (registers[1] >> 29) & 1;
+            features.avx2       = avxState && ((registers[1] >> 5) & 1);
+            features.avx512f    = avx512State && ((registers[1] >> 16) & 1);
+            features.avx512ifma = features.avx512f && ((registers[1] >> 21) & 1);
+            return features;
+        }
+
+        const CpuFeatures& CpuFeatures::Get()
+        {
+            static const CpuFeatures features = DetectFeatures();
+            return features;
+        }
+    }
+}
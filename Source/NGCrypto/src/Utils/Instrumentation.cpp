@@ -0,0 +1,210 @@
+#include "NGCrypto/Utils/Instrumentation.h"
+#include "InstrumentationProbe.h"
+#include <mutex>
+#include <vector>
+
+namespace Cryptography
+{
+    namespace Utils
+    {
+        // A 16-byte AES call is about as long as one cycle counter read, hashes of small messages a few times longer
+        std::atomic<uint32_t>       g_samplePeriods[InstrumentationSnapshot::OPERATION_COUNT] = {256, 256, 16, 16, 1, 1};
+
+        namespace
+        {
+            const uint32_t OPERATION_COUNT = InstrumentationSnapshot::OPERATION_COUNT;
+            const uint32_t BUCKET_COUNT = OperationCounters::BUCKET_COUNT;
+
+            inline uint32_t GetBucket(uint64_t p_cycles)
+            {
+                if (p_cycles == 0)
+                    return 0;
+            #if defined(_MSC_VER)
+                unsigned long index;
+                _BitScanReverse64(&index, p_cycles);
+                const uint32_t bucket = index + 1;
+            #else
+                const uint32_t bucket = 64 - __builtin_clzll(p_cycles);
+            #endif
+                return bucket < BUCKET_COUNT ? bucket : BUCKET_COUNT - 1;
+            }
+
+            struct ThreadEntry
+            {
+                const ThreadProbes*     probes;
+                // Values at the last reset
+                InstrumentationSnapshot baseline;
+            };
+
+            struct Registry
+            {
+                std::mutex                  mutex;
+                std::vector<ThreadEntry>    threads;
+                // Counters of exited threads since the last reset
+                InstrumentationSnapshot     retired;
+            };
+
+            // Never destroyed, threads may exit after static destruction has started
+            Registry& GetRegistry()
+            {
+                static Registry* registry = new Registry();
+                return *registry;
+            }
+
+            // Counters of p_entry since the last reset, the registry mutex must be held
+            InstrumentationSnapshot Read(const ThreadEntry& p_entry)
+            {
+                InstrumentationSnapshot snapshot;
+                for (uint32_t i = 0; i < OPERATION_COUNT; ++i)
+                {
+                    const ProbeCounters& live = p_entry.probes->counters[i];
+                    const OperationCounters& base = p_entry.baseline.operations[i];
+                    OperationCounters& out = snapshot.operations[i];
+                    out.calls = live.calls.load(std::memory_order_relaxed) - base.calls;
+                    out.bytes = live.bytes.load(std::memory_order_relaxed) - base.bytes;
+                    out.sampledCalls = live.sampledCalls.load(std::memory_order_relaxed) - base.sampledCalls;
+                    out.cycles = live.cycles.load(std::memory_order_relaxed) - base.cycles;
+                    for (uint32_t j = 0; j < BUCKET_COUNT; ++j)
+                        out.latency[j] = live.latency[j].load(std::memory_order_relaxed) - base.latency[j];
+                }
+                return snapshot;
+            }
+
+            // Moves the counters of the exiting thread to the retired totals
+            struct ThreadExit
+            {
+                ~ThreadExit()
+                {
+                    Registry& registry = GetRegistry();
+                    std::lock_guard<std::mutex> lock(registry.mutex);
+                    for (size_t i = 0; i < registry.threads.size(); ++i)
+                    {
+                        if (registry.threads[i].probes == &t_probes)
+                        {
+                            registry.retired.Merge(Read(registry.threads[i]));
+                            registry.threads[i] = registry.threads.back();
+                            registry.threads.pop_back();
+                            break;
+                        }
+                    }
+                }
+            };
+        }
+
+        void RegisterThreadProbes()
+        {
+            thread_local ThreadExit threadExit;
+            (void)threadExit;
+
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.threads.push_back(ThreadEntry{&t_probes, InstrumentationSnapshot()});
+            t_probes.registered = true;
+        }
+
+        void RecordLatency(ProbeCounters& p_counters, uint64_t p_cycles)
+        {
+            AddToCounter(p_counters.sampledCalls, 1);
+            AddToCounter(p_counters.cycles, p_cycles);
+            AddToCounter(p_counters.latency[GetBucket(p_cycles)], 1);
+        }
+
+        void OperationCounters::Merge(const OperationCounters& p_other)
+        {
+            calls += p_other.calls;
+            bytes += p_other.bytes;
+            sampledCalls += p_other.sampledCalls;
+            cycles += p_other.cycles;
+            for (uint32_t i = 0; i < BUCKET_COUNT; ++i)
+                latency[i] += p_other.latency[i];
+        }
+
+        uint64_t OperationCounters::GetLatencyPercentile(double p_fraction) const
+        {
+            if (sampledCalls == 0)
+                return 0;
+
+            const double target = p_fraction * static_cast<double>(sampledCalls);
+            uint64_t seen = 0;
+            for (uint32_t i = 0; i < BUCKET_COUNT - 1; ++i)
+            {
+                seen += latency[i];
+                if (latency[i] && static_cast<double>(seen) >= target)
+                    return i == 0 ? 0 : (uint64_t(1) << i) - 1;
+            }
+            return UINT64_MAX;
+        }
+
+        void InstrumentationSnapshot::Merge(const InstrumentationSnapshot& p_other)
+        {
+            for (uint32_t i = 0; i < OPERATION_COUNT; ++i)
+                operations[i].Merge(p_other.operations[i]);
+        }
+
+        bool Instrumentation::IsEnabled()
+        {
+        #ifdef NG_CRYPTO_INSTRUMENTATION
+            return true;
+        #else
+            return false;
+        #endif
+        }
+
+        const char* Instrumentation::GetName(Operation p_operation)
+        {
+            switch (p_operation)
+            {
+            case Operation::AESEncrypt:     return "aes256/encrypt";
+            case Operation::AESDecrypt:     return "aes256/decrypt";
+            case Operation::SHA256:         return "sha256";
+            case Operation::HMACSHA256:     return "hmac-sha256";
+            case Operation::DHKeyPair:      return "dh/keypair";
+            case Operation::DHSharedKey:    return "dh/shared";
+            default:                        return "unknown";
+            }
+        }
+
+        void Instrumentation::SetSamplePeriod(Operation p_operation, uint32_t p_period)
+        {
+            g_samplePeriods[static_cast<uint32_t>(p_operation)].store(p_period ? p_period : 1, std::memory_order_relaxed);
+        }
+
+        uint32_t Instrumentation::GetSamplePeriod(Operation p_operation)
+        {
+            return g_samplePeriods[static_cast<uint32_t>(p_operation)].load(std::memory_order_relaxed);
+        }
+
+        InstrumentationSnapshot Instrumentation::Snapshot()
+        {
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+
+            InstrumentationSnapshot snapshot = registry.retired;
+            for (const ThreadEntry& thread : registry.threads)
+                snapshot.Merge(Read(thread));
+            return snapshot;
+        }
+
+        InstrumentationSnapshot Instrumentation::SnapshotThread()
+        {
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            for (const ThreadEntry& thread : registry.threads)
+            {
+                if (thread.probes == &t_probes)
+                    return Read(thread);
+            }
+            return InstrumentationSnapshot();
+        }
+
+        void Instrumentation::Reset()
+        {
+            Registry& registry = GetRegistry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+
+            registry.retired = InstrumentationSnapshot();
+            for (ThreadEntry& thread : registry.threads)
+                thread.baseline.Merge(Read(thread));
+        }
+    }
+}
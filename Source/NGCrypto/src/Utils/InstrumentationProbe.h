@@ -0,0 +1,89 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "NGCrypto/Utils/Instrumentation.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+namespace Cryptography
+{
+    namespace Utils
+    {
+        struct ProbeCounters
+        {
+            std::atomic<uint64_t>   calls;
+            std::atomic<uint64_t>   bytes;
+            std::atomic<uint64_t>   sampledCalls;
+            std::atomic<uint64_t>   cycles;
+            std::atomic<uint64_t>   latency[OperationCounters::BUCKET_COUNT];
+        };
+
+        // Zero initialized per thread, the thread joins the registry on its first probe
+        struct ThreadProbes
+        {
+            bool            registered;
+            uint32_t        countdown[InstrumentationSnapshot::OPERATION_COUNT];
+            ProbeCounters   counters[InstrumentationSnapshot::OPERATION_COUNT];
+        };
+
+        // Constant initialized, so access needs no per-call initialization check
+        inline thread_local ThreadProbes    t_probes;
+        extern std::atomic<uint32_t>        g_samplePeriods[InstrumentationSnapshot::OPERATION_COUNT];
+
+        void RegisterThreadProbes();
+        void RecordLatency(ProbeCounters& p_counters, uint64_t p_cycles);
+
+        // Only the owning thread writes, so a relaxed load and store replaces a locked add
+        inline void AddToCounter(std::atomic<uint64_t>& p_counter, uint64_t p_value)
+        {
+            p_counter.store(p_counter.load(std::memory_order_relaxed) + p_value, std::memory_order_relaxed);
+        }
+
+        // Counts one call of p_operation and times it when the thread's sample countdown runs out
+        class Probe
+        {
+        private:
+            ProbeCounters&  m_counters;
+            uint64_t        m_start;
+
+        public:
+            Probe(Operation p_operation, uint64_t p_bytes) :
+                m_counters(t_probes.counters[static_cast<uint32_t>(p_operation)]),
+                m_start(0)
+            {
+                ThreadProbes& probes = t_probes;
+                if (!probes.registered)
+                    RegisterThreadProbes();
+
+                AddToCounter(m_counters.calls, 1);
+                AddToCounter(m_counters.bytes, p_bytes);
+
+                uint32_t& countdown = probes.countdown[static_cast<uint32_t>(p_operation)];
+                if (countdown-- == 0)
+                {
+                    countdown = g_samplePeriods[static_cast<uint32_t>(p_operation)].load(std::memory_order_relaxed) - 1;
+                    m_start = __rdtsc();
+                }
+            }
+
+            ~Probe()
+            {
+                if (m_start)
+                    RecordLatency(m_counters, __rdtsc() - m_start);
+            }
+
+            Probe(const Probe&) = delete;
+            Probe& operator=(const Probe&) = delete;
+        };
+    }
+}
+
+#ifdef NG_CRYPTO_INSTRUMENTATION
+#define NG_CRYPTO_PROBE(p_operation, p_bytes) const Cryptography::Utils::Probe ngCryptoProbe(p_operation, p_bytes)
+#else
+#define NG_CRYPTO_PROBE(p_operation, p_bytes) ((void)0)
+#endif
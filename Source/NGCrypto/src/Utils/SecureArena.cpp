@@ -0,0 +1,96 @@
+#include "NGCrypto/Utils/SecureArena.h"
+#include <cstring>
+#include <new>
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace Cryptography
+{
+    namespace Utils
+    {
+        void SecureZero(void* p_data, uint64_t p_size)
+        {
+        #if defined(_WIN32)
+            SecureZeroMemory(p_data, static_cast<SIZE_T>(p_size));
+        #else
+            memset(p_data, 0, static_cast<size_t>(p_size));
+            // The compiler must assume the asm reads the buffer, so the memset is not a dead store
+            __asm__ __volatile__("" : : "r"(p_data) : "memory");
+        #endif
+        }
+
+        SecureArena::SecureArena(uint64_t p_capacity) : m_base(nullptr), m_capacity(0), m_top(0), m_locked(false)
+        {
+        #if defined(_WIN32)
+            SYSTEM_INFO info;
+            GetSystemInfo(&info);
+            const uint64_t pageSize = info.dwPageSize;
+        #else
+            const uint64_t pageSize = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        #endif
+            m_capacity = (p_capacity + pageSize - 1) / pageSize * pageSize;
+            if (m_capacity == 0)
+                m_capacity = pageSize;
+
+        #if defined(_WIN32)
+            m_base = static_cast<uint8_t*>(VirtualAlloc(nullptr, static_cast<SIZE_T>(m_capacity), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+            if (!m_base)
+                throw std::bad_alloc();
+            m_locked = VirtualLock(m_base, static_cast<SIZE_T>(m_capacity)) != 0;
+        #else
+            void* pages = mmap(nullptr, m_capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (pages == MAP_FAILED)
+                throw std::bad_alloc();
+            m_base = static_cast<uint8_t*>(pages);
+            m_locked = mlock(m_base, m_capacity) == 0;
+        #if defined(MADV_DONTDUMP)
+            madvise(m_base, m_capacity, MADV_DONTDUMP);
+        #endif
+        #endif
+        }
+
+        SecureArena::~SecureArena()
+        {
+            SecureZero(m_base, m_capacity);
+        #if defined(_WIN32)
+            if (m_locked)
+                VirtualUnlock(m_base, static_cast<SIZE_T>(m_capacity));
+            VirtualFree(m_base, 0, MEM_RELEASE);
+        #else
+            if (m_locked)
+                munlock(m_base, m_capacity);
+            munmap(m_base, m_capacity);
+        #endif
+        }
+
+        SecureArena& SecureArena::GetThreadInstance()
+        {
+            thread_local SecureArena arena;
+            return arena;
+        }
+
+        void* SecureArena::Allocate(uint64_t p_size, uint64_t p_alignment)
+        {
+            const uint64_t start = (m_top + p_alignment - 1) & ~(p_alignment - 1);
+            if (start < m_top || start > m_capacity || p_size > m_capacity - start)
+                throw std::bad_alloc();
+
+            m_top = start + p_size;
+            return m_base + start;
+        }
+
+        void SecureArena::Release(uint64_t p_marker)
+        {
+            if (p_marker >= m_top)
+                return;
+
+            SecureZero(m_base + p_marker, m_top - p_marker);
+            m_top = p_marker;
+        }
+    }
+}
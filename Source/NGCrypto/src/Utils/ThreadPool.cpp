@@ -0,0 +1,195 @@
+#include "NGCrypto/Utils/ThreadPool.h"
+#include <algorithm>
+#include <exception>
+
+namespace Cryptography
+{
+    namespace Utils
+    {
+        // Lets tasks submitted from a worker land on that worker's own deque
+        static thread_local ThreadPool* t_pool = nullptr;
+        static thread_local uint32_t    t_workerIndex = 0;
+
+        ThreadPool::ThreadPool(uint32_t p_threadCount)
+        {
+            const uint32_t threadCount = std::max<uint32_t>(p_threadCount, 1);
+
+            m_workers.reserve(threadCount);
+            for (uint32_t i = 0; i < threadCount; ++i)
+                m_workers.emplace_back(std::make_unique<Worker>());
+
+            // Every deque exists before the first thread can try to steal from it
+            for (uint32_t i = 0; i < threadCount; ++i)
+                m_workers[i]->thread = std::thread(&ThreadPool::WorkerLoop, this, i);
+        }
+
+        ThreadPool::~ThreadPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_sleepMutex);
+                m_stopping = true;
+            }
+            m_sleepCondition.notify_all();
+
+            for (auto& worker : m_workers)
+                worker->thread.join();
+        }
+
+        ThreadPool& ThreadPool::GetDefault()
+        {
+            static ThreadPool pool;
+            return pool;
+        }
+
+        void ThreadPool::Submit(Task p_task)
+        {
+            const uint32_t index = t_pool == this ? t_workerIndex
+                                                  : m_nextWorker.fetch_add(1, std::memory_order_relaxed) % GetThreadCount();
+            {
+                std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+                m_workers[index]->tasks.push_back(std::move(p_task));
+            }
+            m_pendingCount.fetch_add(1);
+
+            // Taking the sleep mutex orders the increment against a worker checking its wait predicate
+            {
+                std::lock_guard<std::mutex> lock(m_sleepMutex);
+            }
+            m_sleepCondition.notify_one();
+        }
+
+        bool ThreadPool::TryPop(uint32_t p_index, Task& p_task)
+        {
+            Worker& worker = *m_workers[p_index];
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (worker.tasks.empty())
+                return false;
+
+            p_task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+            m_pendingCount.fetch_sub(1);
+            return true;
+        }
+
+        bool ThreadPool::TrySteal(uint32_t p_thief, Task& p_task)
+        {
+            const uint32_t count = GetThreadCount();
+            for (uint32_t offset = 1; offset <= count; ++offset)
+            {
+                Worker& victim = *m_workers[(p_thief + offset) % count];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (victim.tasks.empty())
+                    continue;
+
+                p_task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                m_pendingCount.fetch_sub(1);
+                return true;
+            }
+            return false;
+        }
+
+        bool ThreadPool::RunPendingTask()
+        {
+            Task task;
+            const bool found = t_pool == this ? (TryPop(t_workerIndex, task) || TrySteal(t_workerIndex, task))
+                                              : TrySteal(m_nextWorker.load(std::memory_order_relaxed) % GetThreadCount(), task);
+            if (found)
+                task();
+            return found;
+        }
+
+        void ThreadPool::WorkerLoop(uint32_t p_index)
+        {
+            t_pool = this;
+            t_workerIndex = p_index;
+
+            Task task;
+            for (;;)
+            {
+                if (TryPop(p_index, task) || TrySteal(p_index, task))
+                {
+                    task();
+                    task = nullptr;
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(m_sleepMutex);
+                if (m_stopping && m_pendingCount == 0)
+                    return;
+                m_sleepCondition.wait(lock, [this] { return m_pendingCount > 0 || m_stopping; });
+            }
+        }
+
+        void ThreadPool::ParallelFor(uint64_t p_count, uint64_t p_grainSize, const std::function<void(uint64_t, uint64_t)>& p_body)
+        {
+            const uint64_t grainSize = std::max<uint64_t>(p_grainSize, 1);
+            const uint64_t chunkCount = (p_count + grainSize - 1) / grainSize;
+            if (chunkCount <= 1)
+            {
+                if (p_count)
+                    p_body(0, p_count);
+                return;
+            }
+
+            // Shared with the chunks so the last one can signal after the caller stops waiting
+            struct Completion
+            {
+                std::atomic<uint64_t>   remaining;
+                std::mutex              mutex;
+                std::condition_variable condition;
+                std::exception_ptr      error;
+            };
+            auto completion = std::make_shared<Completion>();
+            completion->remaining = chunkCount;
+
+            // The first chunk is kept for the calling thread
+            for (uint64_t chunk = 1; chunk < chunkCount; ++chunk)
+            {
+                const uint64_t begin = chunk * grainSize;
+                const uint64_t end = std::min(begin + grainSize, p_count);
+                Submit([completion, &p_body, begin, end]
+                {
+                    try
+                    {
+                        p_body(begin, end);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(completion->mutex);
+                        if (!completion->error)
+                            completion->error = std::current_exception();
+                    }
+
+                    if (completion->remaining.fetch_sub(1) == 1)
+                    {
+                        std::lock_guard<std::mutex> lock(completion->mutex);
+                        completion->condition.notify_all();
+                    }
+                });
+            }
+
+            try
+            {
+                p_body(0, std::min(grainSize, p_count));
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(completion->mutex);
+                if (!completion->error)
+                    completion->error = std::current_exception();
+            }
+            completion->remaining.fetch_sub(1);
+
+            // Help with queued work rather than block while chunks are still waiting for a thread
+            while (completion->remaining > 0 && RunPendingTask())
+                ;
+
+            std::unique_lock<std::mutex> lock(completion->mutex);
+            completion->condition.wait(lock, [&completion] { return completion->remaining == 0; });
+
+            if (completion->error)
+                std::rethrow_exception(completion->error);
+        }
+    }
+}
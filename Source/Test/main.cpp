@@ -1,27 +1,65 @@
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <future>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "NGCrypto.h"
 
+#if !defined(_WIN32)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 using namespace Cryptography;
 
 void PrintByteArray(const unsigned char* p_array, uint32_t p_size);
-void DiffieHellmanTest();
-void SHA256_TestVectors();
-void HMAC_SHA256_TestVectors();
-void AES256_ECB_TestVectors();
-void CombinedUsageExample();
+bool CheckOutput(const unsigned char* p_output, const char* p_expected, uint32_t p_size);
+void HexToBytes(const char* p_hex, uint8_t* p_out, uint32_t p_size);
+uint32_t SHA256_TestVectors();
+uint32_t HMAC_SHA256_TestVectors();
+uint32_t AES256_ECB_TestVectors();
+uint32_t X25519_TestVectors();
+uint32_t RSA_SHA256_TestVectors();
+uint32_t NGMP_TestVectors();
+uint32_t PrimeGenerator_Test();
+uint32_t DiffieHellmanTest();
+uint32_t JobScheduler_Test();
+uint32_t CombinedUsageExample();
+#if !defined(_WIN32)
+uint32_t CtrDrbg_ForkTest();
+#endif
 
 int main()
 {
-    CombinedUsageExample();
-
-    // DiffieHellmanTest();
-    // SHA256_TestVectors();
-    // HMAC_SHA256_TestVectors();
-    // AES256_ECB_TestVectors();
-
+    uint32_t failures = 0;
+    failures += SHA256_TestVectors();
+    failures += HMAC_SHA256_TestVectors();
+    failures += AES256_ECB_TestVectors();
+    failures += X25519_TestVectors();
+    failures += RSA_SHA256_TestVectors();
+    failures += NGMP_TestVectors();
+    failures += PrimeGenerator_Test();
+    failures += DiffieHellmanTest();
+    failures += JobScheduler_Test();
+    failures += CombinedUsageExample();
+#if !defined(_WIN32)
+    failures += CtrDrbg_ForkTest();
+#endif
+
+    std::cout << std::dec << "\n\n" << failures << " check(s) failed\n";
+
+#if defined(_WIN32)
+    // Keeps the console window open
     std::cin.get();
+#endif
+    return failures == 0 ? 0 : 1;
 }
 
 void PrintByteArray(const unsigned char* p_array, uint32_t p_size)
@@ -35,41 +73,60 @@ void PrintByteArray(const unsigned char* p_array, uint32_t p_size)
      std::cout << '\n';
 }
 
-void DiffieHellmanTest()
+// Prints p_output and compares it with p_expected, hex digits in any grouping
+bool CheckOutput(const unsigned char* p_output, const char* p_expected, uint32_t p_size)
 {
-    using namespace KeyExchange;
-    std::cout << "\n\n===== Diffie Hellman Key Exchange =====\n\n";
-    NGMP<PRIVATE_KEY_SIZE>   private1;
-    NGMP<PUBLIC_KEY_SIZE>    public1;
+    PrintByteArray(p_output, p_size);
 
-    NGMP<PRIVATE_KEY_SIZE>   private2;
-    NGMP<PUBLIC_KEY_SIZE>    public2;
+    std::string expected;
+    for (const char* digit = p_expected; *digit; ++digit)
+    {
+        if (isxdigit(static_cast<unsigned char>(*digit)))
+            expected += static_cast<char>(tolower(static_cast<unsigned char>(*digit)));
+    }
 
-    DiffieHellman::GenerateKeyPair(private1, public1);
-    std::cout << "Client1 Private Key: \n" << private1 << "\n\n";
-    std::cout << "Client1 Public  Key: \n" << public1 << "\n\n";
+    std::ostringstream actual;
+    for (uint32_t i = 0; i < p_size; ++i)
+        actual << std::hex << std::setfill('0') << std::setw(2) << +p_output[i];
 
-    std::cout << '\n';
+    const bool match = actual.str() == expected;
+    std::cout << (match ? "\tPASS\n" : "\tFAIL\n");
+    return match;
+}
 
-    DiffieHellman::GenerateKeyPair(private2, public2);
-    std::cout << "Client2 Private Key: \n" << private2 << "\n\n";
-    std::cout << "Client2 Public  Key: \n" << public2 << "\n\n";
+// Reads p_size bytes written as contiguous hex digits
+void HexToBytes(const char* p_hex, uint8_t* p_out, uint32_t p_size)
+{
+    for (uint32_t i = 0; i < p_size; ++i)
+        p_out[i] = static_cast<uint8_t>(std::stoul(std::string(p_hex + 2 * i, 2), nullptr, 16));
+}
 
-    std::cout << '\n';
+// Parses a hex literal, every literal passed in is valid
+template<unsigned int BitCount>
+NGMP<BitCount> ParseHex(const char* p_hex)
+{
+    NGMP<BitCount> value;
+    NGMP<BitCount>::FromHex(p_hex, strlen(p_hex), value);
+    return value;
+}
 
-    const auto shared1 = DiffieHellman::GenerateSharedKey(public2, private1);
-    std::cout << "Client1 Shared  Key: \n" << shared1 << "\n\n";
-    const auto shared2 = DiffieHellman::GenerateSharedKey(public1, private2);
-    std::cout << "Client2 Shared  Key: \n" << shared2 << "\n\n";
+// Prints a value as BitCount / 8 big-endian bytes and compares it with p_expected
+template<unsigned int BitCount>
+bool CheckNumber(const NGMP<BitCount>& p_value, const char* p_expected)
+{
+    uint8_t bytes[BitCount / 8];
+    p_value.ToBigEndian(bytes, sizeof(bytes));
+    return CheckOutput(bytes, p_expected, sizeof(bytes));
 }
 
 // Test Vectors from NIST
-void SHA256_TestVectors()
+uint32_t SHA256_TestVectors()
 {
     using namespace Hash;
 
     const unsigned char* input;
     std::array<uint8_t, SHA256::OUTPUT_SIZE> output{};
+    uint32_t failures = 0;
 
     std::cout << "\n\n===== SHA 256 =====\n\n";
     std::cout << "Test Vectors:\n\n";
@@ -84,7 +141,7 @@ void SHA256_TestVectors()
 
         output = SHA256().Hash(input, 3);
         std::cout << "\tOutput :\n\t";
-        PrintByteArray(output.data(), SHA256::OUTPUT_SIZE);
+        failures += CheckOutput(output.data(), "ba7816bf 8f01cfea 414140de 5dae2223 b00361a3 96177a9c b410ff61 f20015ad", SHA256::OUTPUT_SIZE) ? 0 : 1;
     }
 
     std::cout << "\n\t------------------------------\n";
@@ -99,7 +156,7 @@ void SHA256_TestVectors()
 
         output = SHA256().Hash(input, 0);
         std::cout << "\tOutput :\n\t";
-        PrintByteArray(output.data(), SHA256::OUTPUT_SIZE);
+        failures += CheckOutput(output.data(), "e3b0c442 98fc1c14 9afbf4c8 996fb924 27ae41e4 649b934c a495991b 7852b855", SHA256::OUTPUT_SIZE) ? 0 : 1;
     }
 
     std::cout << "\n\t------------------------------\n";
@@ -114,7 +171,7 @@ void SHA256_TestVectors()
 
         output = SHA256().Hash(input, 56);
         std::cout << "\tOutput :\n\t";
-        PrintByteArray(output.data(), SHA256::OUTPUT_SIZE);
+        failures += CheckOutput(output.data(), "248d6a61 d20638b8 e5c02693 0c3e6039 a33ce459 64ff2167 f6ecedd4 19db06c1", SHA256::OUTPUT_SIZE) ? 0 : 1;
     }
 
     std::cout << "\n\t------------------------------\n";
@@ -129,7 +186,7 @@ void SHA256_TestVectors()
 
         output = SHA256().Hash(input, 112);
         std::cout << "\tOutput :\n\t";
-        PrintByteArray(output.data(), SHA256::OUTPUT_SIZE);
+        failures += CheckOutput(output.data(), "cf5b16a7 78af8380 036ce59e 7b049237 0b249b11 e8f07a51 afac4503 7afee9d1", SHA256::OUTPUT_SIZE) ? 0 : 1;
     }
 
     std::cout << "\n\t------------------------------\n";
@@ -147,20 +204,21 @@ void SHA256_TestVectors()
         output = SHA256().Hash(input, 1000000);
         delete[] input;
         std::cout << "\tOutput :\n\t";
-        PrintByteArray(output.data(), SHA256::OUTPUT_SIZE);
+        failures += CheckOutput(output.data(), "cdc76e5c 9914fb92 81a1c7e2 84d73e67 f1809a48 a497200e 046d39cc c7112cd0", SHA256::OUTPUT_SIZE) ? 0 : 1;
     }
-    
-    
+
+    return failures;
 }
 
 // Test Vectors from RFC4231
-void HMAC_SHA256_TestVectors()
+uint32_t HMAC_SHA256_TestVectors()
 {
     using namespace Hash;
 
     const unsigned char* key;
     const unsigned char* data;
     std::array<uint8_t, SHA256::OUTPUT_SIZE> output{};
+    uint32_t failures = 0;
 
     std::cout << "\n\n===== HMAC - SHA 256 =====\n\n";
     std::cout << "Test Vectors:\n\n";
@@ -181,7 +239,7 @@ void HMAC_SHA256_TestVectors()
         output = HMAC::HMAC_SHA256(key, 20, data, 8);
         delete[] key;
         std::cout << "\tOutput :\n\t";
-        PrintByteArray(output.data(), SHA256::OUTPUT_SIZE);
+        failures += CheckOutput(output.data(), "b0344c61 d8db3853 5ca8afce af0bf12b 881dc200 c9833da7 26e9376c 2e32cff7", SHA256::OUTPUT_SIZE) ? 0 : 1;
     }
     
     std::cout << "\n\t------------------------------\n";
@@ -200,7 +258,7 @@ void HMAC_SHA256_TestVectors()
 
         output = HMAC::HMAC_SHA256(key, 4, data, 28);
         std::cout << "\tOutput :\n\t";
-        PrintByteArray(output.data(), SHA256::OUTPUT_SIZE);
+        failures += CheckOutput(output.data(), "5bdcc146 bf60754e 6a042426 089575c7 5a003f08 9d273983 9dec58b9 64ec3843", SHA256::OUTPUT_SIZE) ? 0 : 1;
     }
 
     std::cout << "\n\t------------------------------\n";
@@ -223,7 +281,7 @@ void HMAC_SHA256_TestVectors()
         delete[] key;
         delete[] data;
         std::cout << "\tOutput :\n\t";
-        PrintByteArray(output.data(), SHA256::OUTPUT_SIZE);
+        failures += CheckOutput(output.data(), "773ea91e 36800e46 854db8eb d09181a7 2959098b 3ef8c122 d9635514 ced565fe", SHA256::OUTPUT_SIZE) ? 0 : 1;
     }
 
     std::cout << "\n\t------------------------------\n";
@@ -252,7 +310,7 @@ void HMAC_SHA256_TestVectors()
         delete[] key;
         delete[] data;
         std::cout << "\tOutput :\n\t";
-        PrintByteArray(output.data(), SHA256::OUTPUT_SIZE);
+        failures += CheckOutput(output.data(), "82558a38 9a443c0e a4cc8198 99f2083a 85f0faa3 e578f807 7a2e3ff4 6729665b", SHA256::OUTPUT_SIZE) ? 0 : 1;
     }
 
     std::cout << "\n\t------------------------------\n";
@@ -273,7 +331,7 @@ void HMAC_SHA256_TestVectors()
         output = HMAC::HMAC_SHA256(key, 20, data, 20);
         delete[] key;
         std::cout << "\tOutput :\n\t";
-        PrintByteArray(output.data(), SHA256::OUTPUT_SIZE / 2);
+        failures += CheckOutput(output.data(), "a3b61674 73100ee0 6e0c796c 2955552b", SHA256::OUTPUT_SIZE / 2) ? 0 : 1;
     }
 
     std::cout << "\n\t------------------------------\n";
@@ -294,7 +352,7 @@ void HMAC_SHA256_TestVectors()
         output = HMAC::HMAC_SHA256(key, 131, data, 54);
         delete[] key;
         std::cout << "\tOutput :\n\t";
-        PrintByteArray(output.data(), SHA256::OUTPUT_SIZE);
+        failures += CheckOutput(output.data(), "60e43159 1ee0b67f 0d8a26aa cbf5b77f 8e0bc621 3728c514 0546040f 0ee37f54", SHA256::OUTPUT_SIZE) ? 0 : 1;
     }
 
     std::cout << "\n\t------------------------------\n";
@@ -315,18 +373,21 @@ void HMAC_SHA256_TestVectors()
         output = HMAC::HMAC_SHA256(key, 131, data, 152);
         delete[] key;
         std::cout << "\tOutput :\n\t";
-        PrintByteArray(output.data(), SHA256::OUTPUT_SIZE);
+        failures += CheckOutput(output.data(), "9b09ffa7 1b942fcb 27635fbc d5b0e944 bfdc6364 4f071393 8a7f5153 5c3a35e2", SHA256::OUTPUT_SIZE) ? 0 : 1;
     }
+
+    return failures;
 }
 
 // Tests from NIST SP 800-38A
-void AES256_ECB_TestVectors()
+uint32_t AES256_ECB_TestVectors()
 {
     using namespace Encryption;
 
     const unsigned char* key;
     const unsigned char* data;
     std::vector<uint8_t> output{};
+    uint32_t failures = 0;
 
     std::cout << "\n\n===== AES 256 - ECB Mode =====\n\n";
     std::cout << "Test Vectors:\n\n";
@@ -360,16 +421,16 @@ void AES256_ECB_TestVectors()
         std::cout << "\tExpected Output :\n";
         std::cout << "\tf3eed1bd b5d2a03c 064b5a7e 3db181f8 591ccb10 d410ed26 dc5ba74a 31362870 b6ed21b9 9ca6f4f9 f153e7b1 beafed1d 23304b7a 39f9f3ff 067d8d8f 9e24ecc7 \n\n";
         
-        output.reserve(64);
+        output.resize(64);
         aes.EncryptECB(data, output.data(), 64);
         delete[] data;
         std::cout << "\tOutput :\n\t";
-        PrintByteArray(output.data(), 64);
+        failures += CheckOutput(output.data(), "f3eed1bd b5d2a03c 064b5a7e 3db181f8 591ccb10 d410ed26 dc5ba74a 31362870 b6ed21b9 9ca6f4f9 f153e7b1 beafed1d 23304b7a 39f9f3ff 067d8d8f 9e24ecc7", 64) ? 0 : 1;
 
         aes.DecryptECB(output.data(), output.data(), 64);
 
         std::cout << "\n\n\tDecrypted Output :\n\t";
-        PrintByteArray(output.data(), 64);
+        failures += CheckOutput(output.data(), "6bc1bee2 2e409f96 e93d7e11 7393172a ae2d8a57 1e03ac9c 9eb76fac 45af8e51 30c81c46 a35ce411 e5fbc119 1a0a52ef f69f2445 df4f9b17 ad2b417b e66c3710", 64) ? 0 : 1;
     }
     
     std::cout << "\n\t------------------------------\n";
@@ -401,12 +462,12 @@ void AES256_ECB_TestVectors()
         aes.EncryptECB(data, output.data(), 16);
         delete[] data;
         std::cout << "\tOutput :\n\t";
-        PrintByteArray(output.data(), 16);
+        failures += CheckOutput(output.data(), "f3eed1bd b5d2a03c 064b5a7e 3db181f8", 16) ? 0 : 1;
 
         aes.DecryptECB(output.data(), output.data(), 16);
 
         std::cout << "\n\n\tDecrypted Output :\n\t";
-        PrintByteArray(output.data(), 16);
+        failures += CheckOutput(output.data(), "6bc1bee2 2e409f96 e93d7e11 7393172a", 16) ? 0 : 1;
     }
     
     std::cout << "\n\t------------------------------\n";
@@ -439,12 +500,12 @@ void AES256_ECB_TestVectors()
         aes.EncryptECB(data, output.data(), 16);
         delete[] data;
         std::cout << "\tOutput :\n\t";
-        PrintByteArray(output.data(), 16);
+        failures += CheckOutput(output.data(), "591ccb10 d410ed26 dc5ba74a 31362870", 16) ? 0 : 1;
 
         aes.DecryptECB(output.data(), output.data(), 16);
 
         std::cout << "\n\n\tDecrypted Output :\n\t";
-        PrintByteArray(output.data(), 16);
+        failures += CheckOutput(output.data(), "ae2d8a57 1e03ac9c 9eb76fac 45af8e51", 16) ? 0 : 1;
     }
     
     std::cout << "\n\t------------------------------\n";
@@ -477,12 +538,12 @@ void AES256_ECB_TestVectors()
         aes.EncryptECB(data, output.data(), 16);
         delete[] data;
         std::cout << "\tOutput :\n\t";
-        PrintByteArray(output.data(), 16);
+        failures += CheckOutput(output.data(), "b6ed21b9 9ca6f4f9 f153e7b1 beafed1d", 16) ? 0 : 1;
 
         aes.DecryptECB(output.data(), output.data(), 16);
 
         std::cout << "\n\n\tDecrypted Output :\n\t";
-        PrintByteArray(output.data(), 16);
+        failures += CheckOutput(output.data(), "30c81c46 a35ce411 e5fbc119 1a0a52ef", 16) ? 0 : 1;
     }
 
     std::cout << "\n\t------------------------------\n";
@@ -515,25 +576,972 @@ void AES256_ECB_TestVectors()
         aes.EncryptECB(data, output.data(), 16);
         delete[] data;
         std::cout << "\tOutput :\n\t";
-        PrintByteArray(output.data(), 16);
+        failures += CheckOutput(output.data(), "23304b7a 39f9f3ff 067d8d8f 9e24ecc7", 16) ? 0 : 1;
 
         aes.DecryptECB(output.data(), output.data(), 16);
 
         std::cout << "\n\n\tDecrypted Output :\n\t";
-        PrintByteArray(output.data(), 16);
+        failures += CheckOutput(output.data(), "f69f2445 df4f9b17 ad2b417b e66c3710", 16) ? 0 : 1;
     }
-    
+
+    return failures;
 }
 
-void CombinedUsageExample()
+// Test Vectors from RFC7748
+uint32_t X25519_TestVectors()
+{
+    using namespace KeyExchange;
+
+    uint8_t scalar[X25519::KEY_SIZE];
+    uint8_t point[X25519::KEY_SIZE];
+    uint8_t output[X25519::KEY_SIZE];
+    uint32_t failures = 0;
+
+    std::cout << "\n\n===== X25519 =====\n\n";
+    std::cout << "Test Vectors:\n\n";
+
+    std::cout << "Test 1:\n\n";
+    {
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t Scalar : a546e36bf0527c9d3b16154b82465edd62144c0ac1fc5a18506a2244ba449ac4\n\n";
+        std::cout << "\t\t u : e6db6867583030db3594c1a424b15f7c726624ec26b3353b10a903a6d0ab1c4c\n\n";
+        HexToBytes("a546e36bf0527c9d3b16154b82465edd62144c0ac1fc5a18506a2244ba449ac4", scalar, X25519::KEY_SIZE);
+        HexToBytes("e6db6867583030db3594c1a424b15f7c726624ec26b3353b10a903a6d0ab1c4c", point, X25519::KEY_SIZE);
+
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\tc3da55379de9c6908e94ea4df28d084f32eccf03491c71f754b4075577a28552\n\n";
+
+        X25519::ScalarMult(output, scalar, point);
+        std::cout << "\tOutput :\n\t";
+        failures += CheckOutput(output, "c3da55379de9c6908e94ea4df28d084f32eccf03491c71f754b4075577a28552", X25519::KEY_SIZE) ? 0 : 1;
+    }
+
+    std::cout << "\n\t------------------------------\n";
+
+    std::cout << "\nTest 2:\n\n";
+    {
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t Scalar : 4b66e9d4d1b4673c5ad22691957d6af5c11b6421e0ea01d42ca4169e7918ba0d\n\n";
+        std::cout << "\t\t u : e5210f12786811d3f4b7959d0538ae2c31dbe7106fc03c3efc4cd549c715a493\n\n";
+        HexToBytes("4b66e9d4d1b4673c5ad22691957d6af5c11b6421e0ea01d42ca4169e7918ba0d", scalar, X25519::KEY_SIZE);
+        HexToBytes("e5210f12786811d3f4b7959d0538ae2c31dbe7106fc03c3efc4cd549c715a493", point, X25519::KEY_SIZE);
+
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\t95cbde9476e8907d7aade45cb4b873f88b595a68799fa152e6f8f7647aac7957\n\n";
+
+        X25519::ScalarMult(output, scalar, point);
+        std::cout << "\tOutput :\n\t";
+        failures += CheckOutput(output, "95cbde9476e8907d7aade45cb4b873f88b595a68799fa152e6f8f7647aac7957", X25519::KEY_SIZE) ? 0 : 1;
+    }
+
+    std::cout << "\n\t------------------------------\n";
+
+    std::cout << "\nTest 3:\n\n";
+    {
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t k = u = 9, then k, u = X25519(k, u), k\n\n";
+
+        // k and u both start as the base point
+        uint8_t k[X25519::KEY_SIZE] = {9};
+        uint8_t u[X25519::KEY_SIZE] = {9};
+        for (uint32_t iteration = 1; iteration <= 1000; ++iteration)
+        {
+            X25519::ScalarMult(output, k, u);
+            memcpy(u, k, X25519::KEY_SIZE);
+            memcpy(k, output, X25519::KEY_SIZE);
+
+            if (iteration == 1)
+            {
+                std::cout << "\tExpected Output after 1 iteration :\n";
+                std::cout << "\t422c8e7a6227d7bca1350b3e2bb7279f7897b87bb6854b783c60e80311ae3079\n\n";
+                std::cout << "\tOutput :\n\t";
+                failures += CheckOutput(k, "422c8e7a6227d7bca1350b3e2bb7279f7897b87bb6854b783c60e80311ae3079", X25519::KEY_SIZE) ? 0 : 1;
+            }
+        }
+
+        std::cout << "\n\tExpected Output after 1,000 iterations :\n";
+        std::cout << "\t684cf59ba83309552800ef566f2f4d3c1c3887c49360e3875f2eb94d99532c51\n\n";
+        std::cout << "\tOutput :\n\t";
+        failures += CheckOutput(k, "684cf59ba83309552800ef566f2f4d3c1c3887c49360e3875f2eb94d99532c51", X25519::KEY_SIZE) ? 0 : 1;
+    }
+
+    std::cout << "\n\t------------------------------\n";
+
+    std::cout << "\nTest 4:\n\n";
+    {
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t Peer Key : 0000000000000000000000000000000000000000000000000000000000000000 (low order point)\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\tshared key rejected\n\n";
+
+        X25519::PrivateKey privateKey;
+        X25519::PublicKey publicKey;
+        X25519::GenerateKeyPair(privateKey, publicKey);
+
+        const X25519::PublicKey lowOrderPoint{};
+        bool rejected = false;
+        try
+        {
+            X25519::GenerateSharedKey(lowOrderPoint, privateKey);
+        }
+        catch (const std::invalid_argument&)
+        {
+            rejected = true;
+        }
+
+        X25519::SharedKey sharedKey;
+        KeyStatus status = KeyStatus::Success;
+        X25519::GenerateSharedKeys(&lowOrderPoint, &privateKey, &sharedKey, &status, 1);
+        rejected = rejected && status == KeyStatus::InvalidPublicKey;
+
+        std::cout << "\tOutput :\n\t" << (rejected ? "shared key rejected" : "shared key accepted") << '\n';
+        std::cout << (rejected ? "\tPASS\n" : "\tFAIL\n");
+        failures += rejected ? 0 : 1;
+    }
+
+    return failures;
+}
+
+// RSASSA-PKCS1-v1_5 signatures are deterministic, expected output from OpenSSL with the same key
+uint32_t RSA_SHA256_TestVectors()
+{
+    using namespace Signature;
+
+    const char* P = "fa2b19c2cb994711e64abe25d9b4e5c17801b1e1a82775d2db01ec247df3e70536760e2a61fbca4d3bba07445b82bafc32b788a0287deb24b7514cfaf056c845";
+    const char* Q = "f129425729565c2b4d8a5e3a4cb624203d9f5ccd67f6fd006176c4006c90d0531317547fe112fa30728f944e5708ef21f48ea05d912059426b827284e576322d";
+    const char* SIGNATURE = "963556e1262e6591fa8ed5e13b9753fbbfd6617ae22d5bd1968c147df74d0a28c6192ac3b2b91a99413d9414bad15f6b6c7353ffa17024663dad8d1b79de8abb227dd96a537e280846f0d66d2f009d935a9f4e5c6d0ddecf770007cf04d9b523ddcd4e2927624536192a6d1da48de44f9cc0312a1bd1af11d8bb06611f145e97";
+
+    RSAPrivateKey::Prime p;
+    RSAPrivateKey::Prime q;
+    RSAPrivateKey::Prime::FromHex(P, strlen(P), p);
+    RSAPrivateKey::Prime::FromHex(Q, strlen(Q), q);
+    const RSAPrivateKey privateKey(p, q);
+    const RSAPublicKey& publicKey = privateKey.GetPublicKey();
+
+    const uint32_t size = publicKey.GetByteCount();
+    std::vector<uint8_t> signature(size);
+    uint32_t failures = 0;
+
+    std::cout << "\n\n===== RSA - SHA 256 =====\n\n";
+    std::cout << "Test Vectors:\n\n";
+
+    std::cout << "Test 1:\n\n";
+    {
+        std::cout << "\tInputs :\n";
+        const unsigned char* message = reinterpret_cast<const unsigned char*>("The quick brown fox jumps over the lazy dog");
+        std::cout << "\t\t Key : 1024-bit modulus, e = 65537\n\n";
+        std::cout << "\t\t Data : \"" << message << "\"\n\n";
+
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\t" << SIGNATURE << "\n\n";
+
+        privateKey.SignSHA256(message, 43, signature.data());
+        std::cout << "\tOutput :\n\t";
+        failures += CheckOutput(signature.data(), SIGNATURE, size) ? 0 : 1;
+
+        const bool valid = publicKey.VerifySHA256(message, 43, signature.data());
+        std::cout << "\n\tSignature " << (valid ? "verified" : "rejected") << '\n';
+        std::cout << (valid ? "\tPASS\n" : "\tFAIL\n");
+        failures += valid ? 0 : 1;
+    }
+
+    std::cout << "\n\t------------------------------\n";
+
+    std::cout << "\nTest 2:\n\n";
+    {
+        std::cout << "\tInputs :\n";
+        const unsigned char* message = reinterpret_cast<const unsigned char*>("The quick brown fox jumps over the lazy cog");
+        std::cout << "\t\t Data : \"" << message << "\" with the signature of Test 1\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\tsignature rejected\n\n";
+
+        const bool rejected = !publicKey.VerifySHA256(message, 43, signature.data());
+        std::cout << "\tOutput :\n\t" << (rejected ? "signature rejected" : "signature verified") << '\n';
+        std::cout << (rejected ? "\tPASS\n" : "\tFAIL\n");
+        failures += rejected ? 0 : 1;
+    }
+
+    return failures;
+}
+
+// Expected values computed with Python integers
+uint32_t NGMP_TestVectors()
+{
+    using Number = NGMP<256>;
+    using Wide = NGMP<512>;
+
+    const char* ZERO = "0000000000000000000000000000000000000000000000000000000000000000";
+    const char* ONE = "0000000000000000000000000000000000000000000000000000000000000001";
+    const char* MAX = "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff";
+    // 2^255 - 19, prime
+    const char* P = "7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffed";
+    const char* P_MINUS_ONE = "7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffec";
+    const char* X = "0123456789abcdeffedcba98765432100f1e2d3c4b5a69788796a5b4c3d2e1f0";
+    const char* X_INVERSE = "3c3f67c7ae358e94ce23534ea9245a672c45b45194123bc2637a2c24c767edb7";
+    const char* TWO_INVERSE = "3ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff7";
+    // (2^127 - 1) * (2^61 - 1)
+    const char* COMPOSITE = "00000000000000000fffffffffffffff7fffffffffffffffe000000000000001";
+    const char* MERSENNE_61 = "1fffffffffffffff";
+
+    const Number p = ParseHex<256>(P);
+    const Number x = ParseHex<256>(X);
+    const Number composite = ParseHex<256>(COMPOSITE);
+    const Number mersenne61 = ParseHex<256>(MERSENNE_61);
+    uint32_t failures = 0;
+
+    std::cout << "\n\n===== NGMP =====\n\n";
+    std::cout << "Test Vectors:\n\n";
+
+    std::cout << "Test 1:\n\n";
+    {
+        // The first quotient digit estimate is one too large, so Knuth D takes its add-back branch.
+        // The divisor's top limb has its top bit set, so no normalization shift happens either
+        const char* DIVIDEND = "7fffffffffffffff800000000000000000000000000000000000000000000000";
+        const char* DIVISOR = "0000000000000000800000000000000000000000000000000000000000000001";
+        const char* QUOTIENT = "000000000000000000000000000000000000000000000000fffffffffffffffe";
+        const char* REMAINDER = "00000000000000007fffffffffffffffffffffffffffffff0000000000000002";
+        const Number dividend = ParseHex<256>(DIVIDEND);
+        const Number divisor = ParseHex<256>(DIVISOR);
+
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t Dividend : " << DIVIDEND << "\n";
+        std::cout << "\t\t Divisor : " << DIVISOR << "\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\t" << QUOTIENT << "\n";
+        std::cout << "\t" << REMAINDER << "\n\n";
+
+        std::cout << "\tOutput :\n\t";
+        failures += CheckNumber(dividend / divisor, QUOTIENT) ? 0 : 1;
+        std::cout << '\t';
+        failures += CheckNumber(dividend % divisor, REMAINDER) ? 0 : 1;
+    }
+
+    std::cout << "\n\t------------------------------\n";
+
+    std::cout << "\nTest 2:\n\n";
+    {
+        // (2^256 - 1) * (2^256 + 1) = 2^512 - 1, every divisor bit is set
+        const Wide dividend = ParseHex<512>(std::string(128, 'f').c_str());
+        const Wide divisor = ParseHex<512>(MAX);
+        const char* QUOTIENT = "0000000000000000000000000000000000000000000000000000000000000001"
+                               "0000000000000000000000000000000000000000000000000000000000000001";
+
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t Dividend : 2^512 - 1\n";
+        std::cout << "\t\t Divisor : 2^256 - 1\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\t2^256 + 1, remainder 0\n\n";
+
+        Wide remainder;
+        const Wide quotient = dividend.Divide(divisor, remainder);
+        std::cout << "\tOutput :\n\t";
+        failures += CheckNumber(quotient, QUOTIENT) ? 0 : 1;
+        const bool exact = remainder == 0;
+        std::cout << "\tremainder " << (exact ? "0" : "not 0") << '\n' << (exact ? "\tPASS\n" : "\tFAIL\n");
+        failures += exact ? 0 : 1;
+    }
+
+    std::cout << "\n\t------------------------------\n";
+
+    std::cout << "\nTest 3:\n\n";
+    {
+        // mu = floor(2^512 / m) needs an extra limb for m = 2^255 + 1 and is 2^256 + 1 for m = 2^256 - 1,
+        // the largest input Reduce accepts is 2^512 - 1
+        const Wide largest = ParseHex<512>(std::string(128, 'f').c_str());
+        const BarrettContext<256> low(ParseHex<256>("8000000000000000000000000000000000000000000000000000000000000001"));
+        const BarrettContext<256> high(ParseHex<256>(MAX));
+        const Number highMinusOne = high.GetModulus() - 1;
+
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t (2^512 - 1) mod (2^255 + 1)\n";
+        std::cout << "\t\t (2^512 - 1) mod (2^256 - 1)\n";
+        std::cout << "\t\t (2^255 + 1) mod (2^255 + 1)\n";
+        std::cout << "\t\t (2^256 - 2) * (2^256 - 2) mod (2^256 - 1)\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\t3, 0, 0, 1\n\n";
+
+        std::cout << "\tOutput :\n\t";
+        failures += CheckNumber(low.Reduce(largest), "0000000000000000000000000000000000000000000000000000000000000003") ? 0 : 1;
+        std::cout << '\t';
+        failures += CheckNumber(high.Reduce(largest), ZERO) ? 0 : 1;
+        std::cout << '\t';
+        failures += CheckNumber(low.Reduce(low.GetModulus()), ZERO) ? 0 : 1;
+        std::cout << '\t';
+        failures += CheckNumber(Number::MulMod(highMinusOne, highMinusOne, high), ONE) ? 0 : 1;
+    }
+
+    std::cout << "\n\t------------------------------\n";
+
+    std::cout << "\nTest 4:\n\n";
+    {
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t p : " << P << "\n";
+        std::cout << "\t\t x : " << X << "\n";
+        std::cout << "\t\t n : " << COMPOSITE << "\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\tModInverse 2, p - 1, 0 mod p and 3 mod 2^255\n";
+        std::cout << "\tModInverseConstantTime x, 1 mod p and 2^61 - 1 mod n (not invertible)\n";
+        std::cout << "\tBatchModInverse {2, x, p - 1} mod p, then {2, 0, x} rejected\n\n";
+
+        std::cout << "\tOutput :\n\t";
+        failures += CheckNumber(Number(2).ModInverse(p), TWO_INVERSE) ? 0 : 1;
+        std::cout << '\t';
+        failures += CheckNumber((p - 1).ModInverse(p), P_MINUS_ONE) ? 0 : 1;
+        std::cout << '\t';
+        failures += CheckNumber(Number(0).ModInverse(p), ZERO) ? 0 : 1;
+        std::cout << '\t';
+        failures += CheckNumber(Number(3).ModInverse(ParseHex<256>("8000000000000000000000000000000000000000000000000000000000000000")),
+                                "2aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab") ? 0 : 1;
+        std::cout << '\t';
+        failures += CheckNumber(x.ModInverseConstantTime(p), X_INVERSE) ? 0 : 1;
+        std::cout << '\t';
+        failures += CheckNumber(Number(1).ModInverseConstantTime(p), ONE) ? 0 : 1;
+        std::cout << '\t';
+        failures += CheckNumber(mersenne61.ModInverseConstantTime(composite), ZERO) ? 0 : 1;
+
+        const BarrettContext<256> context(p);
+        Number values[3] = { Number(2), x, p - 1 };
+        const bool inverted = Number::BatchModInverse(values, 3, context);
+        std::cout << "\tbatch " << (inverted ? "inverted" : "rejected") << '\n' << (inverted ? "\tPASS\n" : "\tFAIL\n");
+        failures += inverted ? 0 : 1;
+        std::cout << '\t';
+        failures += CheckNumber(values[0], TWO_INVERSE) ? 0 : 1;
+        std::cout << '\t';
+        failures += CheckNumber(values[1], X_INVERSE) ? 0 : 1;
+        std::cout << '\t';
+        failures += CheckNumber(values[2], P_MINUS_ONE) ? 0 : 1;
+
+        Number singular[3] = { Number(2), Number(0), x };
+        const bool rejected = !Number::BatchModInverse(singular, 3, context) && singular[0] == 2 && singular[1] == 0 && singular[2] == x;
+        std::cout << "\tbatch with 0 " << (rejected ? "rejected, values untouched" : "accepted") << '\n' << (rejected ? "\tPASS\n" : "\tFAIL\n");
+        failures += rejected ? 0 : 1;
+    }
+
+    std::cout << "\n\t------------------------------\n";
+
+    std::cout << "\nTest 5:\n\n";
+    {
+        const int expected[] = { -1, 1, -1, 0, 0, -1, 1 };
+        const int output[] = { Number(2).Jacobi(p), (p - 1).Jacobi(p), x.Jacobi(p), Number(0).Jacobi(p),
+                               mersenne61.Jacobi(composite), x.Jacobi(composite), Number(3).Jacobi(composite) };
+
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t (2 / p), (p - 1 / p), (x / p), (0 / p), (2^61 - 1 / n), (x / n), (3 / n)\n\n";
+        std::cout << "\tExpected Output :\n\t";
+        for (int symbol : expected)
+            std::cout << std::dec << symbol << ' ';
+        std::cout << "\n\n\tOutput :\n\t";
+        bool match = true;
+        for (uint32_t i = 0; i < 7; ++i)
+        {
+            std::cout << output[i] << ' ';
+            match = match && output[i] == expected[i];
+        }
+        std::cout << '\n' << (match ? "\tPASS\n" : "\tFAIL\n");
+        failures += match ? 0 : 1;
+    }
+
+    std::cout << "\n\t------------------------------\n";
+
+    std::cout << "\nTest 6:\n\n";
+    {
+        // x behind 8 leading zero bytes, longer than the container
+        uint8_t encoded[40] = {};
+        HexToBytes(X, encoded + 8, 32);
+        const NGMPView<256> view(encoded, sizeof(encoded));
+
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t Data : 00000000 00000000 " << X << "\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\t" << X << "\n";
+        std::cout << "\t00" << X << "\n";
+        std::cout << "\tview equal to x, below x + 1, limb 0 8796a5b4c3d2e1f0, highest bit 249\n";
+        std::cout << "\tstd::overflow_error for a non zero leading byte and for a 31 byte output\n\n";
+
+        std::cout << "\tOutput :\n\t";
+        failures += CheckNumber(Number::FromBigEndian(encoded, sizeof(encoded)), X) ? 0 : 1;
+        uint8_t padded[33];
+        x.ToBigEndian(padded, sizeof(padded));
+        std::cout << '\t';
+        failures += CheckOutput(padded, (std::string("00") + X).c_str(), sizeof(padded)) ? 0 : 1;
+        std::cout << '\t';
+        failures += CheckNumber(view.ToNGMP(), X) ? 0 : 1;
+
+        const bool viewMatch = view.Compare(x) == 0 && view.Compare(x + 1) < 0 && view == x &&
+                               view.GetLimb(0) == 0x8796a5b4c3d2e1f0 && view.FindHighestBit() == 249;
+        std::cout << "\tview " << (viewMatch ? "matches" : "differs") << '\n' << (viewMatch ? "\tPASS\n" : "\tFAIL\n");
+        failures += viewMatch ? 0 : 1;
+
+        uint32_t overflows = 0;
+        encoded[0] = 1;
+        try { Number::FromBigEndian(encoded, sizeof(encoded)); }
+        catch (const std::overflow_error&) { ++overflows; }
+        try { x.ToBigEndian(padded, 31); }
+        catch (const std::overflow_error&) { ++overflows; }
+        std::cout << '\t' << overflows << " overflow(s) reported\n" << (overflows == 2 ? "\tPASS\n" : "\tFAIL\n");
+        failures += overflows == 2 ? 0 : 1;
+    }
+
+    std::cout << "\n\t------------------------------\n";
+
+    std::cout << "\nTest 7:\n\n";
+    {
+        const char* MAX_DECIMAL = "115792089237316195423570985008687907853269984665640564039457584007913129639935";
+        const char* X_HEX = "123456789ABCDEFFEDCBA98765432100F1E2D3C4B5A69788796A5B4C3D2E1F0";
+
+        // 10^616 and 10^616 - 1 take the recursive ToDecimal path, with zero chunks in the middle
+        NGMP<2048> power(1);
+        for (uint32_t i = 0; i < 616; ++i)
+            power *= NGMP<2048>(10);
+        const std::string powerDecimal = "1" + std::string(616, '0');
+        const std::string nines(616, '9');
+
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t x, 0, 2^256 - 1, 10^616, 10^616 - 1\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\t" << X_HEX << "\n";
+        std::cout << "\t0\n";
+        std::cout << "\t" << MAX_DECIMAL << "\n";
+        std::cout << "\t1 followed by 616 zeros, 616 nines, each parsed back to the same value\n";
+        std::cout << "\tparse failures for 2^256, \"12g\" and \"\"\n\n";
+
+        char hex[Number::MAX_HEX_DIGITS + 1];
+        char decimal[NGMP<2048>::MAX_DECIMAL_DIGITS + 1];
+        std::cout << "\tOutput :\n";
+        bool match = x.ToHex(hex, sizeof(hex)) == 63 && std::string(hex) == X_HEX;
+        std::cout << '\t' << hex << '\n' << (match ? "\tPASS\n" : "\tFAIL\n");
+        failures += match ? 0 : 1;
+
+        match = Number(0).ToHex(hex, sizeof(hex)) == 1 && std::string(hex) == "0" &&
+                Number(0).ToDecimal(decimal, sizeof(decimal)) == 1 && std::string(decimal) == "0";
+        std::cout << '\t' << hex << ' ' << decimal << '\n' << (match ? "\tPASS\n" : "\tFAIL\n");
+        failures += match ? 0 : 1;
+
+        Number max;
+        match = ParseHex<256>(MAX).ToDecimal(decimal, sizeof(decimal)) == 78 && std::string(decimal) == MAX_DECIMAL &&
+                Number::FromDecimal(decimal, 78, max) && max == ParseHex<256>(MAX);
+        std::cout << '\t' << decimal << '\n' << (match ? "\tPASS\n" : "\tFAIL\n");
+        failures += match ? 0 : 1;
+
+        NGMP<2048> parsed;
+        match = power.ToDecimal(decimal, sizeof(decimal)) == 617 && decimal == powerDecimal &&
+                NGMP<2048>::FromDecimal(decimal, 617, parsed) && parsed == power;
+        std::cout << '\t' << std::string(decimal).substr(0, 32) << "... (" << std::dec << strlen(decimal) << " digits)\n" << (match ? "\tPASS\n" : "\tFAIL\n");
+        failures += match ? 0 : 1;
+
+        const NGMP<2048> powerMinusOne = power - 1;
+        match = powerMinusOne.ToDecimal(decimal, sizeof(decimal)) == 616 && decimal == nines &&
+                NGMP<2048>::FromDecimal(decimal, 616, parsed) && parsed == powerMinusOne;
+        std::cout << '\t' << std::string(decimal).substr(0, 32) << "... (" << std::dec << strlen(decimal) << " digits)\n" << (match ? "\tPASS\n" : "\tFAIL\n");
+        failures += match ? 0 : 1;
+
+        // 2^256 does not fit, out keeps its value on failure
+        Number untouched(7);
+        const char* TOO_LARGE = "115792089237316195423570985008687907853269984665640564039457584007913129639936";
+        match = !Number::FromDecimal(TOO_LARGE, strlen(TOO_LARGE), untouched) && !Number::FromHex("12g", 3, untouched) &&
+                !Number::FromHex("", 0, untouched) && untouched == 7 &&
+                Number::FromHex("00aBcD", 6, untouched) && untouched == 0xabcd;
+        std::cout << "\tparse failures " << (match ? "reported" : "missed") << '\n' << (match ? "\tPASS\n" : "\tFAIL\n");
+        failures += match ? 0 : 1;
+    }
+
+    return failures;
+}
+
+// Primality of the fixed values is from Python, the generated primes are checked for their shape and primality
+uint32_t PrimeGenerator_Test()
+{
+    using Prime = Random::PrimeGenerator::Prime;
+    using Number = NGMP<1024>;
+
+    Random::CtrDrbg& drbg = Random::CtrDrbg::GetThreadInstance();
+    uint32_t failures = 0;
+
+    std::cout << "\n\n===== Prime Generation =====\n\n";
+    std::cout << "Test Vectors:\n\n";
+
+    std::cout << "Test 1:\n\n";
+    {
+        // 65521 is the largest prime trial division covers, the others go through Miller-Rabin
+        const std::string MERSENNE_521 = "1" + std::string(130, 'f');
+        const char* PRIMES[] = { "2", "3", "fff1", "1fffffffffffffff", "7fffffffffffffffffffffffffffffff",
+                                 "7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffed",
+                                 MERSENNE_521.c_str() };
+        // 0, 1, 4, 65537 * 65539, (2^61 - 1)^2 and (2^61 - 1) * (2^127 - 1)
+        const char* COMPOSITES[] = { "0", "1", "4", "100040003", "3ffffffffffffffc000000000000001",
+                                     "fffffffffffffff7fffffffffffffffe000000000000001" };
+        // Carmichael numbers, the last two are (6k + 1)(12k + 1)(18k + 1) with every factor above the trial division limit
+        const char* CARMICHAELS[] = { "231", "451", "6c1", "9a1", "b05", "19c9", "22cf",
+                                      "51054959703164f2e1", "51000000000013956c000000019409bd4000000ada9e6b99" };
+
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t 2, 3, 65521, 2^61 - 1, 2^127 - 1, 2^255 - 19, 2^521 - 1\n";
+        std::cout << "\t\t 0, 1, 4, 65537 * 65539, (2^61 - 1)^2, (2^61 - 1) * (2^127 - 1)\n";
+        std::cout << "\t\t 561, 1105, 1729, 2465, 2821, 6601, 8911, 6291991 * 12583981 * 18875971,\n";
+        std::cout << "\t\t (6k + 1)(12k + 1)(18k + 1) with k = 2^60 + 330\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\t7 primes, 0 of the 6 composites and 0 of the 9 Carmichael numbers accepted\n\n";
+
+        uint32_t primes = 0;
+        uint32_t composites = 0;
+        uint32_t carmichaels = 0;
+        Number value;
+        for (const char* hex : PRIMES)
+            primes += Number::FromHex(hex, strlen(hex), value) && value.IsProbablePrime(Random::PrimeGenerator::DEFAULT_ROUNDS, drbg);
+        for (const char* hex : COMPOSITES)
+            composites += !Number::FromHex(hex, strlen(hex), value) || value.IsProbablePrime(Random::PrimeGenerator::DEFAULT_ROUNDS, drbg);
+        for (const char* hex : CARMICHAELS)
+            carmichaels += !Number::FromHex(hex, strlen(hex), value) || value.IsProbablePrime(Random::PrimeGenerator::DEFAULT_ROUNDS, drbg);
+
+        const bool ok = primes == 7 && composites == 0 && carmichaels == 0;
+        std::cout << "\tOutput :\n\t" << std::dec << primes << " primes, " << composites << " of the 6 composites and "
+                  << carmichaels << " of the 9 Carmichael numbers accepted\n" << (ok ? "\tPASS\n" : "\tFAIL\n");
+        failures += ok ? 0 : 1;
+    }
+
+    std::cout << "\n\t------------------------------\n";
+
+    std::cout << "\nTest 2:\n\n";
+    {
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t Generate at 256 and 512 bits, plain and safe\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\tthe requested bit length, top two bits set, prime, and (p - 1) / 2 prime for safe primes\n\n";
+
+        std::cout << "\tOutput :\n";
+        for (bool safe : { false, true })
+        {
+            for (uint32_t bitCount : { 256u, 512u })
+            {
+                Prime prime;
+                bool ok = Random::PrimeGenerator::Generate(prime, bitCount, safe) && prime.FindHighestBit() == bitCount &&
+                          prime.TestBit(bitCount - 1) && prime.TestBit(bitCount - 2) &&
+                          prime.IsProbablePrime(Random::PrimeGenerator::DEFAULT_ROUNDS, drbg);
+                if (safe)
+                    ok = ok && ((prime - 1) / Prime(2)).IsProbablePrime(Random::PrimeGenerator::DEFAULT_ROUNDS, drbg);
+
+                std::cout << '\t' << std::dec << bitCount << "-bit " << (safe ? "safe prime" : "prime") << ' '
+                          << (ok ? "valid" : "invalid") << '\n' << (ok ? "\tPASS\n" : "\tFAIL\n");
+                failures += ok ? 0 : 1;
+            }
+        }
+    }
+
+    std::cout << "\n\t------------------------------\n";
+
+    std::cout << "\nTest 3:\n\n";
+    {
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t Generate with the cancel flag already set, then with 31 bits\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\tfalse with the prime untouched, then std::invalid_argument\n\n";
+
+        const std::atomic<bool> cancel(true);
+        Prime prime(7);
+        bool ok = !Random::PrimeGenerator::Generate(prime, 512, true, &cancel) && prime == 7;
+        try
+        {
+            Random::PrimeGenerator::Generate(prime, 31, false);
+            ok = false;
+        }
+        catch (const std::invalid_argument&)
+        {
+        }
+
+        std::cout << "\tOutput :\n\t" << (ok ? "cancelled, then rejected" : "unexpected result") << '\n' << (ok ? "\tPASS\n" : "\tFAIL\n");
+        failures += ok ? 0 : 1;
+    }
+
+    return failures;
+}
+
+// Private keys are random, so every path is checked against an independent computation of the same value
+uint32_t DiffieHellmanTest()
+{
+    using namespace KeyExchange;
+
+    // Lane groups of 8 with a partial last one; the 2048-bit group runs on the vector kernels where
+    // the CPU has them, the 4096-bit group is too large for them and always takes the scalar path
+    const uint64_t COUNT = 11;
+    const DiffieHellmanGroup* groups[] = { &DiffieHellmanGroup::GetDefault(), &DiffieHellmanGroup::Get(GroupId::Modp4096) };
+    uint32_t failures = 0;
+
+    std::cout << "\n\n===== Diffie Hellman =====\n\n";
+    std::cout << "Cross Checks:\n\n";
+
+    std::cout << "Test 1:\n\n";
+    {
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t " << COUNT << " key pairs from GenerateKeyPairs in the 2048 and 4096-bit groups\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\tpublic key i = generator ^ private key i mod prime, by Barrett PowMod\n\n";
+
+        std::cout << "\tOutput :\n";
+        for (const DiffieHellmanGroup* group : groups)
+        {
+            PrivateKey privateKeys[COUNT];
+            PublicKey publicKeys[COUNT];
+            DiffieHellman::GenerateKeyPairs(privateKeys, publicKeys, COUNT, *group);
+
+            uint64_t matches = 0;
+            for (uint64_t i = 0; i < COUNT; ++i)
+                matches += publicKeys[i] == PublicKey::PowMod(PublicKey(group->GetGenerator()), privateKeys[i], group->GetContext());
+
+            std::cout << '\t' << std::dec << group->GetBitCount() << "-bit: " << matches << " of " << COUNT << " match\n";
+            std::cout << (matches == COUNT ? "\tPASS\n" : "\tFAIL\n");
+            failures += matches == COUNT ? 0 : 1;
+        }
+    }
+
+    std::cout << "\n\t------------------------------\n";
+
+    std::cout << "\nTest 2:\n\n";
+    {
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t " << COUNT << " peer keys for GenerateSharedKeys, item 3 replaced by prime - 1\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\tevery other item equal to GenerateSharedKey, item 3 InvalidPublicKey and zeroed\n\n";
+
+        std::cout << "\tOutput :\n";
+        for (const DiffieHellmanGroup* group : groups)
+        {
+            PrivateKey privateKeys[COUNT];
+            PrivateKey peerPrivateKeys[COUNT];
+            PublicKey peerPublicKeys[COUNT];
+            DiffieHellman::GenerateKeyPairs(peerPrivateKeys, peerPublicKeys, COUNT, *group);
+            for (uint64_t i = 0; i < COUNT; ++i)
+                privateKeys[i] = PrivateKey::Random(Random::CtrDrbg::GetThreadInstance());
+            peerPublicKeys[3] = group->GetPrime() - 1;
+
+            SharedKey sharedKeys[COUNT];
+            KeyStatus status[COUNT];
+            DiffieHellman::GenerateSharedKeys(peerPublicKeys, privateKeys, sharedKeys, status, COUNT, *group);
+
+            uint64_t matches = 0;
+            for (uint64_t i = 0; i < COUNT; ++i)
+            {
+                if (i == 3)
+                    matches += status[i] == KeyStatus::InvalidPublicKey && sharedKeys[i] == 0;
+                else
+                    matches += status[i] == KeyStatus::Success &&
+                               sharedKeys[i] == DiffieHellman::GenerateSharedKey(peerPublicKeys[i], privateKeys[i], *group);
+            }
+
+            std::cout << '\t' << std::dec << group->GetBitCount() << "-bit: " << matches << " of " << COUNT << " match\n";
+            std::cout << (matches == COUNT ? "\tPASS\n" : "\tFAIL\n");
+            failures += matches == COUNT ? 0 : 1;
+        }
+    }
+
+    std::cout << "\n\t------------------------------\n";
+
+    std::cout << "\nTest 3:\n\n";
+    {
+        // A low watermark of 0 never asks for a refill after the first one, so the third Acquire must fall back
+        KeyPairPool pool(0, 2, 2);
+        const DiffieHellmanGroup& group = DiffieHellmanGroup::GetDefault();
+
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t KeyPairPool with watermarks 0 and 2, filled, then 3 Acquire calls\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\t2 hits, 1 miss, every pair consistent\n\n";
+
+        for (uint32_t wait = 0; pool.GetStatistics().available < 2 && wait < 10000; ++wait)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        uint32_t consistent = 0;
+        for (uint32_t i = 0; i < 3; ++i)
+        {
+            PrivateKey privateKey;
+            PublicKey publicKey;
+            pool.Acquire(privateKey, publicKey);
+            consistent += publicKey == group.PowGenerator(privateKey);
+        }
+
+        const KeyPairPool::Statistics statistics = pool.GetStatistics();
+        const bool ok = statistics.hits == 2 && statistics.misses == 1 && consistent == 3;
+        std::cout << "\tOutput :\n\t" << std::dec << statistics.hits << " hits, " << statistics.misses << " miss, "
+                  << consistent << " of 3 pairs consistent\n" << (ok ? "\tPASS\n" : "\tFAIL\n");
+        failures += ok ? 0 : 1;
+    }
+
+    std::cout << "\n\t------------------------------\n";
+
+    std::cout << "\nTest 4:\n\n";
+    {
+        const DiffieHellmanGroup& group = DiffieHellmanGroup::GetDefault();
+        PrivateKey peerPrivateKey;
+        PublicKey peerPublicKey;
+        DiffieHellman::GenerateKeyPair(peerPrivateKey, peerPublicKey, group);
+
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t StartKeyPair and StartSharedKey stepped 7 windows at a time\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\t" << std::dec << PRIVATE_KEY_SIZE / 4 << " windows, results equal to PowMod and GenerateSharedKey\n\n";
+
+        PrivateKey privateKey;
+        ExponentiationTask keyPair = DiffieHellman::StartKeyPair(privateKey, group);
+        ExponentiationTask shared = DiffieHellman::StartSharedKey(peerPublicKey, privateKey, group);
+        const uint64_t windows = keyPair.GetRemainingWindows();
+        // Step(0) must not make progress
+        bool ok = !keyPair.Step(0) && keyPair.GetRemainingWindows() == windows;
+
+        uint64_t steps = 0;
+        while (!keyPair.Step(7))
+            ++steps;
+        while (!shared.Step(7))
+            ;
+        ok = ok && windows == PRIVATE_KEY_SIZE / 4 && steps + 1 == (windows + 6) / 7 && keyPair.GetRemainingWindows() == 0 &&
+             keyPair.GetResult() == PublicKey::PowMod(PublicKey(group.GetGenerator()), privateKey, group.GetContext()) &&
+             shared.GetResult() == DiffieHellman::GenerateSharedKey(peerPublicKey, privateKey, group);
+
+        std::cout << "\tOutput :\n\t" << windows << " windows in " << steps + 1 << " steps, results "
+                  << (ok ? "match" : "differ") << '\n' << (ok ? "\tPASS\n" : "\tFAIL\n");
+        failures += ok ? 0 : 1;
+    }
+
+    std::cout << "\n\t------------------------------\n";
+
+    std::cout << "\nTest 5:\n\n";
+    {
+        const DiffieHellmanGroup& group = DiffieHellmanGroup::GetDefault();
+        const PublicKey& prime = group.GetPrime();
+        // -2 is a quadratic non-residue modulo the MODP primes, which are 7 mod 8
+        const PublicKey nonResidue = prime - 2;
+        const PublicKey rejectedKeys[] = { PublicKey(0), PublicKey(1), prime - 1, nonResidue };
+        PrivateKey privateKey;
+        PublicKey publicKey;
+        DiffieHellman::GenerateKeyPair(privateKey, publicKey, group);
+
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t 0, 1, prime - 1, prime - 2 and a generated public key, Fast and Full modes\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\tonly the generated key accepted, GenerateSharedKey and DecodePublicKey reject prime - 2\n\n";
+
+        bool ok = nonResidue.Jacobi(prime) == -1 &&
+                  DiffieHellman::ValidatePublicKey(publicKey, group, ValidationMode::Fast) &&
+                  DiffieHellman::ValidatePublicKey(publicKey, group, ValidationMode::Full);
+        for (const PublicKey& key : rejectedKeys)
+        {
+            ok = ok && !DiffieHellman::ValidatePublicKey(key, group, ValidationMode::Fast) &&
+                 !DiffieHellman::ValidatePublicKey(key, group, ValidationMode::Full);
+        }
+
+        try
+        {
+            DiffieHellman::GenerateSharedKey(nonResidue, privateKey, group);
+            ok = false;
+        }
+        catch (const std::invalid_argument&)
+        {
+        }
+
+        std::vector<uint8_t> wire(group.GetByteCount());
+        DiffieHellman::EncodeKey(nonResidue, wire.data(), group);
+        PublicKey decoded(7);
+        ok = ok && !DiffieHellman::DecodePublicKey(wire.data(), decoded, group) && decoded == 7;
+
+        std::cout << "\tOutput :\n\t" << (ok ? "only the generated key accepted" : "unexpected result") << '\n'
+                  << (ok ? "\tPASS\n" : "\tFAIL\n");
+        failures += ok ? 0 : 1;
+    }
+
+    return failures;
+}
+
+// Every job is checked against the single-call API on the same input
+uint32_t JobScheduler_Test()
+{
+    using namespace Async;
+
+    // Spread over every size class of both the AES and the hash kernels, with partial last blocks
+    const uint64_t SIZES[] = { 5, 16, 31, 48, 64, 100, 128, 250, 256, 512, 777, 1024, 1040, 2048, 4100 };
+    const uint64_t SIZE_COUNT = sizeof(SIZES) / sizeof(SIZES[0]);
+    // AES reads whole blocks, the largest size rounded up to 4112 bytes, from offsets up to 7
+    const uint64_t DATA_SIZE = 4120;
+    // HMAC keys below and above the SHA-256 block size
+    const uint64_t KEY_LENGTHS[] = { 13, 32, 70 };
+    const uint32_t PRODUCERS = 4;
+    const uint32_t JOBS_PER_PRODUCER = 96;
+
+    struct Entry
+    {
+        Job                     job;
+        std::vector<uint8_t>    output;
+        std::vector<uint8_t>    expected;
+        bool                    useFuture;
+    };
+
+    std::vector<uint8_t> data(DATA_SIZE);
+    for (uint64_t i = 0; i < DATA_SIZE; ++i)
+        data[i] = static_cast<uint8_t>(i * 31 + 7);
+    unsigned char key[32];
+    HexToBytes("603deb1015ca71be2b73aef0857d77811f352c073b6108d72d9810a30914dff4", key, 32);
+    const Encryption::AES cipher(key);
+    Encryption::AES reference(key);
+
+    // Inputs start at different offsets so no two jobs of a batch see the same bytes
+    auto buildWorkload = [&](std::vector<Entry>& p_entries)
+    {
+        p_entries.resize(PRODUCERS * JOBS_PER_PRODUCER);
+        for (uint32_t i = 0; i < p_entries.size(); ++i)
+        {
+            Entry& entry = p_entries[i];
+            const uint64_t size = SIZES[(i * 7) % SIZE_COUNT];
+            const uint64_t offset = i % 8;
+            const unsigned char* input = data.data() + offset;
+            entry.useFuture = (i / PRODUCERS) % 2 == 1;
+
+            switch (static_cast<Algorithm>(i % static_cast<uint32_t>(Algorithm::Count)))
+            {
+            case Algorithm::EncryptECB:
+                entry.output.resize((size + 15) / 16 * 16);
+                entry.expected.resize(entry.output.size());
+                entry.job = Job::EncryptECB(cipher, input, entry.output.data(), size);
+                reference.EncryptECB(input, entry.expected.data(), size);
+                break;
+            case Algorithm::DecryptECB:
+                entry.output.resize((size + 15) / 16 * 16);
+                entry.expected.resize(entry.output.size());
+                entry.job = Job::DecryptECB(cipher, input, entry.output.data(), size);
+                reference.DecryptECB(input, entry.expected.data(), size);
+                break;
+            case Algorithm::SHA256:
+            {
+                entry.output.resize(Hash::SHA256::OUTPUT_SIZE);
+                entry.job = Job::SHA256(input, size, entry.output.data());
+                const auto digest = Hash::SHA256().Hash(input, size);
+                entry.expected.assign(digest.begin(), digest.end());
+                break;
+            }
+            default:
+            {
+                const uint64_t keyLength = KEY_LENGTHS[i % 3];
+                const unsigned char* macKey = data.data() + DATA_SIZE - keyLength;
+                entry.output.resize(Hash::SHA256::OUTPUT_SIZE);
+                entry.job = Job::HMACSHA256(macKey, keyLength, input, size, entry.output.data());
+                const auto mac = Hash::HMAC::HMAC_SHA256(macKey, keyLength, input, size);
+                entry.expected.assign(mac.begin(), mac.end());
+                break;
+            }
+            }
+        }
+    };
+
+    // Producer p submits entries p, p + PRODUCERS, ... half through callbacks, half through futures
+    auto submitAll = [&](JobScheduler& p_scheduler, std::vector<Entry>& p_entries, std::atomic<uint32_t>& p_callbacks,
+                         std::vector<std::future<void>>& p_futures)
+    {
+        p_futures.resize(p_entries.size());
+        std::vector<std::thread> producers;
+        for (uint32_t producer = 0; producer < PRODUCERS; ++producer)
+        {
+            producers.emplace_back([&, producer]
+            {
+                for (uint64_t i = producer; i < p_entries.size(); i += PRODUCERS)
+                {
+                    if (p_entries[i].useFuture)
+                        p_futures[i] = p_scheduler.Submit(p_entries[i].job);
+                    else
+                        p_scheduler.Submit(p_entries[i].job, [&p_callbacks] { p_callbacks.fetch_add(1, std::memory_order_relaxed); });
+                }
+            });
+        }
+        for (std::thread& producer : producers)
+            producer.join();
+    };
+
+    // Futures that never complete would hang here, so they are only waited on for a bounded time
+    auto checkWorkload = [](std::vector<Entry>& p_entries, std::atomic<uint32_t>& p_callbacks, std::vector<std::future<void>>& p_futures,
+                            uint32_t& p_matches, uint32_t& p_completions)
+    {
+        p_matches = 0;
+        p_completions = p_callbacks.load();
+        for (uint64_t i = 0; i < p_entries.size(); ++i)
+        {
+            if (p_entries[i].useFuture && p_futures[i].wait_for(std::chrono::seconds(10)) == std::future_status::ready)
+            {
+                p_futures[i].get();
+                ++p_completions;
+            }
+            p_matches += p_entries[i].output == p_entries[i].expected;
+        }
+    };
+
+    const uint32_t total = PRODUCERS * JOBS_PER_PRODUCER;
+    uint32_t failures = 0;
+
+    std::cout << "\n\n===== Job Scheduler =====\n\n";
+    std::cout << "Cross Checks:\n\n";
+
+    std::cout << "Test 1:\n\n";
+    {
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t " << std::dec << total << " AES-ECB, SHA-256 and HMAC jobs of " << SIZE_COUNT << " sizes from "
+                  << PRODUCERS << " producers, 2 workers, 50 us latency budget\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\tevery completion runs, every output equal to the single-call API\n\n";
+
+        std::vector<Entry> entries;
+        buildWorkload(entries);
+        std::atomic<uint32_t> callbacks(0);
+        std::vector<std::future<void>> futures;
+        JobScheduler scheduler(2);
+        submitAll(scheduler, entries, callbacks, futures);
+
+        // Half the jobs complete through callbacks, which run on the workers
+        for (uint32_t wait = 0; callbacks.load() < total / 2 && wait < 10000; ++wait)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        uint32_t matches;
+        uint32_t completions;
+        checkWorkload(entries, callbacks, futures, matches, completions);
+
+        const JobScheduler::Statistics statistics = scheduler.GetStatistics();
+        const bool ok = matches == total && completions == total && statistics.completed + statistics.inlineJobs == total;
+        std::cout << "\tOutput :\n\t" << completions << " completions, " << matches << " outputs match, "
+                  << statistics.batches << " batches\n" << (ok ? "\tPASS\n" : "\tFAIL\n");
+        failures += ok ? 0 : 1;
+    }
+
+    std::cout << "\n\t------------------------------\n";
+
+    std::cout << "\nTest 2:\n\n";
+    {
+        std::cout << "\tInputs :\n";
+        std::cout << "\t\t The same workload with a 10 s latency budget, the scheduler destroyed right after submission\n\n";
+        std::cout << "\tExpected Output :\n";
+        std::cout << "\tpartial batches flushed at shutdown, every completion runs, every output equal to the single-call API\n\n";
+
+        std::vector<Entry> entries;
+        buildWorkload(entries);
+        std::atomic<uint32_t> callbacks(0);
+        std::vector<std::future<void>> futures;
+        {
+            JobScheduler scheduler(2, std::chrono::seconds(10));
+            submitAll(scheduler, entries, callbacks, futures);
+        }
+
+        uint32_t matches;
+        uint32_t completions;
+        checkWorkload(entries, callbacks, futures, matches, completions);
+        const bool ok = matches == total && completions == total;
+        std::cout << "\tOutput :\n\t" << completions << " completions, " << matches << " outputs match\n"
+                  << (ok ? "\tPASS\n" : "\tFAIL\n");
+        failures += ok ? 0 : 1;
+    }
+
+    return failures;
+}
+
+uint32_t CombinedUsageExample()
 {
     using namespace KeyExchange;
     std::cout << "\n\n===== Diffie Hellman Key Exchange =====\n\n";
-    NGMP<PRIVATE_KEY_SIZE>   private1;
-    NGMP<PUBLIC_KEY_SIZE>    public1;
+    PrivateKey  private1;
+    PublicKey   public1;
     
-    NGMP<PRIVATE_KEY_SIZE>   private2;
-    NGMP<PUBLIC_KEY_SIZE>    public2;
+    PrivateKey  private2;
+    PublicKey   public2;
 
     DiffieHellman::GenerateKeyPair(private1, public1);
     std::cout << "Client1 Private Key: \n" << private1 << "\n\n";
@@ -547,77 +1555,138 @@ void CombinedUsageExample()
 
     std::cout << "Send Public Keys over some network\n\n";
 
-    auto shared1 = DiffieHellman::GenerateSharedKey(public2, private1);
+    const uint32_t keySize = DiffieHellmanGroup::GetDefault().GetByteCount();
+    // Wire and message buffers come from the thread's arena and are wiped when the example returns
+    Utils::SecureArena& arena = Utils::SecureArena::GetThreadInstance();
+    const Utils::SecureArena::Scope scope(arena);
+    uint8_t* wire1 = arena.Allocate<uint8_t>(keySize);
+    uint8_t* wire2 = arena.Allocate<uint8_t>(keySize);
+    DiffieHellman::EncodeKey(public1, wire1);
+    DiffieHellman::EncodeKey(public2, wire2);
+
+    PublicKey received1;
+    PublicKey received2;
+    if (!DiffieHellman::DecodePublicKey(wire2, received2) || !DiffieHellman::DecodePublicKey(wire1, received1))
+    {
+        std::cout << "\nInvalid public key\n";
+        return 1;
+    }
+
+    auto shared1 = DiffieHellman::GenerateSharedKey(received2, private1);
     std::cout << "Client1 Shared Secret: \n" << shared1 << "\n\n";
-    auto shared2 = DiffieHellman::GenerateSharedKey(public1, private2);
+    auto shared2 = DiffieHellman::GenerateSharedKey(received1, private2);
     std::cout << "Client2 Shared Secret: \n" << shared2 << "\n\n";
 
     std::cout << "Hash shared secret for an encryption key\n";
-    auto hashedSecret1 = Hash::SHA256().Hash(reinterpret_cast<unsigned char*>(shared1.Get64BitArray()), PUBLIC_KEY_SIZE / 8);
+    uint8_t* secret = arena.Allocate<uint8_t>(keySize);
+    DiffieHellman::EncodeKey(shared1, secret);
+    auto hashedSecret1 = Hash::SHA256().Hash(secret, keySize);
     std::cout << "\nClient1 Hashed Secret:\n";
     PrintByteArray(hashedSecret1.data(), Hash::SHA256::OUTPUT_SIZE);
 
-    auto hashedSecret2 = Hash::SHA256().Hash(reinterpret_cast<unsigned char*>(shared2.Get64BitArray()), PUBLIC_KEY_SIZE / 8);
+    DiffieHellman::EncodeKey(shared2, secret);
+    auto hashedSecret2 = Hash::SHA256().Hash(secret, keySize);
     std::cout << "\nClient2 Hashed Secret:\n";
     PrintByteArray(hashedSecret2.data(), Hash::SHA256::OUTPUT_SIZE);
     
-    std::cout << "\nEncrypt message with hashed secret\n";
-
-    unsigned char client1data[128] = "Some data from client1 which will be sent over some network once encrypted and marked with and HMAC";
-    std::cout << "Message: " << client1data << "\n";
-    Encryption::AES client1AES(hashedSecret1.data());
-    client1AES.EncryptECB(client1data, client1data, 99);
-
-    const uint32_t messageLength = (99 / 16 + 1) * 16;
-    std::cout << "\nEncrypted Message: \n";
-    PrintByteArray(client1data, messageLength);
+    std::cout << "\nDerive separate encryption and MAC keys from the hashed secret\n";
+    const char* ENCRYPTION_LABEL = "encryption";
+    const char* AUTHENTICATION_LABEL = "authentication";
+    auto encryptionKey1 = Hash::HMAC::HMAC_SHA256(hashedSecret1.data(), Hash::SHA256::OUTPUT_SIZE,
+                                                  reinterpret_cast<const uint8_t*>(ENCRYPTION_LABEL), strlen(ENCRYPTION_LABEL));
+    auto macKey1 = Hash::HMAC::HMAC_SHA256(hashedSecret1.data(), Hash::SHA256::OUTPUT_SIZE,
+                                           reinterpret_cast<const uint8_t*>(AUTHENTICATION_LABEL), strlen(AUTHENTICATION_LABEL));
+    auto encryptionKey2 = Hash::HMAC::HMAC_SHA256(hashedSecret2.data(), Hash::SHA256::OUTPUT_SIZE,
+                                                  reinterpret_cast<const uint8_t*>(ENCRYPTION_LABEL), strlen(ENCRYPTION_LABEL));
+    auto macKey2 = Hash::HMAC::HMAC_SHA256(hashedSecret2.data(), Hash::SHA256::OUTPUT_SIZE,
+                                           reinterpret_cast<const uint8_t*>(AUTHENTICATION_LABEL), strlen(AUTHENTICATION_LABEL));
+    Encryption::EncryptThenMAC client1Channel(encryptionKey1.data(), macKey1.data());
+    Encryption::EncryptThenMAC client2Channel(encryptionKey2.data(), macKey2.data());
+
+    std::cout << "\nSeal message: encrypt, then append the HMAC of header, nonce and ciphertext\n";
+
+    const char message[] = "Some data from client1 which will be sent over some network once encrypted and marked with an HMAC";
+    std::cout << "Message: " << message << "\n";
+
+    // The terminator is sealed too, so the receiver can print the message as is
+    const uint64_t messageLength = sizeof(message);
+    uint8_t* frame = arena.Allocate<uint8_t>(Encryption::EncryptThenMAC::GetFrameSize(messageLength));
+    const uint64_t frameLength = client1Channel.Seal(frame, reinterpret_cast<const uint8_t*>(message), messageLength);
+
+    std::cout << "\nFrame:\n";
+    PrintByteArray(frame, static_cast<uint32_t>(frameLength));
+
+    std::cout << "\nSend frame to client2\n";
+
+    std::cout << "\nClient2 checks the tag and decrypts\n";
+    uint8_t* client2Message = arena.Allocate<uint8_t>(Encryption::EncryptThenMAC::GetPlaintextSize(frameLength));
+    if(!client2Channel.Open(client2Message, frame, frameLength))
+    {
+        std::cout << "\nInvalid frame\n";
+        return 1;
+    }
+    std::cout << "\nTag is valid!\n\n";
 
-    std::cout << "\nCompute HMAC for the message\n";
-    auto hmac = Hash::HMAC::HMAC_SHA256(hashedSecret1.data(), Hash::SHA256::OUTPUT_SIZE, client1data, messageLength);
-    std::cout << "\nHMAC:\n";
-    PrintByteArray(hmac.data(), static_cast<uint32_t>(hmac.size()));
+    std::cout << "Decrypted Message:\n";
+    std::cout << client2Message;
 
-    std::cout << "\nAppend HMAC\n";
+    return strcmp(reinterpret_cast<const char*>(client2Message), message) == 0 ? 0 : 1;
+}
 
-    std::vector<uint8_t> completeMessage;
-    completeMessage.resize(messageLength + Hash::SHA256::OUTPUT_SIZE, 0);
-    memcpy(&completeMessage[0], client1data, messageLength);
-    memcpy(&completeMessage[0] + messageLength, hmac.data(), hmac.size());
+#if !defined(_WIN32)
+// The child of a fork must not repeat what the parent's thread generator serves next
+uint32_t CtrDrbg_ForkTest()
+{
+    std::cout << "\n\n===== CTR_DRBG after fork =====\n\n";
 
-    std::cout << "\nComplete message :\n";
-    PrintByteArray(completeMessage.data(), static_cast<uint32_t>(completeMessage.size()));
-    
-    std::cout << "\nSend complete message to client2\n";
+    // Leaves keystream in the buffer that the child inherits
+    uint8_t warmup[16];
+    Random::CtrDrbg::Fill(warmup, sizeof(warmup));
 
+    int pipeEnds[2];
+    if (pipe(pipeEnds) != 0)
+        return 1;
 
-    std::vector<uint8_t> client2Message;
-    client2Message.resize(completeMessage.size() - Hash::SHA256::OUTPUT_SIZE, 0);
-    std::array<uint8_t, Hash::SHA256::OUTPUT_SIZE> receivedHMAC{};
-    memcpy(&client2Message[0], completeMessage.data(), client2Message.size());
-    memcpy(&receivedHMAC[0], completeMessage.data() + client2Message.size(), Hash::SHA256::OUTPUT_SIZE);
+    std::cout.flush();
+    const pid_t child = fork();
+    if (child < 0)
+        return 1;
 
-    std::cout << "\nClient2 received message\n";
-    PrintByteArray(&client2Message[0], static_cast<uint32_t>(client2Message.size()));
-    
-    std::cout << "\nClient2 received HMAC\n";
-    PrintByteArray(&receivedHMAC[0], static_cast<uint32_t>(receivedHMAC.size()));
+    const uint32_t SIZE = 32;
+    if (child == 0)
+    {
+        uint8_t childBytes[SIZE];
+        Random::CtrDrbg::Fill(childBytes, SIZE);
+        const bool written = write(pipeEnds[1], childBytes, SIZE) == static_cast<ssize_t>(SIZE);
+        _exit(written ? 0 : 1);
+    }
+    close(pipeEnds[1]);
 
-    std::cout << "\nClient2 checks HMAC\n";
-    auto client2HMAC = Hash::HMAC::HMAC_SHA256(hashedSecret2.data(), Hash::SHA256::OUTPUT_SIZE, &client2Message[0], client2Message.size());
-    std::cout << "\nClient 2 computed HMAC:\n";
-    PrintByteArray(client2HMAC.data(), static_cast<uint32_t>(client2HMAC.size()));
+    uint8_t parentBytes[SIZE];
+    Random::CtrDrbg::Fill(parentBytes, SIZE);
 
-    if(memcmp(client2HMAC.data(), receivedHMAC.data(), Hash::SHA256::OUTPUT_SIZE) != 0)
+    uint8_t childBytes[SIZE];
+    uint32_t received = 0;
+    while (received < SIZE)
     {
-        std::cout << "\nInvalid HMAC\n";
-        return;
+        const ssize_t count = read(pipeEnds[0], childBytes + received, SIZE - received);
+        if (count <= 0)
+            break;
+        received += static_cast<uint32_t>(count);
     }
-    std::cout << "\nHMAC is valid!\n\n";
-    Encryption::AES client2AES(hashedSecret2.data());
+    close(pipeEnds[0]);
 
-    client2AES.DecryptECB(client2Message.data(), client2Message.data(), client2Message.size());
+    int status = 0;
+    waitpid(child, &status, 0);
 
-    std::cout << "Decrypted Message:\n";
-    std::cout << client2Message.data();
+    std::cout << "Parent:\n";
+    PrintByteArray(parentBytes, SIZE);
+    std::cout << "Child:\n";
+    PrintByteArray(childBytes, received);
 
+    const bool distinct = received == SIZE && WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+                          memcmp(parentBytes, childBytes, SIZE) != 0;
+    std::cout << (distinct ? "\tPASS\n" : "\tFAIL\n");
+    return distinct ? 0 : 1;
 }
+#endif